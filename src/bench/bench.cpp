@@ -6,35 +6,320 @@
 
 #include "perf.h"
 
+#include <univalue.h>
+
+#include <algorithm>
 #include <assert.h>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 benchmark::BenchRunner::BenchmarkMap &benchmark::BenchRunner::benchmarks() {
-    static std::map<std::string, benchmark::BenchFunction> benchmarks_map;
+    static BenchmarkMap benchmarks_map;
     return benchmarks_map;
 }
 
-benchmark::BenchRunner::BenchRunner(std::string name, benchmark::BenchFunction func)
+benchmark::BenchRunner::BenchRunner(std::string name, benchmark::BenchFunction func, bool fThreads)
+{
+    benchmarks().emplace(name, Bench{func, fThreads});
+}
+
+namespace {
+
+/** Evaluations needed on both sides of a comparison for its interquartile ranges to be compared */
+static const size_t MIN_SIGNIFICANCE_EVALS = 3;
+
+/** Results of all the evaluations of a benchmark */
+struct Summary {
+    std::string name;
+    std::vector<benchmark::Result> evals;
+    uint64_t count{0};          // iterations, summed over the evaluations
+    int64_t min_ns{0};
+    int64_t max_ns{0};
+    int64_t average_ns{0};      // mean of the evaluations averages
+    int64_t median_ns{0};       // median of the evaluations averages
+    int64_t q1_ns{0};
+    int64_t q3_ns{0};
+    uint64_t min_cycles{0};
+    uint64_t max_cycles{0};
+    uint64_t average_cycles{0};
+};
+
+/** p-th quantile (linear interpolation) of a sorted, non-empty vector */
+static int64_t Quantile(const std::vector<int64_t>& sorted, double p)
 {
-    benchmarks().emplace(name, func);
+    const double pos = p * (sorted.size() - 1);
+    const size_t lo = (size_t)pos;
+    const size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (int64_t)((pos - lo) * (sorted[hi] - sorted[lo]));
 }
 
-void
-benchmark::BenchRunner::RunAll(benchmark::duration elapsedTimeForOne)
+static Summary Summarize(const std::string& name, const std::vector<benchmark::Result>& evals)
+{
+    assert(!evals.empty());
+    Summary s;
+    s.name = name;
+    s.evals = evals;
+    s.min_ns = std::numeric_limits<int64_t>::max();
+    s.min_cycles = std::numeric_limits<uint64_t>::max();
+    std::vector<int64_t> averages;
+    for (const benchmark::Result& r : evals) {
+        s.count += r.count;
+        s.min_ns = std::min(s.min_ns, r.min_ns);
+        s.max_ns = std::max(s.max_ns, r.max_ns);
+        s.average_ns += r.average_ns;
+        s.min_cycles = std::min(s.min_cycles, r.min_cycles);
+        s.max_cycles = std::max(s.max_cycles, r.max_cycles);
+        s.average_cycles += r.average_cycles;
+        averages.push_back(r.average_ns);
+    }
+    s.average_ns /= (int64_t)evals.size();
+    s.average_cycles /= evals.size();
+    std::sort(averages.begin(), averages.end());
+    s.median_ns = Quantile(averages, 0.5);
+    s.q1_ns = Quantile(averages, 0.25);
+    s.q3_ns = Quantile(averages, 0.75);
+    return s;
+}
+
+static std::string CsvHeader()
+{
+    return "#Benchmark,count,min(ns),max(ns),average(ns),min_cycles,max_cycles,average_cycles,evals,median(ns),q1(ns),q3(ns)";
+}
+
+static std::string CsvLine(const Summary& s)
+{
+    std::ostringstream ss;
+    ss << s.name << "," << s.count << "," << s.min_ns << "," << s.max_ns << "," << s.average_ns << ","
+       << s.min_cycles << "," << s.max_cycles << "," << s.average_cycles << ","
+       << s.evals.size() << "," << s.median_ns << "," << s.q1_ns << "," << s.q3_ns;
+    return ss.str();
+}
+
+static UniValue ToJson(const Summary& s)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("name", s.name);
+    obj.pushKV("count", (int64_t)s.count);
+    obj.pushKV("min_ns", s.min_ns);
+    obj.pushKV("max_ns", s.max_ns);
+    obj.pushKV("average_ns", s.average_ns);
+    obj.pushKV("median_ns", s.median_ns);
+    obj.pushKV("q1_ns", s.q1_ns);
+    obj.pushKV("q3_ns", s.q3_ns);
+    obj.pushKV("min_cycles", (int64_t)s.min_cycles);
+    obj.pushKV("max_cycles", (int64_t)s.max_cycles);
+    obj.pushKV("average_cycles", (int64_t)s.average_cycles);
+    UniValue samples(UniValue::VARR);
+    for (const benchmark::Result& r : s.evals) {
+        samples.push_back(r.average_ns);
+    }
+    obj.pushKV("samples_ns", samples);
+    return obj;
+}
+
+static bool WriteFile(const std::string& path, const std::string& content)
+{
+    std::ofstream file(path);
+    file << content;
+    if (!file.good()) {
+        std::cerr << "Error writing " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+/** Read a file written with -output_json, indexed by benchmark name */
+static bool ReadBaseline(const std::string& path, std::map<std::string, UniValue>& baselineRet)
+{
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    UniValue json;
+    if (!file.good() || !json.read(content.str()) || !json["benchmarks"].isArray()) {
+        std::cerr << "Error reading the baseline " << path << "\n";
+        return false;
+    }
+    for (const UniValue& b : json["benchmarks"].getValues()) {
+        // Every entry is checked here, so that CompareWithBaseline can't throw
+        try {
+            b["median_ns"].get_int64();
+            b["q1_ns"].get_int64();
+            b["q3_ns"].get_int64();
+            b["samples_ns"].get_array();
+            baselineRet.emplace(b["name"].get_str(), b);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Error reading the baseline " << path << ": malformed entry " << b.write() << " (" << e.what() << ")\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * A benchmark regressed if its median got slower than the baseline median by more than
+ * dThreshold percent, and the interquartile ranges of the two runs don't overlap (so that
+ * the difference is not within the noise of either run).
+ * The interquartile ranges are only compared if both runs have MIN_SIGNIFICANCE_EVALS
+ * evaluations: with fewer, the quartiles are the median, and only the threshold applies.
+ */
+static bool CompareWithBaseline(const Summary& s, const UniValue& b, double dThreshold)
+{
+    const int64_t base_median = b["median_ns"].get_int64();
+    const int64_t base_q1 = b["q1_ns"].get_int64();
+    const int64_t base_q3 = b["q3_ns"].get_int64();
+    const bool fSignificance = s.evals.size() >= MIN_SIGNIFICANCE_EVALS && b["samples_ns"].size() >= MIN_SIGNIFICANCE_EVALS;
+    const double change = base_median > 0 ? 100.0 * (s.median_ns - base_median) / base_median : 0;
+    const bool fRegression = change > dThreshold && (!fSignificance || s.q1_ns > base_q3);
+    const bool fImprovement = change < -dThreshold && (!fSignificance || s.q3_ns < base_q1);
+    std::cout << "# compare " << s.name << ": baseline_median(ns)=" << base_median << " median(ns)=" << s.median_ns
+              << " change=" << std::showpos << std::fixed << std::setprecision(1) << change << "%" << std::noshowpos
+              << (fRegression ? " REGRESSION" : (fImprovement ? " improvement" : ""))
+              << (fSignificance ? "" : " (no significance test, fewer than 3 evaluations: see -evals)") << "\n";
+    std::cout.copyfmt(std::ios(nullptr));
+    return fRegression;
+}
+
+/**
+ * Pinning of the main thread to a CPU (-cpu). The threads created by a benchmark inherit
+ * the affinity of the main thread: the benchmarks running threads of their own are run
+ * with the original affinity, so that their threads aren't serialized on a single CPU.
+ */
+class MainThreadPinning
+{
+#ifdef __linux__
+    cpu_set_t cpusetOrig;
+    cpu_set_t cpusetPinned;
+#endif
+    bool fEnabled{false};
+
+public:
+    explicit MainThreadPinning(int nCpu)
+    {
+        if (nCpu < 0) return;
+#ifdef __linux__
+        CPU_ZERO(&cpusetPinned);
+        CPU_SET(nCpu, &cpusetPinned);
+        fEnabled = pthread_getaffinity_np(pthread_self(), sizeof(cpusetOrig), &cpusetOrig) == 0 &&
+                   pthread_setaffinity_np(pthread_self(), sizeof(cpusetPinned), &cpusetPinned) == 0;
+        if (!fEnabled) {
+            std::cerr << "WARNING: unable to pin the main thread to CPU " << nCpu << "\n";
+        }
+#else
+        std::cerr << "WARNING: CPU pinning is not supported on this platform\n";
+#endif
+    }
+
+    ~MainThreadPinning() { Set(false); }
+
+    bool IsEnabled() const { return fEnabled; }
+
+    /** Pin the main thread, or restore its original affinity */
+    void Set(bool fPinned)
+    {
+#ifdef __linux__
+        if (fEnabled) {
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), fPinned ? &cpusetPinned : &cpusetOrig);
+        }
+#endif
+    }
+};
+
+} // namespace
+
+int
+benchmark::BenchRunner::RunAll(const benchmark::Options& opts)
 {
+    std::regex reFilter;
+    try {
+        reFilter = std::regex(opts.filter);
+    } catch (const std::regex_error& e) {
+        std::cerr << "Invalid -filter regex " << opts.filter << ": " << e.what() << "\n";
+        return -1;
+    }
+
+    if (opts.fList) {
+        for (const auto& p : benchmarks()) {
+            if (std::regex_match(p.first, reFilter)) std::cout << p.first << "\n";
+        }
+        return 0;
+    }
+
+    std::map<std::string, UniValue> baseline;
+    if (!opts.strCompare.empty() && !ReadBaseline(opts.strCompare, baseline)) {
+        return -1;
+    }
+    MainThreadPinning pinning(opts.nCpu);
+
     perf_init();
     if (std::ratio_less_equal<benchmark::clock::period, std::micro>::value) {
         std::cerr << "WARNING: Clock precision is worse than microsecond - benchmarks may be less accurate!\n";
     }
-    std::cout << "#Benchmark" << "," << "count" << "," << "min(ns)" << "," << "max(ns)" << "," << "average(ns)" << ","
-              << "min_cycles" << "," << "max_cycles" << "," << "average_cycles" << "\n";
+    std::cout << CsvHeader() << "\n";
 
+    std::vector<Summary> summaries;
+    int nFailed = 0;
     for (const auto &p: benchmarks()) {
-        State state(p.first, elapsedTimeForOne);
-        p.second(state);
+        if (!std::regex_match(p.first, reFilter)) continue;
+        pinning.Set(!p.second.fThreads);
+        if (pinning.IsEnabled() && p.second.fThreads) {
+            std::cout << "# " << p.first << " runs threads of its own: not pinned\n";
+        }
+
+        std::vector<Result> evals;
+        for (int i = 0; i < opts.nWarmup + opts.nEvals; i++) {
+            State state(p.first, opts.elapsedTimeForOne, opts.nIterations);
+            p.second.func(state);
+            if (!state.GetError().empty()) {
+                std::cerr << "ERROR: " << p.first << " failed: " << state.GetError() << "\n";
+                evals.clear();
+                nFailed++;
+                break;
+            }
+            if (state.GetResult().count == 0) break; // skipped
+            if (i >= opts.nWarmup) evals.push_back(state.GetResult());
+        }
+        if (evals.empty()) continue;
+
+        summaries.emplace_back(Summarize(p.first, evals));
+        std::cout << CsvLine(summaries.back()) << "\n";
     }
     perf_fini();
+
+    int nRegressions = 0;
+    for (const Summary& s : summaries) {
+        auto it = baseline.find(s.name);
+        if (it != baseline.end() && CompareWithBaseline(s, it->second, opts.dThreshold)) {
+            nRegressions++;
+        }
+    }
+
+    if (!opts.strOutputCsv.empty()) {
+        std::string content = CsvHeader() + "\n";
+        for (const Summary& s : summaries) {
+            content += CsvLine(s) + "\n";
+        }
+        if (!WriteFile(opts.strOutputCsv, content)) return -1;
+    }
+    if (!opts.strOutputJson.empty()) {
+        UniValue results(UniValue::VARR);
+        for (const Summary& s : summaries) {
+            results.push_back(ToJson(s));
+        }
+        UniValue json(UniValue::VOBJ);
+        json.pushKV("evals", opts.nEvals);
+        json.pushKV("benchmarks", results);
+        if (!WriteFile(opts.strOutputJson, json.write(4) + "\n")) return -1;
+    }
+    return nFailed > 0 ? -1 : nRegressions;
 }
 
 bool benchmark::State::KeepRunning()
@@ -48,21 +333,24 @@ bool benchmark::State::KeepRunning()
     if (count == 0) {
         beginTime = now = clock::now();
         lastCycles = beginCycles = nowCycles = perf_cpucycles();
+        pausedTime = totalPausedTime = duration::zero();
+        pausedCycles = totalPausedCycles = 0;
     }
     else {
         now = clock::now();
-        auto elapsed = now - lastTime;
+        auto elapsed = now - lastTime - pausedTime;
         auto elapsedOne = elapsed / (countMask + 1);
         if (elapsedOne < minTime) minTime = elapsedOne;
         if (elapsedOne > maxTime) maxTime = elapsedOne;
 
         // We only use relative values, so don't have to handle 64-bit wrap-around specially
         nowCycles = perf_cpucycles();
-        uint64_t elapsedOneCycles = (nowCycles - lastCycles) / (countMask + 1);
+        uint64_t elapsedOneCycles = (nowCycles - lastCycles - pausedCycles) / (countMask + 1);
         if (elapsedOneCycles < minCycles) minCycles = elapsedOneCycles;
         if (elapsedOneCycles > maxCycles) maxCycles = elapsedOneCycles;
 
-        if (elapsed*128 < maxElapsed) {
+        // With a fixed number of iterations every iteration is timed
+        if (nIterations == 0 && elapsed*128 < maxElapsed) {
           // If the execution was much too fast (1/128th of maxElapsed), increase the count mask by 8x and restart timing.
           // The restart avoids including the overhead of this code in the measurement.
           countMask = ((countMask<<3)|7) & ((1LL<<60)-1);
@@ -73,7 +361,7 @@ bool benchmark::State::KeepRunning()
           maxCycles = std::numeric_limits<uint64_t>::min();
           return true;
         }
-        if (elapsed*16 < maxElapsed) {
+        if (nIterations == 0 && elapsed*16 < maxElapsed) {
             uint64_t newCountMask = ((countMask<<1)|1) & ((1LL<<60)-1);
             if ((count & newCountMask)==0) {
                 countMask = newCountMask;
@@ -82,24 +370,40 @@ bool benchmark::State::KeepRunning()
     }
     lastTime = now;
     lastCycles = nowCycles;
+    totalPausedTime += pausedTime;
+    totalPausedCycles += pausedCycles;
+    pausedTime = duration::zero();
+    pausedCycles = 0;
     ++count;
 
-    if (now - beginTime < maxElapsed) return true; // Keep going
+    if (nIterations > 0 ? count <= nIterations : now - beginTime - totalPausedTime < maxElapsed) return true; // Keep going
 
     --count;
 
     assert(count != 0 && "count == 0 => (now == 0 && beginTime == 0) => return above");
 
-    // Output results
+    // Store results
     // Duration casts are only necessary here because hardware with sub-nanosecond clocks
     // will lose precision.
-    int64_t min_elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(minTime).count();
-    int64_t max_elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(maxTime).count();
-    int64_t avg_elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>((now-beginTime)/count).count();
-    int64_t averageCycles = (nowCycles-beginCycles)/count;
-    std::cout << std::fixed << std::setprecision(15) << name << "," << count << "," << min_elapsed << "," << max_elapsed << "," << avg_elapsed << ","
-              << minCycles << "," << maxCycles << "," << averageCycles << "\n";
-    std::cout.copyfmt(std::ios(nullptr));
+    result.count = count;
+    result.min_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(minTime).count();
+    result.max_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(maxTime).count();
+    result.average_ns = std::chrono::duration_cast<std::chrono::nanoseconds>((now-beginTime-totalPausedTime)/count).count();
+    result.min_cycles = minCycles;
+    result.max_cycles = maxCycles;
+    result.average_cycles = (nowCycles-beginCycles-totalPausedCycles)/count;
 
     return false;
 }
+
+void benchmark::State::PauseTiming()
+{
+    pauseTime = clock::now();
+    pauseCycles = perf_cpucycles();
+}
+
+void benchmark::State::ResumeTiming()
+{
+    pausedTime += clock::now() - pauseTime;
+    pausedCycles += perf_cpucycles() - pauseCycles;
+}
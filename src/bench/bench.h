@@ -10,6 +10,7 @@
 #include <limits>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <boost/preprocessor/cat.hpp>
 #include <boost/preprocessor/stringize.hpp>
@@ -46,6 +47,17 @@ namespace benchmark {
     using time_point = clock::time_point;
     using duration = clock::duration;
 
+    /** Timings of one evaluation of a benchmark */
+    struct Result {
+        uint64_t count{0};
+        int64_t min_ns{0};
+        int64_t max_ns{0};
+        int64_t average_ns{0};
+        uint64_t min_cycles{0};
+        uint64_t max_cycles{0};
+        uint64_t average_cycles{0};
+    };
+
     class State {
         std::string name;
         duration maxElapsed;
@@ -57,33 +69,70 @@ namespace benchmark {
         uint64_t lastCycles;
         uint64_t minCycles;
         uint64_t maxCycles;
+        uint64_t nIterations;
+        // Untimed parts of the iterations (PauseTiming/ResumeTiming)
+        time_point pauseTime;
+        uint64_t pauseCycles{0};
+        duration pausedTime{duration::zero()}, totalPausedTime{duration::zero()};
+        uint64_t pausedCycles{0}, totalPausedCycles{0};
+        Result result;
+        std::string error;
     public:
-        State(std::string _name, duration _maxElapsed) :
+        // Run for _maxElapsed, or exactly _nIterations times if non-zero
+        State(std::string _name, duration _maxElapsed, uint64_t _nIterations = 0) :
             name(_name),
             maxElapsed(_maxElapsed),
             minTime(duration::max()),
             maxTime(duration::zero()),
             count(0),
-            countMask(1),
+            countMask(_nIterations > 0 ? 0 : 1),
             beginCycles(0),
             lastCycles(0),
             minCycles(std::numeric_limits<uint64_t>::max()),
-            maxCycles(std::numeric_limits<uint64_t>::min()) {
+            maxCycles(std::numeric_limits<uint64_t>::min()),
+            nIterations(_nIterations) {
         }
         bool KeepRunning();
+        /** Exclude the code run until ResumeTiming (e.g. the setup of the next iteration) from the timings */
+        void PauseTiming();
+        void ResumeTiming();
+        /** Mark the benchmark as failed (e.g. its setup could not be completed), its timings are discarded */
+        void SkipWithError(const std::string& strError) { error = strError; }
+        /** Timings, valid once KeepRunning returned false (count is 0 if the benchmark was skipped) */
+        const Result& GetResult() const { return result; }
+        const std::string& GetError() const { return error; }
     };
 
     typedef std::function<void(State&)> BenchFunction;
 
+    struct Options {
+        std::string filter{".*"};                               // regex matched against the benchmark names
+        duration elapsedTimeForOne{std::chrono::seconds(1)};    // duration of each evaluation
+        uint64_t nIterations{0};                                // fixed iterations per evaluation (0: time based)
+        int nWarmup{0};                                         // discarded evaluations
+        int nEvals{1};                                          // evaluations reported (median/IQR)
+        int nCpu{-1};                                           // pin the main thread to this CPU (-1: don't)
+        bool fList{false};                                      // only list the benchmark names
+        std::string strOutputCsv;                               // also write the results here (CSV)
+        std::string strOutputJson;                              // also write the results here (JSON)
+        std::string strCompare;                                 // JSON results to compare with
+        double dThreshold{5.0};                                 // regression threshold (% of the baseline median)
+    };
+
     class BenchRunner
     {
-        typedef std::map<std::string, BenchFunction> BenchmarkMap;
+        struct Bench {
+            BenchFunction func;
+            bool fThreads;      // runs threads of its own (not pinned to -cpu)
+        };
+        typedef std::map<std::string, Bench> BenchmarkMap;
         static BenchmarkMap &benchmarks();
 
     public:
-        BenchRunner(std::string name, BenchFunction func);
+        BenchRunner(std::string name, BenchFunction func, bool fThreads = false);
 
-        static void RunAll(duration elapsedTimeForOne = std::chrono::seconds(1));
+        /** Run the benchmarks selected by opts. Returns the number of regressions found against opts.strCompare (-1 on error, or if any benchmark failed) */
+        static int RunAll(const Options& opts);
     };
 }
 
@@ -91,4 +140,9 @@ namespace benchmark {
 #define BENCHMARK(n) \
     benchmark::BenchRunner BOOST_PP_CAT(bench_, BOOST_PP_CAT(__LINE__, n))(BOOST_PP_STRINGIZE(n), n);
 
+// BENCHMARK_THREADS(foo): same, for a benchmark running threads of its own (e.g. script check workers),
+// which must not be pinned to a single CPU with the main thread
+#define BENCHMARK_THREADS(n) \
+    benchmark::BenchRunner BOOST_PP_CAT(bench_, BOOST_PP_CAT(__LINE__, n))(BOOST_PP_STRINGIZE(n), n, true);
+
 #endif // BITCOIN_BENCH_BENCH_H
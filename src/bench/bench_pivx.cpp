@@ -7,15 +7,75 @@
 
 #include "key.h"
 #include "util/system.h"
+#include "utilstrencodings.h"
+
+#include <iostream>
+
+static const int64_t DEFAULT_BENCH_TIME_MS = 1000;
+static const int64_t DEFAULT_BENCH_EVALS = 1;
+static const int64_t DEFAULT_BENCH_STABLE_EVALS = 5;
+static const int64_t DEFAULT_BENCH_STABLE_WARMUP = 1;
+static const char* DEFAULT_BENCH_THRESHOLD = "5.0";
+static const char* DEFAULT_BENCH_FILTER = ".*";
+
+static std::string HelpMessage()
+{
+    std::string strUsage = HelpMessageGroup("Options:");
+    strUsage += HelpMessageOpt("-?", "Print this help message and exit");
+    strUsage += HelpMessageOpt("-list", "List the benchmarks (matching -filter) without running them");
+    strUsage += HelpMessageOpt("-filter=<regex>", strprintf("Regular expression filter selecting the benchmarks to run (default: %s)", DEFAULT_BENCH_FILTER));
+    strUsage += HelpMessageOpt("-time=<n>", strprintf("Duration of each evaluation of a benchmark, in milliseconds (default: %u)", DEFAULT_BENCH_TIME_MS));
+    strUsage += HelpMessageOpt("-iterations=<n>", "Run exactly <n> iterations per evaluation, instead of a fixed duration");
+    strUsage += HelpMessageOpt("-evals=<n>", strprintf("Number of evaluations of each benchmark, reported as median and interquartile range (default: %u)", DEFAULT_BENCH_EVALS));
+    strUsage += HelpMessageOpt("-warmup=<n>", "Number of discarded evaluations run before the reported ones (default: 0)");
+    strUsage += HelpMessageOpt("-cpu=<n>", "Pin the main thread to CPU <n>, except for the benchmarks running threads of their own");
+    strUsage += HelpMessageOpt("-stable", strprintf("Stable timings: pin the main thread (to -cpu, default 0) and, unless set, use -evals=%u -warmup=%u",
+                                                    DEFAULT_BENCH_STABLE_EVALS, DEFAULT_BENCH_STABLE_WARMUP));
+    strUsage += HelpMessageOpt("-output_csv=<file>", "Also write the results to <file>, as CSV");
+    strUsage += HelpMessageOpt("-output_json=<file>", "Also write the results to <file>, as JSON (usable with -compare)");
+    strUsage += HelpMessageOpt("-compare=<file>", "Compare the results with a baseline written by -output_json. Exits with an error if any benchmark regressed");
+    strUsage += HelpMessageOpt("-threshold=<n>", strprintf("Slowdown of the median, in percent, above which a benchmark regressed (if the interquartile ranges don't overlap) (default: %s)", DEFAULT_BENCH_THRESHOLD));
+
+    strUsage += HelpMessageGroup("Benchmark options:");
+    strUsage += HelpMessageOpt("-p2preplayfile=<file>", "Messages replayed by P2PReplayCapture (a msgs_recv.dat file written by -capturemessages)");
+    strUsage += HelpMessageOpt("-walletbenchtxs=<n>", "Number of transactions of the synthetic wallet used by the Wallet* benchmarks (default: 10000)");
+    return strUsage;
+}
 
 int
 main(int argc, char** argv)
 {
+    gArgs.ParseParameters(argc, argv);
+    if (gArgs.IsArgSet("-?") || gArgs.IsArgSet("-h") || gArgs.IsArgSet("-help")) {
+        std::cout << "Usage: bench_pivx [options]\n\n" << HelpMessage();
+        return EXIT_SUCCESS;
+    }
+
     ECC_Start();
     SetupEnvironment();
     g_logger->m_print_to_file = false; // don't want to write to debug.log file
 
-    benchmark::BenchRunner::RunAll();
+    const bool fStable = gArgs.GetBoolArg("-stable", false);
+    benchmark::Options opts;
+    opts.fList = gArgs.GetBoolArg("-list", false);
+    opts.filter = gArgs.GetArg("-filter", DEFAULT_BENCH_FILTER);
+    opts.elapsedTimeForOne = std::chrono::milliseconds(std::max<int64_t>(1, gArgs.GetArg("-time", DEFAULT_BENCH_TIME_MS)));
+    opts.nIterations = std::max<int64_t>(0, gArgs.GetArg("-iterations", 0));
+    opts.nEvals = std::max<int64_t>(1, gArgs.GetArg("-evals", fStable ? DEFAULT_BENCH_STABLE_EVALS : DEFAULT_BENCH_EVALS));
+    opts.nWarmup = std::max<int64_t>(0, gArgs.GetArg("-warmup", fStable ? DEFAULT_BENCH_STABLE_WARMUP : 0));
+    opts.nCpu = gArgs.GetArg("-cpu", fStable ? 0 : -1);
+    opts.strOutputCsv = gArgs.GetArg("-output_csv", "");
+    opts.strOutputJson = gArgs.GetArg("-output_json", "");
+    opts.strCompare = gArgs.GetArg("-compare", "");
+    const std::string strThreshold = gArgs.GetArg("-threshold", DEFAULT_BENCH_THRESHOLD);
+    if (!ParseDouble(strThreshold, &opts.dThreshold) || opts.dThreshold < 0) {
+        std::cerr << "Error: invalid -threshold=" << strThreshold << "\n";
+        ECC_Stop();
+        return EXIT_FAILURE;
+    }
+
+    const int nRegressions = benchmark::BenchRunner::RunAll(opts);
 
     ECC_Stop();
+    return nRegressions == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,436 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "bench/chain_setup.h"
+
+#include "chainparams.h"
+#include "evo/providertx.h"
+#include "evo/specialtx.h"
+#include "keystore.h"
+#include "netbase.h"
+#include "sapling/note.h"
+#include "sapling/transaction_builder.h"
+#include "script/sign.h"
+#include "script/standard.h"
+#include "spork.h"
+#include "util/system.h"
+#include "validation.h"
+
+#include <deque>
+#include <iostream>
+
+/*
+ * Chain-replay benchmarks.
+ *
+ * Each benchmark builds a deterministic regtest chain with a given mix of
+ * transactions, then measures how long it takes to replay the "payload" blocks of
+ * that chain through ProcessNewBlock (full validation, ConnectBlock and
+ * ActivateBestChain) on top of a freshly reset chainstate with an empty coins cache.
+ * Besides the standard timing line, the average per-phase timings (taken from the
+ * ConnectBlock/ConnectTip BCLog::BENCH counters) are printed for the payload blocks.
+ */
+
+namespace {
+
+struct ReplayMix {
+    int nBlocks;            // payload blocks
+    int nP2PKH;             // 2-in/2-out P2PKH transfers per block
+    int nColdStake;         // P2CS delegations (and owner spends of previous delegations) per block
+    int nShieldOutputs;     // t->z transactions per block
+    int nShieldSpends;      // z->t transactions per block
+    int nProReg;            // ProRegTx (with internal collateral) per block
+    int nMasternodes;       // masternodes registered before the payload, and paid by its coinbases
+};
+
+struct Utxo {
+    COutPoint outpoint;
+    CTxOut txout;
+    Utxo(const COutPoint& _outpoint, const CTxOut& _txout) : outpoint(_outpoint), txout(_txout) {}
+};
+
+struct ShieldedNote {
+    libzcash::SaplingNote note;
+    SaplingWitness witness;
+    ShieldedNote(const libzcash::SaplingNote& _note, const SaplingWitness& _witness) : note(_note), witness(_witness) {}
+};
+
+// Fee paid by the shielded transactions (transparent transactions pay no fee)
+static const CAmount SHIELD_FEE = COIN;
+// Number of outputs created from each coinbase to fund the transparent pool
+static const int FAN_OUT_OUTPUTS = 25;
+
+class ReplayChainBuilder
+{
+public:
+    ReplayChainBuilder(RegTestChainSetup& _setup, const ReplayMix& _mix);
+
+    /** Mine the whole chain. Returns false (with the reason on stderr) if it could not be built */
+    bool Build();
+
+    // All the blocks (prefix: premine and funding blocks, followed by the payload blocks)
+    std::vector<std::shared_ptr<const CBlock>> vPrefixBlocks;
+    std::vector<std::shared_ptr<const CBlock>> vPayloadBlocks;
+
+private:
+    RegTestChainSetup& setup;
+    const ReplayMix mix;
+    const Consensus::Params& consensus;
+
+    CBasicKeyStore keystore;
+    CKey coinbaseKey;
+    CKey ownerKey;
+    CKey stakerKey;
+    CScript coinbaseScript;
+    CScript p2pkhScript;
+    CScript p2csScript;
+    libzcash::SaplingExpandedSpendingKey saplingKey;
+    libzcash::SaplingIncomingViewingKey saplingIvk;
+    libzcash::SaplingPaymentAddress saplingAddr;
+    uint32_t nMasternodeCounter{0};
+
+    std::deque<std::pair<int, Utxo>> coinbases;     // (height, utxo)
+    std::deque<Utxo> pool;                          // spendable P2PKH outputs
+    std::deque<Utxo> coldPool;                      // spendable P2CS outputs
+    std::deque<ShieldedNote> notes;                 // spendable sapling notes
+    SaplingMerkleTree saplingTree;
+    std::vector<Utxo> pendingPool;
+    std::vector<Utxo> pendingCold;
+
+    int Height() const { return WITH_LOCK(cs_main, return chainActive.Height()); }
+    bool PopMatureCoinbase(Utxo& utxoRet);
+    bool Mine(const std::vector<CMutableTransaction>& txns, bool fPayload);
+    void Sign(CMutableTransaction& mtx, const std::vector<Utxo>& vInputs);
+
+    CMutableTransaction CreateFanOut(const Utxo& coinbase);
+    CMutableTransaction CreateTransfer(const Utxo& in1, const Utxo& in2);
+    CMutableTransaction CreateDelegation(const Utxo& in);
+    CMutableTransaction CreateOwnerSpend(const Utxo& in);
+    CMutableTransaction CreateProReg(const Utxo& coinbase);
+    CMutableTransaction CreateShield(const Utxo& in);
+    CMutableTransaction CreateUnshield(const ShieldedNote& in);
+};
+
+ReplayChainBuilder::ReplayChainBuilder(RegTestChainSetup& _setup, const ReplayMix& _mix) :
+    setup(_setup),
+    mix(_mix),
+    consensus(Params().GetConsensus())
+{
+    coinbaseKey = RegTestChainSetup::GetDeterministicKey(0);
+    ownerKey = RegTestChainSetup::GetDeterministicKey(1);
+    stakerKey = RegTestChainSetup::GetDeterministicKey(2);
+    keystore.AddKey(coinbaseKey);
+    keystore.AddKey(ownerKey);
+    coinbaseScript = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+    p2pkhScript = coinbaseScript;
+    p2csScript = GetScriptForStakeDelegation(stakerKey.GetPubKey().GetID(), ownerKey.GetPubKey().GetID());
+
+    const libzcash::SaplingSpendingKey sk(Hash(coinbaseScript.begin(), coinbaseScript.end()));
+    saplingKey = sk.expanded_spending_key();
+    saplingIvk = sk.full_viewing_key().in_viewing_key();
+    saplingAddr = sk.default_address();
+}
+
+bool ReplayChainBuilder::PopMatureCoinbase(Utxo& utxoRet)
+{
+    if (coinbases.empty() || Height() + 1 - coinbases.front().first < consensus.nCoinbaseMaturity) {
+        return false;
+    }
+    utxoRet = coinbases.front().second;
+    coinbases.pop_front();
+    return true;
+}
+
+void ReplayChainBuilder::Sign(CMutableTransaction& mtx, const std::vector<Utxo>& vInputs)
+{
+    for (size_t i = 0; i < vInputs.size(); i++) {
+        const CTxOut& prevOut = vInputs[i].txout;
+        if (!SignSignature(keystore, prevOut.scriptPubKey, mtx, i, prevOut.nValue, SIGHASH_ALL)) {
+            throw std::runtime_error("Unable to sign input");
+        }
+    }
+}
+
+CMutableTransaction ReplayChainBuilder::CreateFanOut(const Utxo& coinbase)
+{
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(coinbase.outpoint);
+    const CAmount nValue = coinbase.txout.nValue / FAN_OUT_OUTPUTS;
+    for (int i = 0; i < FAN_OUT_OUTPUTS; i++) {
+        mtx.vout.emplace_back(nValue, p2pkhScript);
+    }
+    Sign(mtx, {coinbase});
+    return mtx;
+}
+
+CMutableTransaction ReplayChainBuilder::CreateTransfer(const Utxo& in1, const Utxo& in2)
+{
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(in1.outpoint);
+    mtx.vin.emplace_back(in2.outpoint);
+    const CAmount nTotal = in1.txout.nValue + in2.txout.nValue;
+    mtx.vout.emplace_back(nTotal / 2, p2pkhScript);
+    mtx.vout.emplace_back(nTotal - nTotal / 2, p2pkhScript);
+    Sign(mtx, {in1, in2});
+    return mtx;
+}
+
+CMutableTransaction ReplayChainBuilder::CreateDelegation(const Utxo& in)
+{
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(in.outpoint);
+    mtx.vout.emplace_back(in.txout.nValue, p2csScript);
+    Sign(mtx, {in});
+    return mtx;
+}
+
+CMutableTransaction ReplayChainBuilder::CreateOwnerSpend(const Utxo& in)
+{
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(in.outpoint);
+    mtx.vout.emplace_back(in.txout.nValue, p2pkhScript);
+    Sign(mtx, {in});
+    return mtx;
+}
+
+CMutableTransaction ReplayChainBuilder::CreateProReg(const Utxo& coinbase)
+{
+    const uint32_t n = nMasternodeCounter++;
+    const CKey& mnOwnerKey = RegTestChainSetup::GetDeterministicKey(1000 + 3 * n);
+    const CKey& mnOperatorKey = RegTestChainSetup::GetDeterministicKey(1001 + 3 * n);
+    const CKey& mnPayoutKey = RegTestChainSetup::GetDeterministicKey(1002 + 3 * n);
+
+    ProRegPL pl;
+    pl.collateralOutpoint = COutPoint(UINT256_ZERO, 0);
+    pl.addr = LookupNumeric("1.1.1.1", 1 + n);
+    pl.keyIDOwner = mnOwnerKey.GetPubKey().GetID();
+    pl.keyIDOperator = mnOperatorKey.GetPubKey().GetID();
+    pl.keyIDVoting = mnOwnerKey.GetPubKey().GetID();
+    pl.scriptPayout = GetScriptForDestination(mnPayoutKey.GetPubKey().GetID());
+
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::TxVersion::SAPLING;
+    mtx.nType = CTransaction::TxType::PROREG;
+    mtx.vin.emplace_back(coinbase.outpoint);
+    mtx.vout.emplace_back(consensus.nMNCollateralAmt, pl.scriptPayout);
+    mtx.vout.emplace_back(coinbase.txout.nValue - consensus.nMNCollateralAmt, p2pkhScript);
+    pl.inputsHash = CalcTxInputsHash(mtx);
+    SetTxPayload(mtx, pl);
+    Sign(mtx, {coinbase});
+    return mtx;
+}
+
+CMutableTransaction ReplayChainBuilder::CreateShield(const Utxo& in)
+{
+    TransactionBuilder builder(consensus, Height() + 1, &keystore);
+    builder.SetFee(SHIELD_FEE);
+    builder.AddTransparentInput(in.outpoint, in.txout.scriptPubKey, in.txout.nValue);
+    builder.AddSaplingOutput(saplingKey.ovk, saplingAddr, in.txout.nValue - SHIELD_FEE);
+    return CMutableTransaction(builder.Build().GetTxOrThrow());
+}
+
+CMutableTransaction ReplayChainBuilder::CreateUnshield(const ShieldedNote& in)
+{
+    TransactionBuilder builder(consensus, Height() + 1);
+    builder.SetFee(SHIELD_FEE);
+    builder.AddSaplingSpend(saplingKey, in.note, in.witness.root(), in.witness);
+    CTxDestination dest = coinbaseKey.GetPubKey().GetID();
+    builder.AddTransparentOutput(dest, in.note.value() - SHIELD_FEE);
+    return CMutableTransaction(builder.Build().GetTxOrThrow());
+}
+
+bool ReplayChainBuilder::Mine(const std::vector<CMutableTransaction>& txns, bool fPayload)
+{
+    std::shared_ptr<const CBlock> pblock = setup.CreateAndProcessBlock(txns, coinbaseScript);
+    if (!pblock) {
+        std::cerr << "Failed to connect generated block at height " << Height() + 1 << std::endl;
+        return false;
+    }
+    (fPayload ? vPayloadBlocks : vPrefixBlocks).emplace_back(pblock);
+
+    const int nHeight = Height();
+    const CTransactionRef& coinbase = pblock->vtx[0];
+    coinbases.emplace_back(nHeight, Utxo(COutPoint(coinbase->GetHash(), 0), coinbase->vout[0]));
+
+    for (const CTransactionRef& tx : pblock->vtx) {
+        for (size_t i = 0; i < tx->vout.size(); i++) {
+            const CTxOut& out = tx->vout[i];
+            if (tx->IsCoinBase()) continue;
+            if (out.scriptPubKey == p2pkhScript) pendingPool.emplace_back(COutPoint(tx->GetHash(), i), out);
+            else if (out.scriptPubKey == p2csScript) pendingCold.emplace_back(COutPoint(tx->GetHash(), i), out);
+        }
+        if (!tx->IsShieldedTx()) continue;
+        for (const OutputDescription& od : tx->sapData->vShieldedOutput) {
+            saplingTree.append(od.cmu);
+            for (ShieldedNote& n : notes) n.witness.append(od.cmu);
+            auto pt = libzcash::SaplingNotePlaintext::decrypt(od.encCiphertext, saplingIvk, od.ephemeralKey, od.cmu);
+            if (pt) {
+                auto note = pt->note(saplingIvk);
+                if (note) notes.emplace_back(*note, saplingTree.witness());
+            }
+        }
+    }
+    pool.insert(pool.end(), pendingPool.begin(), pendingPool.end());
+    coldPool.insert(coldPool.end(), pendingCold.begin(), pendingCold.end());
+    pendingPool.clear();
+    pendingCold.clear();
+    return true;
+}
+
+bool ReplayChainBuilder::Build()
+{
+    const int nPoolNeeded = 2 * mix.nP2PKH + mix.nColdStake + mix.nShieldOutputs * mix.nBlocks + 1;
+    const int nFanOuts = (nPoolNeeded + FAN_OUT_OUTPUTS - 1) / FAN_OUT_OUTPUTS;
+    const int nPremine = consensus.nCoinbaseMaturity + nFanOuts + mix.nMasternodes + mix.nProReg * mix.nBlocks;
+    const int nTotalBlocks = nPremine + 1 + mix.nBlocks;
+
+    // Keep the whole chain PoW, with Sapling and the deterministic masternodes active
+    UpdateNetworkUpgradeParameters(Consensus::UPGRADE_POS, nTotalBlocks + 100);
+    UpdateNetworkUpgradeParameters(Consensus::UPGRADE_POS_V2, nTotalBlocks + 100);
+    UpdateNetworkUpgradeParameters(Consensus::UPGRADE_V3_4, nTotalBlocks + 101);
+    UpdateNetworkUpgradeParameters(Consensus::UPGRADE_V5_0, Consensus::NetworkUpgrade::ALWAYS_ACTIVE);
+    UpdateNetworkUpgradeParameters(Consensus::UPGRADE_V6_0, nPremine);
+
+    // Premine
+    for (int i = 0; i < nPremine; i++) {
+        if (!Mine({}, false)) return false;
+    }
+
+    // Funding block: fan out the transparent pool and register the masternodes
+    std::vector<CMutableTransaction> txns;
+    Utxo coinbase{COutPoint(), CTxOut()};
+    for (int i = 0; i < nFanOuts; i++) {
+        if (!PopMatureCoinbase(coinbase)) return false;
+        txns.emplace_back(CreateFanOut(coinbase));
+    }
+    for (int i = 0; i < mix.nMasternodes; i++) {
+        if (!PopMatureCoinbase(coinbase)) return false;
+        txns.emplace_back(CreateProReg(coinbase));
+    }
+    if (!Mine(txns, false)) return false;
+    if (mix.nMasternodes > 0) {
+        // Legacy masternodes are obsolete from the next block on: the coinbase pays the DMNs
+        sporkManager.AddOrUpdateSporkMessage(CSporkMessage(SPORK_21_LEGACY_MNS_MAX_HEIGHT, Height(), GetTime()));
+    }
+
+    // Payload
+    for (int nBlock = 0; nBlock < mix.nBlocks; nBlock++) {
+        txns.clear();
+        for (int i = 0; i < mix.nProReg; i++) {
+            if (!PopMatureCoinbase(coinbase)) return false;
+            txns.emplace_back(CreateProReg(coinbase));
+        }
+        for (int i = 0; i < mix.nP2PKH && pool.size() >= 2; i++) {
+            const Utxo in1 = pool.front(); pool.pop_front();
+            const Utxo in2 = pool.front(); pool.pop_front();
+            txns.emplace_back(CreateTransfer(in1, in2));
+        }
+        for (int i = 0; i < mix.nColdStake; i++) {
+            if (!coldPool.empty()) {
+                txns.emplace_back(CreateOwnerSpend(coldPool.front()));
+                coldPool.pop_front();
+            }
+            if (!pool.empty()) {
+                txns.emplace_back(CreateDelegation(pool.front()));
+                pool.pop_front();
+            }
+        }
+        for (int i = 0; i < mix.nShieldSpends && !notes.empty(); i++) {
+            txns.emplace_back(CreateUnshield(notes.front()));
+            notes.pop_front();
+        }
+        for (int i = 0; i < mix.nShieldOutputs && !pool.empty(); i++) {
+            txns.emplace_back(CreateShield(pool.front()));
+            pool.pop_front();
+        }
+        if (!Mine(txns, true)) return false;
+    }
+    return true;
+}
+
+static void PrintPhaseTimings(const std::string& name, const BlockConnectTimings& t, uint64_t nBlocks)
+{
+    if (nBlocks == 0) return;
+    // Average per payload block, in microseconds
+    std::cout << "# " << name << " per-block phases (us): "
+              << "connect=" << t.nTimeConnect / nBlocks << " "
+              << "verify=" << t.nTimeVerify / nBlocks << " "
+              << "special=" << t.nTimeProcessSpecial / nBlocks << " "
+              << "index=" << t.nTimeIndex / nBlocks << " "
+              << "connect_total=" << t.nTimeConnectTotal / nBlocks << " "
+              << "flush=" << t.nTimeFlush / nBlocks << " "
+              << "chainstate=" << t.nTimeChainState / nBlocks << " "
+              << "post_connect=" << t.nTimePostConnect / nBlocks << " "
+              << "total=" << t.nTimeTotal / nBlocks << "\n";
+}
+
+static void ChainReplay(benchmark::State& state, const std::string& name, const ReplayMix& mix)
+{
+    RegTestChainSetup setup;
+    if (mix.nShieldOutputs > 0 || mix.nShieldSpends > 0) {
+        try {
+            initZKSNARKS();
+        } catch (const std::runtime_error& e) {
+            state.SkipWithError(strprintf("unable to load the Sapling parameters: %s", e.what()));
+            return;
+        }
+    }
+    ReplayChainBuilder builder(setup, mix);
+    if (!builder.Build()) {
+        state.SkipWithError("unable to build the chain");
+        return;
+    }
+    const uint256& tipHash = builder.vPayloadBlocks.back()->GetHash();
+
+    BlockConnectTimings total;
+    uint64_t nReplayedBlocks = 0;
+    while (state.KeepRunning()) {
+        // Only the connection of the payload blocks is timed
+        state.PauseTiming();
+        setup.ResetChainState();
+        if (!RegTestChainSetup::ProcessBlocks(builder.vPrefixBlocks)) {
+            state.SkipWithError("unable to connect the prefix blocks");
+            return;
+        }
+        setup.ResetCoinsCache();
+        state.ResumeTiming();
+
+        const BlockConnectTimings before = GetBlockConnectTimings();
+        const bool fConnected = RegTestChainSetup::ProcessBlocks(builder.vPayloadBlocks);
+        const BlockConnectTimings after = GetBlockConnectTimings();
+        if (!fConnected || WITH_LOCK(cs_main, return chainActive.Tip()->GetBlockHash()) != tipHash) {
+            state.SkipWithError("unable to connect the payload blocks");
+            return;
+        }
+
+        total.nTimeConnect += after.nTimeConnect - before.nTimeConnect;
+        total.nTimeVerify += after.nTimeVerify - before.nTimeVerify;
+        total.nTimeProcessSpecial += after.nTimeProcessSpecial - before.nTimeProcessSpecial;
+        total.nTimeIndex += after.nTimeIndex - before.nTimeIndex;
+        total.nTimeConnectTotal += after.nTimeConnectTotal - before.nTimeConnectTotal;
+        total.nTimeFlush += after.nTimeFlush - before.nTimeFlush;
+        total.nTimeChainState += after.nTimeChainState - before.nTimeChainState;
+        total.nTimePostConnect += after.nTimePostConnect - before.nTimePostConnect;
+        total.nTimeTotal += after.nTimeTotal - before.nTimeTotal;
+        nReplayedBlocks += builder.vPayloadBlocks.size();
+    }
+    PrintPhaseTimings(name, total, nReplayedBlocks);
+}
+
+} // namespace
+
+//                                                    blocks p2pkh p2cs shield unshield proreg mns
+static void ChainReplayP2PKH(benchmark::State& state)      { ChainReplay(state, "ChainReplayP2PKH",      {50, 50,  0, 0, 0, 0,  0}); }
+static void ChainReplayColdStake(benchmark::State& state)  { ChainReplay(state, "ChainReplayColdStake",  {50,  0, 25, 0, 0, 0,  0}); }
+static void ChainReplaySpecialTx(benchmark::State& state)  { ChainReplay(state, "ChainReplaySpecialTx",  {20,  0,  0, 0, 0, 5,  0}); }
+static void ChainReplayMNPayouts(benchmark::State& state)  { ChainReplay(state, "ChainReplayMNPayouts",  {50, 10,  0, 0, 0, 0, 10}); }
+static void ChainReplaySapling(benchmark::State& state)    { ChainReplay(state, "ChainReplaySapling",    {10,  0,  0, 2, 2, 0,  0}); }
+static void ChainReplayMixed(benchmark::State& state)      { ChainReplay(state, "ChainReplayMixed",      {20, 20, 10, 1, 1, 1,  5}); }
+
+BENCHMARK_THREADS(ChainReplayP2PKH);
+BENCHMARK_THREADS(ChainReplayColdStake);
+BENCHMARK_THREADS(ChainReplaySpecialTx);
+BENCHMARK_THREADS(ChainReplayMNPayouts);
+BENCHMARK_THREADS(ChainReplaySapling);
+BENCHMARK_THREADS(ChainReplayMixed);
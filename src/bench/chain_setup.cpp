@@ -0,0 +1,173 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench/chain_setup.h"
+
+#include "blockassembler.h"
+#include "chainparams.h"
+#include "evo/deterministicmns.h"
+#include "evo/evodb.h"
+#include "hash.h"
+#include "miner.h"
+#include "random.h"
+#include "script/sigcache.h"
+#include "sporkdb.h"
+#include "txdb.h"
+#include "util/system.h"
+#include "validation.h"
+#include "validationinterface.h"
+#include "zpivchain.h"
+
+#include <stdexcept>
+
+// Start of the mock time used for the generated chains (Mon Jan 4 2021)
+static const int64_t CHAIN_SETUP_START_TIME = 1609718400;
+
+RegTestChainSetup::RegTestChainSetup(int nScriptCheckThreadsIn) :
+        nMockTime(CHAIN_SETUP_START_TIME),
+        m_path_root(fs::temp_directory_path() / "bench_pivx" / strprintf("%lu_%i", (unsigned long)GetTime(), (int)(GetRand(1 << 30))))
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    for (int idx = Consensus::BASE_NETWORK; idx < Consensus::MAX_NETWORK_UPGRADES; idx++) {
+        vUpgradeHeights[idx] = Params().GetConsensus().vUpgrades[idx].nActivationHeight;
+    }
+    InitSignatureCache();
+    SetMockTime(nMockTime);
+
+    fs::path datadir = m_path_root / "tempdir";
+    fs::create_directories(datadir);
+    gArgs.ForceSetArg("-datadir", datadir.string());
+    ClearDatadirCache();
+
+    // Start the lightweight task scheduler thread
+    CScheduler::Function serviceLoop = std::bind(&CScheduler::serviceQueue, &scheduler);
+    threadGroup.create_thread(std::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
+    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+
+    zerocoinDB = new CZerocoinDB(0, true);
+    pSporkDB = new CSporkDB(0, true);
+    InitChainState();
+
+    nScriptCheckThreads = nScriptCheckThreadsIn;
+    for (int i = 0; i < nScriptCheckThreads - 1; i++)
+        threadGroup.create_thread(&ThreadScriptCheck);
+}
+
+RegTestChainSetup::~RegTestChainSetup()
+{
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+    GetMainSignals().FlushBackgroundCallbacks();
+    UnregisterAllValidationInterfaces();
+    GetMainSignals().UnregisterBackgroundSignalScheduler();
+    DestroyChainState();
+    delete zerocoinDB;
+    zerocoinDB = nullptr;
+    delete pSporkDB;
+    pSporkDB = nullptr;
+    sporkManager.Clear();
+    nScriptCheckThreads = 0;
+    for (int idx = Consensus::BASE_NETWORK + 1; idx < Consensus::MAX_NETWORK_UPGRADES; idx++) {
+        UpdateNetworkUpgradeParameters(Consensus::UpgradeIndex(idx), vUpgradeHeights[idx]);
+    }
+    SetMockTime(0);
+    fs::remove_all(m_path_root);
+}
+
+void RegTestChainSetup::InitChainState()
+{
+    evoDb.reset(new CEvoDB(1 << 20, true, true));
+    deterministicMNManager.reset(new CDeterministicMNManager(*evoDb));
+    pblocktree = new CBlockTreeDB(1 << 20, true);
+    pcoinsdbview = new CCoinsViewDB(1 << 23, true);
+    pcoinsTip = new CCoinsViewCache(pcoinsdbview);
+    if (!LoadGenesisBlock()) {
+        throw std::runtime_error("Error initializing block database");
+    }
+    CValidationState state;
+    if (!ActivateBestChain(state)) {
+        throw std::runtime_error("Error connecting the genesis block: " + FormatStateMessage(state));
+    }
+}
+
+void RegTestChainSetup::DestroyChainState()
+{
+    SyncWithValidationInterfaceQueue();
+    UnloadBlockIndex();
+    LOCK(cs_main);
+    delete pcoinsTip;
+    pcoinsTip = nullptr;
+    delete pcoinsdbview;
+    pcoinsdbview = nullptr;
+    delete pblocktree;
+    pblocktree = nullptr;
+    deterministicMNManager.reset();
+    evoDb.reset();
+}
+
+void RegTestChainSetup::ResetChainState()
+{
+    DestroyChainState();
+    InitChainState();
+}
+
+void RegTestChainSetup::ResetCoinsCache()
+{
+    FlushStateToDisk();
+    LOCK(cs_main);
+    delete pcoinsTip;
+    pcoinsTip = new CCoinsViewCache(pcoinsdbview);
+}
+
+std::shared_ptr<CBlock> RegTestChainSetup::CreateBlock(const std::vector<CMutableTransaction>& txns, const CScript& scriptPubKey)
+{
+    nMockTime += 60;
+    SetMockTime(nMockTime);
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(
+            Params(), DEFAULT_PRINTPRIORITY).CreateNewBlock(scriptPubKey, nullptr, false, nullptr, true);
+    std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>(pblocktemplate->block);
+
+    for (const CMutableTransaction& tx : txns) {
+        pblock->vtx.push_back(MakeTransactionRef(tx));
+    }
+
+    const int nHeight = WITH_LOCK(cs_main, return chainActive.Height()) + 1;
+    pblock->hashFinalSaplingRoot = CalculateSaplingTreeRoot(pblock.get(), nHeight, Params());
+    if (!SolveBlock(pblock, nHeight)) {
+        throw std::runtime_error("Unable to solve block");
+    }
+    return pblock;
+}
+
+std::shared_ptr<const CBlock> RegTestChainSetup::CreateAndProcessBlock(const std::vector<CMutableTransaction>& txns, const CScript& scriptPubKey)
+{
+    std::shared_ptr<const CBlock> pblock = CreateBlock(txns, scriptPubKey);
+    CValidationState state;
+    if (!ProcessNewBlock(state, pblock, nullptr) ||
+            WITH_LOCK(cs_main, return chainActive.Tip()->GetBlockHash()) != pblock->GetHash()) {
+        return nullptr;
+    }
+    return pblock;
+}
+
+bool RegTestChainSetup::ProcessBlocks(const std::vector<std::shared_ptr<const CBlock>>& blocks)
+{
+    for (const auto& pblock : blocks) {
+        CValidationState state;
+        if (!ProcessNewBlock(state, pblock, nullptr)) return false;
+    }
+    return true;
+}
+
+CKey RegTestChainSetup::GetDeterministicKey(uint32_t n)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << std::string("bench_pivx key") << n;
+    const uint256& seed = ss.GetHash();
+    CKey key;
+    key.Set(seed.begin(), seed.end(), true);
+    assert(key.IsValid());
+    return key;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PIVX_BENCH_CHAIN_SETUP_H
+#define PIVX_BENCH_CHAIN_SETUP_H
+
+#include "consensus/params.h"
+#include "fs.h"
+#include "key.h"
+#include "primitives/block.h"
+#include "scheduler.h"
+
+#include <memory>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+class CCoinsViewDB;
+
+/**
+ * In-process regtest node used by the benchmarks that need a complete chainstate.
+ * It mirrors the unit tests TestingSetup (which bench_pivx can't link):
+ * temporary data directory, in-memory block tree, coins, zerocoin, spork and evo
+ * databases, the validation signals scheduler and the script check threads.
+ * Blocks are mined with PoW and mock time advances one minute per block, so that
+ * chains built through it are deterministic in shape.
+ * The network upgrade heights of the regtest params can be changed by the users of
+ * the fixture (UpdateNetworkUpgradeParameters), they are restored on destruction.
+ */
+class RegTestChainSetup
+{
+public:
+    explicit RegTestChainSetup(int nScriptCheckThreadsIn = 3);
+    ~RegTestChainSetup();
+
+    /** Drop the whole chainstate (block index, coins, evo db) and restart from the genesis block */
+    void ResetChainState();
+    /** Flush the coins cache to its database and replace it with an empty one */
+    void ResetCoinsCache();
+
+    /** Create a block on top of the active tip, coinbase paying to scriptPubKey and including txns */
+    std::shared_ptr<CBlock> CreateBlock(const std::vector<CMutableTransaction>& txns, const CScript& scriptPubKey);
+    /** Create a block (see CreateBlock) and connect it. Returns nullptr if the block is not accepted */
+    std::shared_ptr<const CBlock> CreateAndProcessBlock(const std::vector<CMutableTransaction>& txns, const CScript& scriptPubKey);
+    /** Submit the given blocks, in order, through ProcessNewBlock */
+    static bool ProcessBlocks(const std::vector<std::shared_ptr<const CBlock>>& blocks);
+
+    /** Deterministic keys, derived from the index */
+    static CKey GetDeterministicKey(uint32_t n);
+
+    /** Current mock time (advanced by CreateBlock) */
+    int64_t nMockTime;
+
+private:
+    const fs::path m_path_root;
+    ECCVerifyHandle globalVerifyHandle;
+    CScheduler scheduler;
+    boost::thread_group threadGroup;
+    CCoinsViewDB* pcoinsdbview{nullptr};
+    // Regtest activation heights at construction
+    int vUpgradeHeights[Consensus::MAX_NETWORK_UPGRADES];
+
+    void InitChainState();
+    void DestroyChainState();
+};
+
+#endif // PIVX_BENCH_CHAIN_SETUP_H
@@ -20,7 +20,9 @@ static const size_t BATCHES = 101;
 static const size_t BATCH_SIZE = 30;
 static const int PREVECTOR_SIZE = 28;
 static const int QUEUE_BATCH_SIZE = 128;
-static void CCheckQueueSpeed(benchmark::State& state)
+// Work done by each check of the scaling benchmarks (a few microseconds)
+static const int SPIN_JOB_ITERATIONS = 2000;
+static void CCheckQueueSpeedThreads(benchmark::State& state, int nThreads)
 {
     struct FakeJobNoWork {
         bool operator()()
@@ -31,7 +33,7 @@ static void CCheckQueueSpeed(benchmark::State& state)
     };
     CCheckQueue<FakeJobNoWork> queue {QUEUE_BATCH_SIZE};
     boost::thread_group tg;
-    for (auto x = 0; x < std::max(MIN_CORES, GetNumCores()); ++x) {
+    for (auto x = 0; x < nThreads; ++x) {
        tg.create_thread([&]{queue.Thread();});
     }
     while (state.KeepRunning()) {
@@ -58,6 +60,11 @@ static void CCheckQueueSpeed(benchmark::State& state)
     tg.join_all();
 }
 
+static void CCheckQueueSpeed(benchmark::State& state)
+{
+    CCheckQueueSpeedThreads(state, std::max(MIN_CORES, GetNumCores()));
+}
+
 // This Benchmark tests the CheckQueue with a slightly realistic workload,
 // where checks all contain a prevector that is indirect 50% of the time
 // and there is a little bit of work done between calls to Add.
@@ -99,5 +106,60 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::State& state)
     tg.interrupt_all();
     tg.join_all();
 }
-BENCHMARK(CCheckQueueSpeed);
-BENCHMARK(CCheckQueueSpeedPrevectorJob);
+
+// Scaling of the queue with the number of worker threads (whatever the number of cores),
+// with checks that take a few microseconds, like a signature verification.
+static void CCheckQueueScaling(benchmark::State& state, int nThreads)
+{
+    struct FakeJobSpin {
+        uint64_t n{0};
+        bool operator()()
+        {
+            volatile uint64_t x = n;
+            for (int i = 0; i < SPIN_JOB_ITERATIONS; i++) {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            }
+            return true;
+        }
+        void swap(FakeJobSpin& x){ std::swap(n, x.n); };
+    };
+    CCheckQueue<FakeJobSpin> queue {QUEUE_BATCH_SIZE};
+    boost::thread_group tg;
+    for (auto x = 0; x < nThreads; ++x) {
+       tg.create_thread([&]{queue.Thread();});
+    }
+    while (state.KeepRunning()) {
+        CCheckQueueControl<FakeJobSpin> control(&queue);
+        for (size_t b = 0; b < BATCHES; ++b) {
+            std::vector<FakeJobSpin> vChecks(BATCH_SIZE);
+            control.Add(vChecks);
+        }
+        control.Wait();
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+static void CCheckQueueScaling_1Thread(benchmark::State& state) { CCheckQueueScaling(state, 1); }
+static void CCheckQueueScaling_2Threads(benchmark::State& state) { CCheckQueueScaling(state, 2); }
+static void CCheckQueueScaling_4Threads(benchmark::State& state) { CCheckQueueScaling(state, 4); }
+static void CCheckQueueScaling_8Threads(benchmark::State& state) { CCheckQueueScaling(state, 8); }
+static void CCheckQueueScaling_16Threads(benchmark::State& state) { CCheckQueueScaling(state, 16); }
+static void CCheckQueueScaling_32Threads(benchmark::State& state) { CCheckQueueScaling(state, 32); }
+static void CCheckQueueScaling_64Threads(benchmark::State& state) { CCheckQueueScaling(state, 64); }
+
+// Pure queue overhead (no-op checks) with many threads: contention on the queue itself
+static void CCheckQueueSpeed_16Threads(benchmark::State& state) { CCheckQueueSpeedThreads(state, 16); }
+static void CCheckQueueSpeed_64Threads(benchmark::State& state) { CCheckQueueSpeedThreads(state, 64); }
+
+BENCHMARK_THREADS(CCheckQueueSpeed);
+BENCHMARK_THREADS(CCheckQueueSpeedPrevectorJob);
+BENCHMARK_THREADS(CCheckQueueSpeed_16Threads);
+BENCHMARK_THREADS(CCheckQueueSpeed_64Threads);
+BENCHMARK_THREADS(CCheckQueueScaling_1Thread);
+BENCHMARK_THREADS(CCheckQueueScaling_2Threads);
+BENCHMARK_THREADS(CCheckQueueScaling_4Threads);
+BENCHMARK_THREADS(CCheckQueueScaling_8Threads);
+BENCHMARK_THREADS(CCheckQueueScaling_16Threads);
+BENCHMARK_THREADS(CCheckQueueScaling_32Threads);
+BENCHMARK_THREADS(CCheckQueueScaling_64Threads);
@@ -0,0 +1,117 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "clientversion.h"
+#include "coins.h"
+#include "dbwrapper.h"
+#include "primitives/block.h"
+#include "streams.h"
+#include "version.h"
+
+#include <iostream>
+
+namespace block_bench {
+#include "bench/data/block2680960.raw.h"
+}
+
+/*
+ * CDataStream (buffer wiped on release) vs CPooledDataStream (buffer recycled through
+ * the BufferPool, not wiped) on the paths that moved to the latter: receiving a block
+ * message, serializing a block, and writing small database records.
+ * The pooled variants also print how many buffers came from the system allocator and
+ * how many were recycled.
+ */
+
+// Size of the chunks in which CNetMessage::readData grows the receive buffer
+static const size_t RECV_CHUNK_SIZE = 256 * 1024;
+
+static void PrintPoolStats(const std::string& name, const BufferPool::Stats& before)
+{
+    const BufferPool::Stats after = BufferPool::Instance().GetStats();
+    std::cout << "# " << name << " buffers: "
+              << "system_allocs=" << after.nAllocated - before.nAllocated << " "
+              << "recycled=" << after.nReused - before.nReused << "\n";
+}
+
+template <typename Stream>
+static void StreamReceiveBlock(benchmark::State& state)
+{
+    const char* pch = (const char*)block_bench::block2680960;
+    const size_t nSize = sizeof(block_bench::block2680960);
+    while (state.KeepRunning()) {
+        // Same buffer handling as CNetMessage::readData
+        Stream vRecv(SER_NETWORK, PROTOCOL_VERSION);
+        for (size_t nPos = 0; nPos < nSize; nPos += RECV_CHUNK_SIZE) {
+            const size_t nCopy = std::min(RECV_CHUNK_SIZE, nSize - nPos);
+            vRecv.resize(std::min(nSize, nPos + nCopy + RECV_CHUNK_SIZE));
+            memcpy(&vRecv[nPos], pch + nPos, nCopy);
+        }
+        vRecv.resize(nSize);
+        CBlock block;
+        vRecv >> block;
+    }
+}
+
+template <typename Stream>
+static void StreamSerializeBlock(benchmark::State& state)
+{
+    CDataStream stream((const char*)block_bench::block2680960,
+            (const char*)&block_bench::block2680960[sizeof(block_bench::block2680960)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+
+    while (state.KeepRunning()) {
+        Stream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << block;
+        assert(ss.size() == sizeof(block_bench::block2680960));
+    }
+}
+
+template <typename Stream>
+static void StreamDBRecords(benchmark::State& state)
+{
+    // Same stream usage as CDBWrapper::Write (one batch per call) for 1000 coins
+    const Coin coin(CTxOut(COIN, CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0x42) << OP_EQUALVERIFY << OP_CHECKSIG), 100, false, false);
+    while (state.KeepRunning()) {
+        for (uint32_t n = 0; n < 1000; n++) {
+            Stream ssKey(SER_DISK, CLIENT_VERSION);
+            ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+            ssKey << std::make_pair('C', n);
+            Stream ssValue(SER_DISK, CLIENT_VERSION);
+            ssValue.reserve(DBWRAPPER_PREALLOC_VALUE_SIZE);
+            ssValue << coin;
+            assert(ssValue.size() > 0);
+        }
+    }
+}
+
+static void DataStreamReceiveBlock(benchmark::State& state) { StreamReceiveBlock<CDataStream>(state); }
+static void DataStreamSerializeBlock(benchmark::State& state) { StreamSerializeBlock<CDataStream>(state); }
+static void DataStreamDBRecords(benchmark::State& state) { StreamDBRecords<CDataStream>(state); }
+
+static void PooledDataStreamReceiveBlock(benchmark::State& state)
+{
+    const BufferPool::Stats before = BufferPool::Instance().GetStats();
+    StreamReceiveBlock<CPooledDataStream>(state);
+    PrintPoolStats("PooledDataStreamReceiveBlock", before);
+}
+
+static void PooledDataStreamSerializeBlock(benchmark::State& state)
+{
+    const BufferPool::Stats before = BufferPool::Instance().GetStats();
+    StreamSerializeBlock<CPooledDataStream>(state);
+    PrintPoolStats("PooledDataStreamSerializeBlock", before);
+}
+
+static void PooledDataStreamDBRecords(benchmark::State& state) { StreamDBRecords<CPooledDataStream>(state); }
+
+BENCHMARK(DataStreamReceiveBlock);
+BENCHMARK(DataStreamSerializeBlock);
+BENCHMARK(DataStreamDBRecords);
+BENCHMARK(PooledDataStreamReceiveBlock);
+BENCHMARK(PooledDataStreamSerializeBlock);
+BENCHMARK(PooledDataStreamDBRecords);
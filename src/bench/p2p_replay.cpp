@@ -0,0 +1,505 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "bench/chain_setup.h"
+
+#include "budget/budgetmanager.h"
+#include "chainparams.h"
+#include "keystore.h"
+#include "masternode.h"
+#include "masternodeman.h"
+#include "net.h"
+#include "net_processing.h"
+#include "netbase.h"
+#include "netmessagemaker.h"
+#include "random.h"
+#include "script/sign.h"
+#include "script/standard.h"
+#include "streams.h"
+#include "txmempool.h"
+#include "util/system.h"
+#include "validation.h"
+
+#include <ctime>
+#include <iostream>
+#include <map>
+
+/*
+ * P2P message-replay benchmarks.
+ *
+ * Message streams are fed into PeerLogicValidation::ProcessMessages/SendMessages
+ * through in-process CNodes (no sockets), on top of a small regtest chain.
+ * The streams are either synthetic (inv floods, tx relay, mnb/mnp/budget vote
+ * storms, getdata block requests) or recorded by a node running with
+ * -capturemessages (-p2preplayfile=<datadir>/message_capture/<peer>/msgs_recv.dat).
+ * Besides the standard timing line, the average per-message CPU time and wall time
+ * are printed for each command, along with the cs_main hold time when the tree is
+ * built with -DDEBUG_LOCKHOLDPROBE (see sync.h).
+ */
+
+namespace {
+
+struct ReplayMessage {
+    int nPeer;
+    std::string strCommand;
+    std::vector<unsigned char> vData;
+    ReplayMessage(int _nPeer, std::string _strCommand, std::vector<unsigned char> _vData) :
+        nPeer(_nPeer), strCommand(std::move(_strCommand)), vData(std::move(_vData)) {}
+    ReplayMessage(int _nPeer, CSerializedNetMsg&& msg) :
+        nPeer(_nPeer), strCommand(std::move(msg.command)), vData(std::move(msg.data)) {}
+};
+
+struct CommandStats {
+    uint64_t nCount{0};
+    uint64_t nBytes{0};
+    int64_t nCpuTime{0};
+    int64_t nWallTime{0};
+    int64_t nLockTime{0};
+};
+
+// Number of in-process peers the synthetic streams are spread over
+static const int NUM_PEERS = 8;
+// Number of legacy masternodes announced (and pinged, and voting) by the mnb storm
+static const int NUM_MASTERNODES = 20;
+// Number of transactions in the tx relay stream
+static const int NUM_RELAY_TXES = 500;
+// Number of outputs created from each coinbase to fund the relayed transactions
+static const int FAN_OUT_OUTPUTS = 25;
+// Fee paid by each relayed transaction
+static const CAmount RELAY_TX_FEE = COIN / 1000;
+// Pseudo-command under which the SendMessages calls are accounted
+static const std::string SEND_MESSAGES_CMD = "<sendmsgs>";
+
+/** CPU time consumed by the calling thread (falls back to wall time if unsupported) */
+static int64_t GetThreadCpuTimeMicros()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+#endif
+    return GetTimeMicros();
+}
+
+/** Time cs_main was held, in microseconds, since the probe was set (0 without the lock probe) */
+static int64_t GetMainHoldMicros()
+{
+#ifdef DEBUG_LOCKHOLDPROBE
+    return GetLockHoldProbeMicros();
+#else
+    return 0;
+#endif
+}
+
+/** Read a file written by -capturemessages (see CaptureMessage in net.h) */
+static bool LoadCaptureFile(const fs::path& path, std::vector<ReplayMessage>& msgsRet)
+{
+    CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) return false;
+    try {
+        while (true) {
+            int64_t nTimeMicros;
+            char command[CMessageHeader::COMMAND_SIZE];
+            uint32_t nSize;
+            file >> nTimeMicros;
+            file.read(command, CMessageHeader::COMMAND_SIZE);
+            file >> nSize;
+            std::vector<unsigned char> vData(nSize);
+            if (nSize > 0) file.read((char*)vData.data(), nSize);
+            msgsRet.emplace_back(0, std::string(command, strnlen(command, CMessageHeader::COMMAND_SIZE)), std::move(vData));
+        }
+    } catch (const std::ios_base::failure&) {
+        // end of file (a truncated last record is dropped)
+    }
+    return true;
+}
+
+class P2PReplayHarness
+{
+public:
+    explicit P2PReplayHarness(int nPeersIn);
+    ~P2PReplayHarness();
+
+    /** Clear the mempool, masternode and budget managers and reconnect the peers */
+    void ResetState();
+    /** Deliver the stream, one message at a time, accounting its processing to the message command */
+    void Replay(const std::vector<ReplayMessage>& msgs);
+    /** Print the per-command averages collected so far */
+    void PrintStats(const std::string& name) const;
+
+    std::vector<ReplayMessage> InvFloodStream(int nMessagesPerPeer, int nInvPerMessage);
+    std::vector<ReplayMessage> TxRelayStream();
+    std::vector<ReplayMessage> MasternodeStormStream(int nVotesPerMasternode);
+    std::vector<ReplayMessage> GetDataBlocksStream(int nRounds, int nBlocksPerMessage);
+
+private:
+    RegTestChainSetup chain;
+    const int nPeers;
+    std::unique_ptr<PeerLogicValidation> peerLogic;
+    std::vector<std::unique_ptr<CNode>> vNodes;
+    std::map<std::string, CommandStats> mapStats;
+    std::atomic<bool> interruptDummy{false};
+
+    CBasicKeyStore keystore;
+    CScript p2pkhScript;
+    std::vector<std::pair<COutPoint, CTxOut>> vCollaterals;     // one per masternode
+    std::vector<std::pair<COutPoint, CTxOut>> vRelayInputs;     // spent by the tx relay stream
+    std::vector<uint256> vBlockHashes;
+
+    void BuildChain();
+    void ConnectPeers();
+    void DisconnectPeers();
+    void Deliver(CNode* pnode, const ReplayMessage& msg);
+    void ClearSendQueue(CNode* pnode);
+    void Account(const std::string& strCommand, size_t nBytes, int64_t nCpuStart, int64_t nWallStart, int64_t nLockStart);
+};
+
+P2PReplayHarness::P2PReplayHarness(int nPeersIn) :
+    chain(1),
+    nPeers(nPeersIn)
+{
+    // Replayed (or garbage) messages must never get the peers banned
+    gArgs.ForceSetArg("-banscore", std::to_string(std::numeric_limits<int>::max()));
+    g_connman = std::unique_ptr<CConnman>(new CConnman(0x1337, 0x1337));
+    peerLogic.reset(new PeerLogicValidation(g_connman.get()));
+    BuildChain();
+    ConnectPeers();
+#ifdef DEBUG_LOCKHOLDPROBE
+    SetLockHoldProbe(&cs_main);
+#endif
+}
+
+P2PReplayHarness::~P2PReplayHarness()
+{
+#ifdef DEBUG_LOCKHOLDPROBE
+    SetLockHoldProbe(nullptr);
+#endif
+    DisconnectPeers();
+    mempool.clear();
+    mnodeman.Clear();
+    g_budgetman.Clear();
+    peerLogic.reset();
+    g_connman.reset();
+    gArgs.ForceSetArg("-banscore", std::to_string(DEFAULT_BANSCORE_THRESHOLD));
+}
+
+void P2PReplayHarness::BuildChain()
+{
+    const Consensus::Params& consensus = Params().GetConsensus();
+    const CKey& coinbaseKey = RegTestChainSetup::GetDeterministicKey(0);
+    keystore.AddKey(coinbaseKey);
+    p2pkhScript = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+
+    // One collateral per matured coinbase, then fan-outs funding the relayed transactions
+    const int nFanOuts = (NUM_RELAY_TXES + FAN_OUT_OUTPUTS - 1) / FAN_OUT_OUTPUTS;
+    const int nTipHeight = consensus.nCoinbaseMaturity + NUM_MASTERNODES + nFanOuts;
+    std::vector<CTransactionRef> vCoinbases;
+    for (int nHeight = 1; nHeight <= nTipHeight; nHeight++) {
+        std::vector<CMutableTransaction> txns;
+        const int nSpent = nHeight - consensus.nCoinbaseMaturity;
+        if (nSpent > 0) {
+            const CTransactionRef& coinbase = vCoinbases[nSpent - 1];
+            CMutableTransaction mtx;
+            mtx.vin.emplace_back(coinbase->GetHash(), 0);
+            if (nSpent <= NUM_MASTERNODES) {
+                const CKey& collateralKey = RegTestChainSetup::GetDeterministicKey(100 + nSpent - 1);
+                mtx.vout.emplace_back(consensus.nMNCollateralAmt, GetScriptForDestination(collateralKey.GetPubKey().GetID()));
+                mtx.vout.emplace_back(coinbase->vout[0].nValue - consensus.nMNCollateralAmt, p2pkhScript);
+            } else {
+                for (int i = 0; i < FAN_OUT_OUTPUTS; i++) {
+                    mtx.vout.emplace_back(coinbase->vout[0].nValue / FAN_OUT_OUTPUTS, p2pkhScript);
+                }
+            }
+            if (!SignSignature(keystore, coinbase->vout[0].scriptPubKey, mtx, 0, coinbase->vout[0].nValue, SIGHASH_ALL)) {
+                throw std::runtime_error("Unable to sign input");
+            }
+            txns.emplace_back(mtx);
+        }
+
+        const auto pblock = chain.CreateAndProcessBlock(txns, p2pkhScript);
+        if (!pblock) {
+            throw std::runtime_error(strprintf("Unable to connect block %d", nHeight));
+        }
+        vCoinbases.emplace_back(pblock->vtx[0]);
+        vBlockHashes.emplace_back(pblock->GetHash());
+        if (nSpent > 0) {
+            const CTransactionRef& tx = pblock->vtx[1];
+            if (nSpent <= NUM_MASTERNODES) {
+                vCollaterals.emplace_back(COutPoint(tx->GetHash(), 0), tx->vout[0]);
+            } else {
+                for (uint32_t i = 0; i < tx->vout.size() && (int)vRelayInputs.size() < NUM_RELAY_TXES; i++) {
+                    vRelayInputs.emplace_back(COutPoint(tx->GetHash(), i), tx->vout[i]);
+                }
+            }
+        }
+    }
+}
+
+void P2PReplayHarness::ConnectPeers()
+{
+    for (int i = 0; i < nPeers; i++) {
+        const CAddress addr(LookupNumeric(strprintf("10.0.0.%d", i + 1).c_str(), Params().GetDefaultPort()), NODE_NONE);
+        vNodes.emplace_back(new CNode(i, NODE_NETWORK, 0, INVALID_SOCKET, addr, i, i, "", true));
+        CNode* pnode = vNodes.back().get();
+        pnode->SetSendVersion(PROTOCOL_VERSION);
+        pnode->SetRecvVersion(PROTOCOL_VERSION);
+        peerLogic->InitializeNode(pnode);
+        pnode->nVersion = PROTOCOL_VERSION;
+        pnode->fSuccessfullyConnected = true;
+    }
+}
+
+void P2PReplayHarness::DisconnectPeers()
+{
+    for (const auto& pnode : vNodes) {
+        bool fUpdateConnectionTime = false;
+        peerLogic->FinalizeNode(pnode->GetId(), fUpdateConnectionTime);
+    }
+    vNodes.clear();
+}
+
+void P2PReplayHarness::ResetState()
+{
+    DisconnectPeers();
+    mempool.clear();
+    mnodeman.Clear();
+    g_budgetman.Clear();
+    ConnectPeers();
+}
+
+void P2PReplayHarness::Deliver(CNode* pnode, const ReplayMessage& msg)
+{
+    // Same framing as CConnman::PushMessage
+    CMessageHeader hdr(Params().MessageStart(), msg.strCommand.c_str(), msg.vData.size());
+    const uint256& hash = Hash(msg.vData.data(), msg.vData.data() + msg.vData.size());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+    std::vector<unsigned char> vHeader;
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, vHeader, 0, hdr};
+
+    LOCK(pnode->cs_vProcessMsg);
+    pnode->vProcessMsg.emplace_back(Params().MessageStart(), SER_NETWORK, INIT_PROTO_VERSION);
+    CNetMessage& netmsg = pnode->vProcessMsg.back();
+    netmsg.readHeader((const char*)vHeader.data(), vHeader.size());
+    if (!msg.vData.empty()) {
+        netmsg.readData((const char*)msg.vData.data(), msg.vData.size());
+    }
+    netmsg.nTime = GetTimeMicros();
+    pnode->nProcessQueueSize += netmsg.vRecv.size() + CMessageHeader::HEADER_SIZE;
+}
+
+void P2PReplayHarness::ClearSendQueue(CNode* pnode)
+{
+    // Nothing is ever sent: drop the responses, so that the peer is never paused
+    LOCK(pnode->cs_vSend);
+    pnode->vSendMsg.clear();
+    pnode->nSendSize = 0;
+    pnode->nSendOffset = 0;
+    pnode->fPauseSend = false;
+}
+
+void P2PReplayHarness::Account(const std::string& strCommand, size_t nBytes, int64_t nCpuStart, int64_t nWallStart, int64_t nLockStart)
+{
+    CommandStats& stats = mapStats[strCommand];
+    stats.nCount++;
+    stats.nBytes += nBytes;
+    stats.nCpuTime += GetThreadCpuTimeMicros() - nCpuStart;
+    stats.nWallTime += GetTimeMicros() - nWallStart;
+    stats.nLockTime += GetMainHoldMicros() - nLockStart;
+}
+
+void P2PReplayHarness::Replay(const std::vector<ReplayMessage>& msgs)
+{
+    for (const ReplayMessage& msg : msgs) {
+        CNode* pnode = vNodes[msg.nPeer % nPeers].get();
+        Deliver(pnode, msg);
+
+        int64_t nCpuStart = GetThreadCpuTimeMicros();
+        int64_t nWallStart = GetTimeMicros();
+        int64_t nLockStart = GetMainHoldMicros();
+        while (peerLogic->ProcessMessages(pnode, interruptDummy) && !pnode->fDisconnect) {}
+        Account(msg.strCommand, msg.vData.size(), nCpuStart, nWallStart, nLockStart);
+
+        nCpuStart = GetThreadCpuTimeMicros();
+        nWallStart = GetTimeMicros();
+        nLockStart = GetMainHoldMicros();
+        {
+            LOCK(pnode->cs_sendProcessing);
+            peerLogic->SendMessages(pnode, interruptDummy);
+        }
+        Account(SEND_MESSAGES_CMD, 0, nCpuStart, nWallStart, nLockStart);
+
+        ClearSendQueue(pnode);
+        pnode->fDisconnect = false;
+    }
+}
+
+void P2PReplayHarness::PrintStats(const std::string& name) const
+{
+    // Average per message, in microseconds
+    for (const auto& it : mapStats) {
+        const CommandStats& stats = it.second;
+        std::cout << "# " << name << " per-command (us): " << it.first << " "
+                  << "count=" << stats.nCount << " "
+                  << "bytes=" << stats.nBytes / stats.nCount << " "
+                  << "cpu=" << stats.nCpuTime / (int64_t)stats.nCount << " "
+                  << "wall=" << stats.nWallTime / (int64_t)stats.nCount;
+#ifdef DEBUG_LOCKHOLDPROBE
+        std::cout << " cs_main=" << stats.nLockTime / (int64_t)stats.nCount;
+#endif
+        std::cout << "\n";
+    }
+#ifndef DEBUG_LOCKHOLDPROBE
+    std::cout << "# " << name << " cs_main hold time not measured (build with -DDEBUG_LOCKHOLDPROBE)\n";
+#endif
+}
+
+std::vector<ReplayMessage> P2PReplayHarness::InvFloodStream(int nMessagesPerPeer, int nInvPerMessage)
+{
+    CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    std::vector<ReplayMessage> msgs;
+    for (int i = 0; i < nMessagesPerPeer; i++) {
+        for (int nPeer = 0; nPeer < nPeers; nPeer++) {
+            std::vector<CInv> vInv;
+            for (int j = 0; j < nInvPerMessage; j++) {
+                vInv.emplace_back(MSG_TX, GetRandHash());
+            }
+            msgs.emplace_back(nPeer, msgMaker.Make(NetMsgType::INV, vInv));
+        }
+    }
+    return msgs;
+}
+
+std::vector<ReplayMessage> P2PReplayHarness::TxRelayStream()
+{
+    CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    std::vector<ReplayMessage> msgs;
+    for (size_t i = 0; i < vRelayInputs.size(); i++) {
+        const auto& input = vRelayInputs[i];
+        CMutableTransaction mtx;
+        mtx.vin.emplace_back(input.first);
+        mtx.vout.emplace_back(input.second.nValue - RELAY_TX_FEE, p2pkhScript);
+        if (!SignSignature(keystore, input.second.scriptPubKey, mtx, 0, input.second.nValue, SIGHASH_ALL)) {
+            throw std::runtime_error("Unable to sign input");
+        }
+        msgs.emplace_back(i, msgMaker.Make(NetMsgType::TX, CTransaction(mtx)));
+    }
+    return msgs;
+}
+
+std::vector<ReplayMessage> P2PReplayHarness::MasternodeStormStream(int nVotesPerMasternode)
+{
+    CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    std::vector<ReplayMessage> vBroadcasts, vPings, vVotes;
+    for (size_t i = 0; i < vCollaterals.size(); i++) {
+        const CKey& collateralKey = RegTestChainSetup::GetDeterministicKey(100 + i);
+        const CKey& mnKey = RegTestChainSetup::GetDeterministicKey(200 + i);
+        const CTxIn vin(vCollaterals[i].first);
+        const CService service = LookupNumeric(strprintf("10.1.%d.%d", i / 250, i % 250 + 1).c_str(), Params().GetDefaultPort());
+
+        std::string strError;
+        CMasternodeBroadcast mnb;
+        if (!CMasternodeBroadcast::Create(vin, service, collateralKey, collateralKey.GetPubKey(), mnKey, mnKey.GetPubKey(), strError, mnb)) {
+            throw std::runtime_error("Unable to create mnb: " + strError);
+        }
+        vBroadcasts.emplace_back(i, msgMaker.Make(NetMsgType::MNBROADCAST, mnb));
+
+        CMasternodePing mnp(vin, mnodeman.GetBlockHashToPing(), mnb.sigTime + MasternodeMinPingSeconds());
+        if (!mnp.Sign(mnKey, mnKey.GetPubKey().GetID())) {
+            throw std::runtime_error("Unable to sign mnp");
+        }
+        vPings.emplace_back(i, msgMaker.Make(NetMsgType::MNPING, mnp));
+
+        for (int j = 0; j < nVotesPerMasternode; j++) {
+            CBudgetVote vote(vin, GetRandHash(), CBudgetVote::VOTE_YES);
+            if (!vote.Sign(mnKey, mnKey.GetPubKey().GetID())) {
+                throw std::runtime_error("Unable to sign budget vote");
+            }
+            vVotes.emplace_back(i, msgMaker.Make(NetMsgType::BUDGETVOTE, vote));
+        }
+    }
+
+    // All the announcements first, then the pings, then the votes
+    std::vector<ReplayMessage> msgs;
+    for (auto* v : {&vBroadcasts, &vPings, &vVotes}) {
+        std::move(v->begin(), v->end(), std::back_inserter(msgs));
+    }
+    return msgs;
+}
+
+std::vector<ReplayMessage> P2PReplayHarness::GetDataBlocksStream(int nRounds, int nBlocksPerMessage)
+{
+    CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    std::vector<ReplayMessage> msgs;
+    for (int i = 0; i < nRounds; i++) {
+        for (int nPeer = 0; nPeer < nPeers; nPeer++) {
+            std::vector<CInv> vInv;
+            for (int j = 0; j < nBlocksPerMessage; j++) {
+                vInv.emplace_back(MSG_BLOCK, vBlockHashes[vBlockHashes.size() - 1 - ((i * nPeers + nPeer + j) % vBlockHashes.size())]);
+            }
+            msgs.emplace_back(nPeer, msgMaker.Make(NetMsgType::GETDATA, vInv));
+        }
+    }
+    return msgs;
+}
+
+static void P2PReplay(benchmark::State& state, const std::string& name, P2PReplayHarness& harness, const std::vector<ReplayMessage>& msgs)
+{
+    while (state.KeepRunning()) {
+        harness.ResetState();
+        harness.Replay(msgs);
+    }
+    harness.PrintStats(name);
+}
+
+} // namespace
+
+static void P2PInvFlood(benchmark::State& state)
+{
+    P2PReplayHarness harness(NUM_PEERS);
+    P2PReplay(state, "P2PInvFlood", harness, harness.InvFloodStream(10, MAX_INV_SZ / 50));
+}
+
+static void P2PTxRelay(benchmark::State& state)
+{
+    P2PReplayHarness harness(NUM_PEERS);
+    P2PReplay(state, "P2PTxRelay", harness, harness.TxRelayStream());
+}
+
+static void P2PMasternodeStorm(benchmark::State& state)
+{
+    P2PReplayHarness harness(NUM_PEERS);
+    P2PReplay(state, "P2PMasternodeStorm", harness, harness.MasternodeStormStream(5));
+}
+
+static void P2PGetDataBlocks(benchmark::State& state)
+{
+    P2PReplayHarness harness(NUM_PEERS);
+    P2PReplay(state, "P2PGetDataBlocks", harness, harness.GetDataBlocksStream(4, 16));
+}
+
+static void P2PReplayCapture(benchmark::State& state)
+{
+    // The capture is replayed on a regtest chain: messages referring to another
+    // network's chain exercise their rejection paths only.
+    const std::string strFile = gArgs.GetArg("-p2preplayfile", "");
+    std::vector<ReplayMessage> msgs;
+    if (strFile.empty()) {
+        state.SkipWithError("no capture file (-p2preplayfile=<file>)");
+        return;
+    }
+    if (!LoadCaptureFile(fs::path(strFile), msgs)) {
+        state.SkipWithError(strprintf("unable to read the capture file %s", strFile));
+        return;
+    }
+    P2PReplayHarness harness(1);
+    P2PReplay(state, "P2PReplayCapture", harness, msgs);
+}
+
+BENCHMARK(P2PInvFlood);
+BENCHMARK(P2PTxRelay);
+BENCHMARK(P2PMasternodeStorm);
+BENCHMARK(P2PGetDataBlocks);
+BENCHMARK(P2PReplayCapture);
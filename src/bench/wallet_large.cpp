@@ -0,0 +1,391 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "bench/chain_setup.h"
+
+#include "chainparams.h"
+#include "keystore.h"
+#include "random.h"
+#include "rpc/server.h"
+#include "sapling/note.h"
+#include "sapling/noteencryption.h"
+#include "script/sign.h"
+#include "script/standard.h"
+#include "util/system.h"
+#include "validation.h"
+#include "wallet/db.h"
+#include "wallet/wallet.h"
+
+#include <deque>
+
+extern UniValue listtransactions(const JSONRPCRequest& request);
+
+/*
+ * Large synthetic-wallet benchmarks.
+ *
+ * Each benchmark builds a regtest chain whose coinbases and fan-out transactions
+ * pay to the wallet keys (the rescan workload), and an on-disk wallet holding
+ * -walletbenchtxs synthetic transactions (default: 10000) confirmed along that chain:
+ * plain receives, spends with change, P2CS delegations (owner and staker side) and
+ * Sapling notes with their witnesses. The synthetic transactions spend random
+ * prevouts and carry no proofs: the wallet never validates them.
+ * Larger wallets (up to 1M transactions) are obtained with e.g.
+ *   bench_pivx -walletbenchtxs=1000000
+ */
+
+namespace {
+
+static const int64_t DEFAULT_WALLET_BENCH_TXS = 10000;
+// Keys owned by the wallet (transparent outputs are spread across them)
+static const int WALLET_KEYS = 100;
+// Chain height. Below the regtest PoS and v5.0 activations, so that rescans
+// don't increment the witnesses of the synthetic notes.
+static const int WALLET_CHAIN_HEIGHT = 200;
+// Outputs paying the wallet in each block of the chain (coinbase excluded)
+static const int RESCAN_FAN_OUT = 25;
+// One synthetic transaction every SAPLING_NOTE_RATIO receives a note (capped at MAX_SAPLING_NOTES)
+static const int SAPLING_NOTE_RATIO = 100;
+static const int MAX_SAPLING_NOTES = 1000;
+static const CAmount SYNTHETIC_TX_VALUE = 10 * COIN;
+static const std::string LARGE_WALLET_FILE = "bench_wallet.dat";
+
+static OutputDescription CreateNoteOutput(const libzcash::SaplingPaymentAddress& addr, CAmount nValue)
+{
+    libzcash::SaplingNote note(addr, nValue);
+    std::array<unsigned char, ZC_MEMO_SIZE> memo = {{0xF6}};
+    libzcash::SaplingNotePlaintext notePlaintext(note, memo);
+    auto res = notePlaintext.encrypt(note.pk_d);
+    assert(res);
+
+    OutputDescription odesc;
+    odesc.cmu = note.cmu().get();
+    odesc.ephemeralKey = res->second.get_epk();
+    odesc.encCiphertext = res->first;
+    return odesc;
+}
+
+class LargeWalletSetup
+{
+public:
+    explicit LargeWalletSetup(int64_t _nTxs);
+    ~LargeWalletSetup();
+
+    /** Release the wallet and flush its database, leaving a loadable wallet file */
+    void UnloadWallet();
+
+    RegTestChainSetup chain;
+    const int64_t nTxs;
+    const int nNotes;
+    std::unique_ptr<CWallet> pwallet;
+    // Sapling commitment tree as seen by the wallet, at the chain tip
+    SaplingMerkleTree saplingTree;
+    // Payment address of notes not belonging to the wallet
+    libzcash::SaplingPaymentAddress foreignAddr;
+
+private:
+    std::vector<CKey> vKeys;
+    std::vector<CScript> vScripts;
+    CScript foreignScript;
+    CKeyID foreignKeyID;
+    libzcash::SaplingPaymentAddress saplingAddr;
+    std::deque<std::pair<COutPoint, CAmount>> unspent;   // synthetic P2PKH outputs of the wallet
+    FastRandomContext rng{true};
+
+    void BuildChain();
+    void CreateWallet();
+    void Rescan();
+    void AddSyntheticTxs();
+    CTransactionRef CreateSyntheticTx(int64_t n);
+};
+
+LargeWalletSetup::LargeWalletSetup(int64_t _nTxs) :
+    nTxs(_nTxs),
+    nNotes((int)std::min<int64_t>(_nTxs / SAPLING_NOTE_RATIO, MAX_SAPLING_NOTES))
+{
+    for (int i = 0; i < WALLET_KEYS; i++) {
+        vKeys.emplace_back(RegTestChainSetup::GetDeterministicKey(i));
+        vScripts.emplace_back(GetScriptForDestination(vKeys.back().GetPubKey().GetID()));
+    }
+    foreignKeyID = RegTestChainSetup::GetDeterministicKey(WALLET_KEYS).GetPubKey().GetID();
+    foreignScript = GetScriptForDestination(foreignKeyID);
+    foreignAddr = libzcash::SaplingSpendingKey(Hash(foreignScript.begin(), foreignScript.end())).default_address();
+
+    BuildChain();
+    CreateWallet();
+    Rescan();
+    AddSyntheticTxs();
+}
+
+LargeWalletSetup::~LargeWalletSetup()
+{
+    vpwallets.clear();
+    pwallet.reset();
+    bitdb.Flush(true);
+    bitdb.Reset();
+}
+
+void LargeWalletSetup::UnloadWallet()
+{
+    vpwallets.clear();
+    pwallet.reset();
+    bitdb.Flush(false);
+}
+
+void LargeWalletSetup::BuildChain()
+{
+    const int nMaturity = Params().GetConsensus().nCoinbaseMaturity;
+    CBasicKeyStore keystore;
+    for (const CKey& key : vKeys) keystore.AddKey(key);
+
+    std::vector<CTransactionRef> vCoinbases;
+    for (int nHeight = 1; nHeight <= WALLET_CHAIN_HEIGHT; nHeight++) {
+        std::vector<CMutableTransaction> txns;
+        if (nHeight > nMaturity) {
+            // fan-out the coinbase that just matured
+            const CTransactionRef& coinbase = vCoinbases[nHeight - nMaturity - 1];
+            const CTxOut& prevOut = coinbase->vout[0];
+            CMutableTransaction mtx;
+            mtx.vin.emplace_back(coinbase->GetHash(), 0);
+            for (int i = 0; i < RESCAN_FAN_OUT; i++) {
+                mtx.vout.emplace_back(prevOut.nValue / RESCAN_FAN_OUT, vScripts[(nHeight + i) % WALLET_KEYS]);
+            }
+            if (!SignSignature(keystore, prevOut.scriptPubKey, mtx, 0, prevOut.nValue, SIGHASH_ALL)) {
+                throw std::runtime_error("Unable to sign fan-out transaction");
+            }
+            txns.emplace_back(mtx);
+        }
+        auto pblock = chain.CreateAndProcessBlock(txns, vScripts[nHeight % WALLET_KEYS]);
+        if (!pblock) {
+            throw std::runtime_error(strprintf("Unable to connect block at height %d", nHeight));
+        }
+        vCoinbases.emplace_back(pblock->vtx[0]);
+    }
+}
+
+void LargeWalletSetup::CreateWallet()
+{
+    pwallet = MakeUnique<CWallet>(MakeUnique<CWalletDBWrapper>(&bitdb, LARGE_WALLET_FILE));
+    bool fFirstRun;
+    if (pwallet->LoadWallet(fFirstRun) != DB_LOAD_OK) {
+        throw std::runtime_error("Unable to create the wallet");
+    }
+    pwallet->SetMinVersion(FEATURE_SAPLING);
+    pwallet->SetupSPKM(false);
+    for (const CKey& key : vKeys) {
+        pwallet->AddKeyPubKey(key, key.GetPubKey());
+    }
+    LOCK2(cs_main, pwallet->cs_wallet);
+    saplingAddr = pwallet->GenerateNewSaplingZKey();
+    pwallet->SetLastBlockProcessed(chainActive.Tip());
+    vpwallets.emplace_back(pwallet.get());
+}
+
+void LargeWalletSetup::Rescan()
+{
+    WalletRescanReserver reserver(pwallet.get());
+    reserver.reserve();
+    CBlockIndex* pindexGenesis = WITH_LOCK(cs_main, return chainActive.Genesis());
+    if (pwallet->ScanForWalletTransactions(pindexGenesis, nullptr, reserver, true) != nullptr) {
+        throw std::runtime_error("Wallet rescan failed");
+    }
+}
+
+CTransactionRef LargeWalletSetup::CreateSyntheticTx(int64_t n)
+{
+    const CScript& script = vScripts[n % WALLET_KEYS];
+    const int nNoteInterval = nNotes > 0 ? (int)(nTxs / nNotes) : 0;
+
+    CMutableTransaction mtx;
+    int nWalletOut = -1;    // spendable P2PKH output paying the wallet
+    if (nNoteInterval > 0 && n % nNoteInterval == 0 && n / nNoteInterval < nNotes) {
+        // shielded receive
+        mtx.nVersion = CTransaction::TxVersion::SAPLING;
+        mtx.vin.emplace_back(rng.rand256(), 0);
+        mtx.sapData->vShieldedOutput.emplace_back(CreateNoteOutput(saplingAddr, SYNTHETIC_TX_VALUE));
+        mtx.sapData->valueBalance = -SYNTHETIC_TX_VALUE;
+    } else if (n % 10 == 3) {
+        // delegation, the wallet holds the owner key
+        mtx.vin.emplace_back(rng.rand256(), 0);
+        mtx.vout.emplace_back(SYNTHETIC_TX_VALUE, GetScriptForStakeDelegation(foreignKeyID, vKeys[n % WALLET_KEYS].GetPubKey().GetID()));
+    } else if (n % 10 == 7) {
+        // delegation, the wallet holds the staker key
+        mtx.vin.emplace_back(rng.rand256(), 0);
+        mtx.vout.emplace_back(SYNTHETIC_TX_VALUE, GetScriptForStakeDelegation(vKeys[n % WALLET_KEYS].GetPubKey().GetID(), foreignKeyID));
+    } else if (n % 4 == 1 && !unspent.empty()) {
+        // spend, with change back to the wallet
+        const auto prev = unspent.front();
+        unspent.pop_front();
+        mtx.vin.emplace_back(prev.first);
+        mtx.vout.emplace_back(prev.second / 2, foreignScript);
+        mtx.vout.emplace_back(prev.second / 2, script);
+        nWalletOut = 1;
+    } else {
+        // receive, with change to the sender
+        mtx.vin.emplace_back(rng.rand256(), 0);
+        mtx.vout.emplace_back(SYNTHETIC_TX_VALUE, script);
+        mtx.vout.emplace_back(SYNTHETIC_TX_VALUE, foreignScript);
+        nWalletOut = 0;
+    }
+
+    CTransactionRef tx = MakeTransactionRef(mtx);
+    if (nWalletOut >= 0) {
+        unspent.emplace_back(COutPoint(tx->GetHash(), nWalletOut), tx->vout[nWalletOut].nValue);
+    }
+    return tx;
+}
+
+void LargeWalletSetup::AddSyntheticTxs()
+{
+    LOCK2(cs_main, pwallet->cs_wallet);
+    const int nTipHeight = chainActive.Height();
+    int64_t nNext = 0;
+    // Transactions are spread over [1, tip - 1] (so that they can all stake)
+    for (int nHeight = 1; nHeight < nTipHeight; nHeight++) {
+        const CBlockIndex* pindex = chainActive[nHeight];
+        // Container of the shielded transactions "mined" at this height
+        CBlock block;
+        int nPos = (int) pindex->nTx;
+        const int64_t nEnd = nTxs * nHeight / (nTipHeight - 1);
+        for (; nNext < nEnd; nNext++) {
+            CTransactionRef tx = CreateSyntheticTx(nNext);
+            CWalletTx::Confirmation confirm(CWalletTx::Status::CONFIRMED, nHeight, pindex->GetBlockHash(), nPos++);
+            if (!pwallet->AddToWalletIfInvolvingMe(tx, confirm, false)) {
+                throw std::runtime_error("Unable to add synthetic transaction to the wallet");
+            }
+            if (tx->IsShieldedTx()) block.vtx.emplace_back(tx);
+        }
+        pwallet->IncrementNoteWitnesses(pindex, &block, saplingTree);
+    }
+    pwallet->SetBestChain(chainActive.GetLocator());
+}
+
+static int64_t GetWalletBenchTxs()
+{
+    return gArgs.GetArg("-walletbenchtxs", DEFAULT_WALLET_BENCH_TXS);
+}
+
+} // namespace
+
+// Deserialize the whole wallet from its database
+static void WalletLoad(benchmark::State& state)
+{
+    LargeWalletSetup setup(GetWalletBenchTxs());
+    setup.UnloadWallet();
+    while (state.KeepRunning()) {
+        CWallet wallet(MakeUnique<CWalletDBWrapper>(&bitdb, LARGE_WALLET_FILE));
+        bool fFirstRun;
+        if (wallet.LoadWallet(fFirstRun) != DB_LOAD_OK) {
+            state.SkipWithError("unable to load the wallet");
+            return;
+        }
+    }
+}
+
+static void WalletGetBalance(benchmark::State& state)
+{
+    LargeWalletSetup setup(GetWalletBenchTxs());
+    while (state.KeepRunning()) {
+        const CWallet::Balance bal = setup.pwallet->GetBalance();
+        assert(bal.m_mine_trusted > 0);
+    }
+}
+
+static void WalletAvailableCoins(benchmark::State& state)
+{
+    LargeWalletSetup setup(GetWalletBenchTxs());
+    while (state.KeepRunning()) {
+        std::vector<COutput> vCoins;
+        if (!setup.pwallet->AvailableCoins(&vCoins)) {
+            state.SkipWithError("no available coins");
+            return;
+        }
+    }
+}
+
+static void WalletStakeableCoins(benchmark::State& state)
+{
+    LargeWalletSetup setup(GetWalletBenchTxs());
+    while (state.KeepRunning()) {
+        std::vector<CStakeableOutput> vCoins;
+        if (!setup.pwallet->StakeableCoins(&vCoins)) {
+            state.SkipWithError("no stakeable coins");
+            return;
+        }
+    }
+}
+
+// Select the inputs of a 1000 PIV payment
+static void WalletSelectCoins(benchmark::State& state)
+{
+    LargeWalletSetup setup(GetWalletBenchTxs());
+    std::vector<COutput> vCoins;
+    setup.pwallet->AvailableCoins(&vCoins);
+    while (state.KeepRunning()) {
+        std::set<std::pair<const CWalletTx*, unsigned int>> setCoins;
+        CAmount nValueRet = 0;
+        if (!setup.pwallet->SelectCoinsToSpend(vCoins, 1000 * COIN, setCoins, nValueRet)) {
+            state.SkipWithError("unable to select the coins");
+            return;
+        }
+    }
+}
+
+// Witness updates for a connected block with two (foreign) shielded outputs
+static void WalletIncrementNoteWitnesses(benchmark::State& state)
+{
+    LargeWalletSetup setup(GetWalletBenchTxs());
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::TxVersion::SAPLING;
+    mtx.sapData->vShieldedOutput.emplace_back(CreateNoteOutput(setup.foreignAddr, COIN));
+    mtx.sapData->vShieldedOutput.emplace_back(CreateNoteOutput(setup.foreignAddr, COIN));
+    CBlock block;
+    block.vtx.emplace_back(MakeTransactionRef(mtx));
+
+    // Blocks only need to be sequential in height for the witness cache
+    CBlockIndex index;
+    index.nHeight = WITH_LOCK(cs_main, return chainActive.Height());
+    while (state.KeepRunning()) {
+        index.nHeight++;
+        setup.pwallet->IncrementNoteWitnesses(&index, &block, setup.saplingTree);
+    }
+}
+
+// listtransactions "*" 100
+static void WalletListTransactions(benchmark::State& state)
+{
+    LargeWalletSetup setup(GetWalletBenchTxs());
+    JSONRPCRequest request;
+    request.params = UniValue(UniValue::VARR);
+    request.params.push_back("*");
+    request.params.push_back(100);
+    while (state.KeepRunning()) {
+        const UniValue& ret = listtransactions(request);
+        assert(ret.size() == 100);
+    }
+}
+
+// Full rescan of the chain (WALLET_CHAIN_HEIGHT blocks, RESCAN_FAN_OUT + 1 outputs to the wallet each)
+static void WalletRescan(benchmark::State& state)
+{
+    LargeWalletSetup setup(GetWalletBenchTxs());
+    CBlockIndex* pindexGenesis = WITH_LOCK(cs_main, return chainActive.Genesis());
+    while (state.KeepRunning()) {
+        WalletRescanReserver reserver(setup.pwallet.get());
+        reserver.reserve();
+        if (setup.pwallet->ScanForWalletTransactions(pindexGenesis, nullptr, reserver, true) != nullptr) {
+            state.SkipWithError("rescan failed");
+            return;
+        }
+    }
+}
+
+BENCHMARK(WalletLoad);
+BENCHMARK(WalletGetBalance);
+BENCHMARK(WalletAvailableCoins);
+BENCHMARK(WalletStakeableCoins);
+BENCHMARK(WalletSelectCoins);
+BENCHMARK(WalletIncrementNoteWitnesses);
+BENCHMARK(WalletListTransactions);
+BENCHMARK(WalletRescan);
@@ -1143,7 +1143,7 @@ bool CBudgetManager::ProcessFinalizedBudgetVote(CFinalizedBudgetVote& vote, CNod
     return true;
 }
 
-void CBudgetManager::ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv)
+void CBudgetManager::ProcessMessage(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv)
 {
     int banScore = ProcessMessageInner(pfrom, strCommand, vRecv);
     if (banScore > 0) {
@@ -1152,7 +1152,7 @@ void CBudgetManager::ProcessMessage(CNode* pfrom, std::string& strCommand, CData
     }
 }
 
-int CBudgetManager::ProcessMessageInner(CNode* pfrom, std::string& strCommand, CDataStream& vRecv)
+int CBudgetManager::ProcessMessageInner(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv)
 {
     // lite mode is not supported
     if (fLiteMode) return 0;
@@ -92,9 +92,9 @@ public:
     void SetBestHeight(int height) { nBestHeight.store(height, std::memory_order_release); };
     int GetBestHeight() const { return nBestHeight.load(std::memory_order_acquire); }
 
-    void ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+    void ProcessMessage(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv);
     /// Process the message and returns the ban score (0 if no banning is needed)
-    int ProcessMessageInner(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+    int ProcessMessageInner(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv);
     void NewBlock(int height);
 
     int ProcessBudgetVoteSync(const uint256& nProp, CNode* pfrom);
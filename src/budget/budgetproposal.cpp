@@ -48,7 +48,7 @@ CBudgetProposal::CBudgetProposal(const std::string& name,
 }
 
 // initialize from network broadcast message
-bool CBudgetProposal::ParseBroadcast(CDataStream& broadcast)
+bool CBudgetProposal::ParseBroadcast(CPooledDataStream& broadcast)
 {
     *this = CBudgetProposal();
     try {
@@ -37,7 +37,7 @@ CFinalizedBudget::CFinalizedBudget(const std::string& name,
         nTime(0)
 { }
 
-bool CFinalizedBudget::ParseBroadcast(CDataStream& broadcast)
+bool CFinalizedBudget::ParseBroadcast(CPooledDataStream& broadcast)
 {
     *this = CFinalizedBudget();
     try {
@@ -121,7 +121,7 @@ public:
     }
 
     // Serialization for network messages.
-    bool ParseBroadcast(CDataStream& broadcast);
+    bool ParseBroadcast(CPooledDataStream& broadcast);
     CDataStream GetBroadcast() const;
     void Relay();
 
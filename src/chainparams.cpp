@@ -170,6 +170,7 @@ public:
         // validation by-pass
         consensus.nPivxBadBlockTime = 1471401614;    // Skip nBit validation of Block 259201 per PR #915
         consensus.nPivxBadBlockBits = 0x1c056dac;    // Skip nBit validation of Block 259201 per PR #915
+        consensus.defaultAssumeValid = uint256S("0x580a26ff0a45177a7a6f387f009c5b26140ea48b4790a857d9a796f8b3c25899"); // 2678402
 
         // Zerocoin-related params
         consensus.ZC_Modulus = "25195908475657893494027183240048398571429282126204032027777137836043662020707595556264018525880784"
@@ -311,6 +312,9 @@ public:
         consensus.height_ZC_RecalcAccumulators = 999999999;
         consensus.ZC_HeightStart = 0;
 
+        // validation by-pass
+        consensus.defaultAssumeValid = UINT256_ZERO;
+
         // Zerocoin-related params
         consensus.ZC_Modulus = "25195908475657893494027183240048398571429282126204032027777137836043662020707595556264018525880784"
                 "4069182906412495150821892985591491761845028084891200728449926873928072877767359714183472702618963750149718246911"
@@ -440,6 +444,9 @@ public:
         consensus.height_last_ZC_WrappedSerials = -1;
         consensus.height_ZC_RecalcAccumulators = 999999999;
 
+        // validation by-pass
+        consensus.defaultAssumeValid = UINT256_ZERO;
+
         // Zerocoin-related params
         consensus.ZC_Modulus = "25195908475657893494027183240048398571429282126204032027777137836043662020707595556264018525880784"
                 "4069182906412495150821892985591491761845028084891200728449926873928072877767359714183472702618963750149718246911"
@@ -84,6 +84,30 @@ int GetTotalBlocksEstimate()
     return checkpoints.rbegin()->first;
 }
 
+uint256 GetLastCheckpointHash()
+{
+    if (!fEnabled)
+        return UINT256_ZERO;
+
+    const MapCheckpoints& checkpoints = *Params().Checkpoints().mapCheckpoints;
+
+    return checkpoints.rbegin()->second;
+}
+
+int GetCheckpointHeight(const uint256& hash)
+{
+    if (!fEnabled)
+        return -1;
+
+    const MapCheckpoints& checkpoints = *Params().Checkpoints().mapCheckpoints;
+
+    for (const MapCheckpoints::value_type& i : checkpoints) {
+        if (i.second == hash)
+            return i.first;
+    }
+    return -1;
+}
+
 CBlockIndex* GetLastCheckpoint()
 {
     if (!fEnabled)
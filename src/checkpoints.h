@@ -33,6 +33,12 @@ bool CheckBlock(int nHeight, const uint256& hash, bool fMatchesCheckpoint = fals
 //! Return conservative estimate of total number of blocks, 0 if unknown
 int GetTotalBlocksEstimate();
 
+//! Return the height of the checkpoint with the given hash, -1 if it isn't a checkpoint
+int GetCheckpointHeight(const uint256& hash);
+
+//! Return the hash of the last checkpoint, null if checkpoints are disabled
+uint256 GetLastCheckpointHash();
+
 //! Returns last CBlockIndex* in mapBlockIndex that is a checkpoint
 CBlockIndex* GetLastCheckpoint();
 
@@ -6,9 +6,13 @@
 #define BITCOIN_CHECKQUEUE_H
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <thread>
 #include <vector>
 
 #include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
 
 template <typename T>
@@ -23,12 +27,36 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every worker owns a deque: the master spreads the checks over them,
+  * each worker consumes its own deque from the back and, once empty,
+  * steals from the front of the others. The per-deque locks are only
+  * contended by a stealer, and the shared mutex is only taken to sleep
+  * and wake up: out of work, a thread spins for a while before blocking.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    //! Maximum number of worker deques (more workers share them)
+    static const int MAX_WORKERS = 64;
+
+    //! Rounds spent looking for work before blocking
+    static const int SPIN_ROUNDS = 64;
+
+    struct WorkerQueue {
+        boost::mutex cs;
+        std::deque<T> checks;
+        //! Size of checks, readable without the lock (to skip empty deques)
+        std::atomic<size_t> nSize{0};
+        //! Keep the deques of different workers on different cache lines
+        char padding[64];
+    };
+
+    //! Deques of the master (index 0) and of the workers (1..MAX_WORKERS)
+    std::vector<WorkerQueue> vQueues;
+
+    //! Mutex protecting the sleep/wake-up of the threads
     boost::mutex mutex;
 
     //! Worker threads block on this when out of work
@@ -37,122 +65,199 @@ private:
     //! Master thread blocks on this when out of work
     boost::condition_variable condMaster;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue;
+    //! The number of worker threads registered (excluding the master).
+    std::atomic<int> nWorkers;
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle;
+    //! The number of worker threads blocked on condWorker.
+    std::atomic<int> nSleeping;
 
-    //! The total number of workers (including the master).
-    int nTotal;
+    //! Number of checks sitting in the deques (can be transiently off by in-flight moves).
+    std::atomic<int64_t> nQueued;
 
     //! The temporary evaluation result.
-    bool fAllOk;
+    std::atomic<bool> fAllOk;
 
     /**
      * Number of verifications that haven't completed yet.
-     * This includes elements that are not anymore in queue, but still in
+     * This includes elements that are not anymore in a deque, but still in
      * worker's own batches.
      */
-    unsigned int nTodo;
-
-    //! Whether we're shutting down.
-    bool fQuit;
+    std::atomic<unsigned int> nTodo;
 
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
+    //! Next worker deque to receive checks (only used by the master)
+    int nNextQueue;
+
+    //! Counts a worker in nSleeping for its lifetime
+    struct SleepingCounter {
+        std::atomic<int>& n;
+        explicit SleepingCounter(std::atomic<int>& nIn) : n(nIn) { n++; }
+        ~SleepingCounter() { n--; }
+    };
+
+    int ActiveQueues() const
+    {
+        return 1 + std::min(nWorkers.load(), MAX_WORKERS);
+    }
+
+    /**
+     * Move a batch of checks out of a deque: from the back of our own deque, from the
+     * front when stealing. Take half of what is there (bounded by nBatchSize), leaving
+     * the rest to the others.
+     */
+    bool Take(WorkerQueue& wq, std::vector<T>& vChecks, bool fSteal)
+    {
+        if (wq.nSize.load(std::memory_order_relaxed) == 0)
+            return false;
+        boost::unique_lock<boost::mutex> lock(wq.cs, boost::defer_lock);
+        if (fSteal) {
+            // don't queue up behind the owner or another thief
+            if (!lock.try_lock())
+                return false;
+        } else {
+            lock.lock();
+        }
+        const size_t nSize = wq.checks.size();
+        if (nSize == 0)
+            return false;
+        const size_t nNow = std::max<size_t>(1, std::min<size_t>(nBatchSize, nSize / 2));
+        vChecks.resize(nNow);
+        for (size_t i = 0; i < nNow; i++) {
+            if (fSteal) {
+                vChecks[i].swap(wq.checks.front());
+                wq.checks.pop_front();
+            } else {
+                vChecks[i].swap(wq.checks.back());
+                wq.checks.pop_back();
+            }
+        }
+        wq.nSize.store(wq.checks.size(), std::memory_order_relaxed);
+        lock.unlock();
+        nQueued -= nNow;
+        return true;
+    }
+
+    /** Look for work: in our own deque first, then in the others' (starting from the next one). */
+    bool TakeWork(int nQueue, std::vector<T>& vChecks)
+    {
+        if (Take(vQueues[nQueue], vChecks, false))
+            return true;
+        const int nActive = ActiveQueues();
+        for (int i = 1; i < nActive; i++) {
+            if (Take(vQueues[(nQueue + i) % nActive], vChecks, true))
+                return true;
+        }
+        return false;
+    }
+
+    /** Block until there is something to do: new checks for the workers, the end of the round for the master. */
+    void Sleep(bool fMaster)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (fMaster) {
+            while (nTodo > 0 && nQueued <= 0)
+                condMaster.wait(lock);
+        } else {
+            // Pairs with Add(): either it sees us sleeping, or we see its checks.
+            // The wait is an interruption point: leave the count right if it throws.
+            SleepingCounter counter(nSleeping);
+            while (nQueued <= 0)
+                condWorker.wait(lock);
+        }
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster = false)
+    bool Loop(int nQueue, bool fMaster = false)
     {
-        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
+        int nSpins = 0;
         do {
-            {
-                boost::unique_lock<boost::mutex> lock(mutex);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master he can exit and return the result
-                        condMaster.notify_one();
+            if (fMaster && nTodo == 0) {
+                // reset the status for new work later, and return the current one
+                return fAllOk.exchange(true);
+            }
+            if (!TakeWork(nQueue, vChecks)) {
+                if (++nSpins < SPIN_ROUNDS) {
+                    std::this_thread::yield();
                 } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty()) {
-                    if ((fMaster || fQuit) && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        if (fMaster)
-                            fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
+                    nSpins = 0;
+                    Sleep(fMaster);
                 }
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
-                }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                continue;
             }
+            nSpins = 0;
+            // Check whether we need to do work at all
+            const unsigned int nNow = vChecks.size();
+            bool fOk = fAllOk;
             // execute work
             for (T& check : vChecks)
                 if (fOk)
                     fOk = check();
             vChecks.clear();
+            if (!fOk)
+                fAllOk = false;
+            if (nTodo.fetch_sub(nNow) == nNow && !fMaster) {
+                // We processed the last element; inform the master he can exit and return the result
+                boost::unique_lock<boost::mutex> lock(mutex);
+                condMaster.notify_one();
+            }
         } while (true);
     }
 
 public:
     //! Create a new check queue
-    CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), fQuit(false), nBatchSize(nBatchSizeIn) {}
+    CCheckQueue(unsigned int nBatchSizeIn) : vQueues(MAX_WORKERS + 1), nWorkers(0), nSleeping(0), nQueued(0), fAllOk(true), nTodo(0), nBatchSize(nBatchSizeIn), nNextQueue(0) {}
 
     //! Worker thread
     void Thread()
     {
-        Loop();
+        const int nWorker = nWorkers++;
+        Loop(1 + nWorker % MAX_WORKERS);
     }
 
     //! Wait until execution finishes, and return whether all evaluations where successful.
     bool Wait()
     {
-        return Loop(true);
+        return Loop(0, true);
     }
 
     //! Add a batch of checks to the queue
     void Add(std::vector<T>& vChecks)
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        for (T& check : vChecks) {
-            queue.push_back(T());
-            check.swap(queue.back());
-        }
+        if (vChecks.empty())
+            return;
         nTodo += vChecks.size();
-        if (vChecks.size() == 1)
-            condWorker.notify_one();
-        else if (vChecks.size() > 1)
-            condWorker.notify_all();
+        // Spread the checks over the worker deques, in chunks, round-robin.
+        // Without workers, everything goes to the master's deque.
+        const int nActive = ActiveQueues();
+        const size_t nChunk = nActive > 1 ? (vChecks.size() + nActive - 2) / (nActive - 1) : vChecks.size();
+        size_t nChunks = 0;
+        for (size_t nPos = 0; nPos < vChecks.size(); nPos += nChunk, nChunks++) {
+            if (nActive > 1)
+                nNextQueue = 1 + nNextQueue % (nActive - 1);
+            WorkerQueue& wq = vQueues[nActive > 1 ? nNextQueue : 0];
+            const size_t nEnd = std::min(vChecks.size(), nPos + nChunk);
+            {
+                boost::lock_guard<boost::mutex> lock(wq.cs);
+                for (size_t i = nPos; i < nEnd; i++) {
+                    wq.checks.emplace_back();
+                    vChecks[i].swap(wq.checks.back());
+                }
+                wq.nSize.store(wq.checks.size(), std::memory_order_relaxed);
+            }
+            nQueued += nEnd - nPos;
+        }
+        // Wake up sleepers (spinning workers will find the checks on their own)
+        if (nSleeping > 0) {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (nChunks == 1)
+                condWorker.notify_one();
+            else
+                condWorker.notify_all();
+        }
     }
 
     ~CCheckQueue()
@@ -161,8 +266,7 @@ public:
 
     bool IsIdle()
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        return (nTotal == nIdle && nTodo == 0 && fAllOk == true);
+        return (nTodo == 0 && nQueued == 0 && fAllOk == true);
     }
 };
 
@@ -12,6 +12,7 @@
 #include "memusage.h"
 #include "random.h"
 
+#include <algorithm>
 #include <assert.h>
 
 bool CCoinsView::GetCoin(const COutPoint& outpoint, Coin& coin) const { return false; }
@@ -55,7 +56,7 @@ uint256 CCoinsViewBacked::GetBestAnchor() const { return base->GetBestAnchor();
 SaltedOutpointHasher::SaltedOutpointHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
 SaltedIdHasher::SaltedIdHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
 
-CCoinsViewCache::CCoinsViewCache(CCoinsView *baseIn) : CCoinsViewBacked(baseIn), cachedCoinsUsage(0) {}
+CCoinsViewCache::CCoinsViewCache(CCoinsView *baseIn) : CCoinsViewBacked(baseIn), cachedCoinsUsage(0), nAccessClock(0) {}
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
     return memusage::DynamicUsage(cacheCoins) +
@@ -67,8 +68,10 @@ size_t CCoinsViewCache::DynamicMemoryUsage() const {
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint& outpoint) const
 {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
-    if (it != cacheCoins.end())
+    if (it != cacheCoins.end()) {
+        Touch(it->second);
         return it;
+    }
     Coin tmp;
     if (!base->GetCoin(outpoint, tmp))
         return cacheCoins.end();
@@ -78,6 +81,7 @@ CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint& outpoint) const
         // version as fresh.
         ret->second.flags = CCoinsCacheEntry::FRESH;
     }
+    Touch(ret->second);
     cachedCoinsUsage += memusage::DynamicUsage(ret->second.coin);
     return ret;
 }
@@ -111,6 +115,7 @@ void CCoinsViewCache::AddCoin(const COutPoint& outpoint, Coin&& coin, bool possi
     }
     it->second.coin = std::move(coin);
     it->second.flags |= CCoinsCacheEntry::DIRTY | (fresh ? CCoinsCacheEntry::FRESH : 0);
+    Touch(it->second);
     cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
 }
 
@@ -262,6 +267,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap& mapCoins,
                     // and already exist in the grandparent
                     if (it->second.flags & CCoinsCacheEntry::FRESH)
                         entry.flags |= CCoinsCacheEntry::FRESH;
+                    Touch(entry);
                 }
             } else {
                 // Assert that the child cache entry was not marked FRESH if the
@@ -284,6 +290,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap& mapCoins,
                     itUs->second.coin = std::move(it->second.coin);
                     cachedCoinsUsage += memusage::DynamicUsage(itUs->second.coin);
                     itUs->second.flags |= CCoinsCacheEntry::DIRTY;
+                    Touch(itUs->second);
                     // NOTE: It is possible the child has a FRESH flag here in
                     // the event the entry we found in the parent is pruned. But
                     // we must not copy that FRESH flag to the parent as that
@@ -319,6 +326,112 @@ bool CCoinsViewCache::Flush()
     return fOk;
 }
 
+// Index of the age bucket of a cache entry: the number of significant bits of its age
+static inline int AgeBucket(uint64_t nAge)
+{
+    int nBucket = 0;
+    while (nAge) {
+        nAge >>= 1;
+        nBucket++;
+    }
+    return nBucket;
+}
+
+bool CCoinsViewCache::Sync(size_t nTargetUsage, size_t nMaxCopyUsage)
+{
+    static const int AGE_BUCKETS = 65;
+    const size_t nEntryUsage = memusage::MallocUsage(sizeof(memusage::unordered_node<CCoinsMap::value_type>));
+
+    // Usage of the entries that survive the write (spent entries have nothing left to
+    // serve and are dropped), bucketed by (log2) age for the eviction, and of the dirty ones
+    // among them, for the copies.
+    size_t vBucketUsage[AGE_BUCKETS] = {};
+    size_t vBucketDirtyUsage[AGE_BUCKETS] = {};
+    size_t nUsage = memusage::DynamicUsage(cacheCoins);
+    for (const auto& it : cacheCoins) {
+        if (it.second.coin.IsSpent()) {
+            nUsage -= nEntryUsage;
+            continue;
+        }
+        const size_t nCoinUsage = it.second.coin.DynamicMemoryUsage();
+        const int nBucket = AgeBucket(nAccessClock - it.second.nLastAccess);
+        vBucketUsage[nBucket] += nEntryUsage + nCoinUsage;
+        if (it.second.flags & CCoinsCacheEntry::DIRTY) {
+            vBucketDirtyUsage[nBucket] += nEntryUsage + nCoinUsage;
+        }
+        nUsage += nCoinUsage;
+    }
+
+    // The coldest entries go: all the ones older than the cutoff bucket, and as many
+    // of the cutoff bucket itself as needed to get down to the target.
+    int nCutoff = AGE_BUCKETS;
+    size_t nCutoffToEvict = 0;
+    if (nUsage > nTargetUsage) {
+        const size_t nToEvict = nUsage - nTargetUsage;
+        size_t nOlder = 0;
+        nCutoff = AGE_BUCKETS - 1;
+        while (nCutoff > 0 && nOlder + vBucketUsage[nCutoff] < nToEvict) {
+            nOlder += vBucketUsage[nCutoff--];
+        }
+        nCutoffToEvict = nToEvict - nOlder;
+    }
+
+    // The dirty entries that stay are copied, the most recent first: the dirty entries older
+    // than the copy cutoff bucket, and those of the bucket beyond the budget, are evicted.
+    int nCopyCutoff = 0;
+    size_t nCopyBudget = nMaxCopyUsage;
+    while (nCopyCutoff < nCutoff && vBucketDirtyUsage[nCopyCutoff] <= nCopyBudget) {
+        nCopyBudget -= vBucketDirtyUsage[nCopyCutoff++];
+    }
+
+    // Hand the dropped entries over to the write (moved, as Flush() does with the whole
+    // map) before copying the dirty entries that stay cached, within nMaxCopyUsage: the
+    // copies are the only memory the write adds to the cache.
+    CCoinsMap mapWrite;
+    cachedCoinsUsage = 0;
+    for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end();) {
+        const int nBucket = AgeBucket(nAccessClock - it->second.nLastAccess);
+        const size_t nCoinUsage = it->second.coin.DynamicMemoryUsage();
+        bool fEvict = it->second.coin.IsSpent() || nBucket > nCutoff;
+        if (!fEvict && nBucket == nCutoff && nCutoffToEvict > 0) {
+            nCutoffToEvict -= std::min(nCutoffToEvict, nEntryUsage + nCoinUsage);
+            fEvict = true;
+        }
+        if (!fEvict && (it->second.flags & CCoinsCacheEntry::DIRTY) && nBucket >= nCopyCutoff) {
+            fEvict = nBucket > nCopyCutoff || nCopyBudget < nEntryUsage + nCoinUsage;
+            if (!fEvict) nCopyBudget -= nEntryUsage + nCoinUsage;
+        }
+        if (!fEvict) {
+            cachedCoinsUsage += nCoinUsage;
+            ++it;
+            continue;
+        }
+        if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+            mapWrite.emplace(it->first, std::move(it->second));
+        }
+        it = cacheCoins.erase(it);
+    }
+    for (auto& it : cacheCoins) {
+        if (it.second.flags & CCoinsCacheEntry::DIRTY) {
+            mapWrite.emplace(it.first, it.second);
+            it.second.flags = 0;
+        }
+    }
+    // Give back the buckets of the evicted entries, or the usage stays inflated
+    if (cacheCoins.bucket_count() > 2 * cacheCoins.size()) {
+        cacheCoins.rehash(0);
+    }
+
+    bool fOk = base->BatchWrite(mapWrite,
+            hashBlock,
+            hashSaplingAnchor,
+            cacheSaplingAnchors,
+            cacheSaplingNullifiers);
+    cacheSaplingAnchors.clear();
+    cacheSaplingNullifiers.clear();
+    return fOk;
+}
+
 void CCoinsViewCache::Uncache(const COutPoint& outpoint)
 {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
@@ -352,6 +465,15 @@ CAmount CCoinsViewCache::GetValueIn(const CTransaction& tx) const
     return nResult;
 }
 
+void CCoinsViewCache::PrefetchCoins(std::vector<COutPoint>& vOutpoints) const
+{
+    std::sort(vOutpoints.begin(), vOutpoints.end());
+    cacheCoins.reserve(cacheCoins.size() + vOutpoints.size());
+    for (const COutPoint& outpoint : vOutpoints) {
+        FetchCoin(outpoint);
+    }
+}
+
 bool CCoinsViewCache::HaveInputs(const CTransaction& tx) const
 {
     if (!tx.IsCoinBase() && !tx.HasZerocoinSpendInputs()) {
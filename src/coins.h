@@ -18,6 +18,7 @@
 #include <assert.h>
 #include <stdint.h>
 
+#include <limits>
 #include <unordered_map>
 
 /**
@@ -133,14 +134,15 @@ public:
 struct CCoinsCacheEntry {
     Coin coin; // The actual cached data.
     unsigned char flags;
+    uint64_t nLastAccess; // Access clock of the owning cache at the last use (fits in the malloc size class of the map node).
 
     enum Flags {
         DIRTY = (1 << 0), // This cache entry is potentially different from the version in the parent view.
         FRESH = (1 << 1), // The parent view does not have this entry (or it is pruned).
     };
 
-    CCoinsCacheEntry() : flags(0) {}
-    explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0) {}
+    CCoinsCacheEntry() : flags(0), nLastAccess(0) {}
+    explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0), nLastAccess(0) {}
 };
 
 // Sapling
@@ -297,6 +299,9 @@ protected:
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage;
 
+    /* Incremented at every access to a coin, used to find the cold entries in Sync(). */
+    mutable uint64_t nAccessClock;
+
 public:
     CCoinsViewCache(CCoinsView *baseIn);
 
@@ -365,6 +370,18 @@ public:
      */
     bool Flush();
 
+    /**
+     * Push the modifications applied to this cache to its base, like Flush(), but keep
+     * the cache warm: the written entries stay cached (no longer dirty), and only the
+     * least recently used entries are evicted (after being written, if dirty), until the
+     * memory usage of the cache is at most nTargetUsage. Spent entries are always dropped.
+     * The dirty entries that stay cached are copied for the write, the others are moved: the
+     * copies use at most nMaxCopyUsage, the least recently used dirty entries beyond that are
+     * evicted too.
+     * If false is returned, the state of this cache (and its backing view) will be undefined.
+     */
+    bool Sync(size_t nTargetUsage = std::numeric_limits<size_t>::max(), size_t nMaxCopyUsage = std::numeric_limits<size_t>::max());
+
     /**
      * Removes the UTXO with the given outpoint from the cache, if it is not modified.
      */
@@ -389,6 +406,14 @@ public:
     //! Check whether all prevouts of the transaction are present in the UTXO set represented by this view
     bool HaveInputs(const CTransaction& tx) const;
 
+    /**
+     * Load into this cache, in a single pass, the coins of the given outpoints (e.g. all the
+     * coins spent by a block), before they are looked up one tx at a time.
+     * The outpoints are sorted first, so that the coins missing from the parent caches are read
+     * from the database in key order. Outpoints without an unspent coin are skipped.
+     */
+    void PrefetchCoins(std::vector<COutPoint>& vOutpoints) const;
+
     /**
      * Return priority of tx at height nHeight. Also calculate the sum of the values of the inputs
      * that are already in the chain.  These are the inputs that will age and increase priority as
@@ -415,6 +440,9 @@ public:
 private:
     CCoinsMap::iterator FetchCoin(const COutPoint& outpoint) const;
 
+    //! Mark the entry as the most recently used one
+    void Touch(CCoinsCacheEntry& entry) const { entry.nLastAccess = ++nAccessClock; }
+
     //! Generalized interface for popping anchors
     template<typename Tree, typename Cache, typename CacheEntry>
     void AbstractPopAnchor(
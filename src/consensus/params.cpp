@@ -5,7 +5,10 @@
 
 #include "consensus/params.h"
 #include "consensus/upgrades.h"
+#include "libzerocoin/PrecomputedParams.h"
+#include "streams.h"
 #include "util/system.h"
+#include "version.h"
 
 namespace Consensus {
 
@@ -22,4 +25,39 @@ bool Params::NetworkUpgradeActive(int nHeight, Consensus::UpgradeIndex idx) cons
     return NetworkUpgradeState(nHeight, *this, idx) == UPGRADE_ACTIVE;
 }
 
+static libzerocoin::ZerocoinParams LoadZerocoinParams(const CBigNum& bnModulus, const unsigned char* pdata, size_t nSize)
+{
+    try {
+        CDataStream ss((const char*)pdata, (const char*)pdata + nSize, SER_NETWORK, PROTOCOL_VERSION);
+        libzerocoin::ZerocoinParams params;
+        ss >> params;
+        // The precomputed set is valid only for the modulus it was derived from
+        if (params.initialized && params.accumulatorParams.accumulatorModulus == bnModulus) {
+            return params;
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("%s: cannot load the precomputed zerocoin params: %s\n", __func__, e.what());
+    }
+    LogPrintf("%s: generating the zerocoin params\n", __func__);
+    return libzerocoin::ZerocoinParams(bnModulus);
+}
+
+libzerocoin::ZerocoinParams* Params::Zerocoin_Params(bool useModulusV1) const
+{
+    if (useModulusV1) {
+        static libzerocoin::ZerocoinParams ZCParamsHex = [this]() {
+            CBigNum bnHexModulus = 0;
+            bnHexModulus.SetHex(ZC_Modulus);
+            return LoadZerocoinParams(bnHexModulus, libzerocoin::zerocoin_params_hex, sizeof(libzerocoin::zerocoin_params_hex));
+        }();
+        return &ZCParamsHex;
+    }
+    static libzerocoin::ZerocoinParams ZCParamsDec = [this]() {
+        CBigNum bnDecModulus = 0;
+        bnDecModulus.SetDec(ZC_Modulus);
+        return LoadZerocoinParams(bnDecModulus, libzerocoin::zerocoin_params_dec, sizeof(libzerocoin::zerocoin_params_dec));
+    }();
+    return &ZCParamsDec;
+}
+
 } // End consensus namespace
@@ -125,6 +125,8 @@ struct Params {
     // validation by-pass
     int64_t nPivxBadBlockTime;
     unsigned int nPivxBadBlockBits;
+    // default -assumevalid block: signatures and proofs of its ancestors are not verified
+    uint256 defaultAssumeValid;
 
     // Map with network updates
     NetworkUpgrade vUpgrades[MAX_NETWORK_UPGRADES];
@@ -173,16 +175,12 @@ struct Params {
     int ZC_TimeStart;
     int ZC_HeightStart;
 
-    libzerocoin::ZerocoinParams* Zerocoin_Params(bool useModulusV1) const
-    {
-        static CBigNum bnHexModulus = 0;
-        if (!bnHexModulus) bnHexModulus.SetHex(ZC_Modulus);
-        static libzerocoin::ZerocoinParams ZCParamsHex = libzerocoin::ZerocoinParams(bnHexModulus);
-        static CBigNum bnDecModulus = 0;
-        if (!bnDecModulus) bnDecModulus.SetDec(ZC_Modulus);
-        static libzerocoin::ZerocoinParams ZCParamsDec = libzerocoin::ZerocoinParams(bnDecModulus);
-        return (useModulusV1 ? &ZCParamsHex : &ZCParamsDec);
-    }
+    /**
+     * The zerocoin parameters derived from ZC_Modulus, parsed as hex (v1) or as dec.
+     * They are loaded from the precomputed sets (libzerocoin/PrecomputedParams.h),
+     * and generated only if these don't match the modulus.
+     */
+    libzerocoin::ZerocoinParams* Zerocoin_Params(bool useModulusV1) const;
 
     /**
      * Returns true if the given network upgrade is active as of the given block
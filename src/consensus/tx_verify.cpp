@@ -126,15 +126,15 @@ bool CheckTransaction(const CTransaction& tx, CValidationState& state, bool fCol
     return true;
 }
 
-bool ContextualCheckTransaction(const CTransactionRef& tx, CValidationState& state, const CChainParams& chainparams, int nHeight, bool isMined, bool fIBD)
+bool ContextualCheckTransaction(const CTransactionRef& tx, CValidationState& state, const CChainParams& chainparams, int nHeight, bool isMined, bool fIBD, bool fCheckProofs)
 {
     // Dispatch to Sapling validator
-    if (!SaplingValidation::ContextualCheckTransaction(*tx, state, chainparams, nHeight, isMined, fIBD)) {
+    if (!SaplingValidation::ContextualCheckTransaction(*tx, state, chainparams, nHeight, isMined, fIBD, fCheckProofs)) {
         return false; // Failure reason has been set in validation state object
     }
 
     // Dispatch to ZerocoinTx validator
-    if (!ContextualCheckZerocoinTx(tx, state, chainparams.GetConsensus(), nHeight)) {
+    if (!ContextualCheckZerocoinTx(tx, state, chainparams.GetConsensus(), nHeight, fCheckProofs)) {
         return false; // Failure reason has been set in validation state object
     }
 
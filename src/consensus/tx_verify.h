@@ -19,8 +19,8 @@ class CValidationState;
 
 /** Context-independent validity checks */
 bool CheckTransaction(const CTransaction& tx, CValidationState& state, bool fColdStakingActive);
-/** Context-dependent validity checks */
-bool ContextualCheckTransaction(const CTransactionRef& tx, CValidationState& state, const CChainParams& chainparams, int nHeight, bool isMined, bool fIBD);
+/** Context-dependent validity checks (fCheckProofs=false skips the zerocoin signatures and Sapling proofs) */
+bool ContextualCheckTransaction(const CTransactionRef& tx, CValidationState& state, const CChainParams& chainparams, int nHeight, bool isMined, bool fIBD, bool fCheckProofs = true);
 
 /**
  * Count ECDSA signature operations the old-fashioned (pre-0.6) way
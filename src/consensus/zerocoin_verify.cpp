@@ -17,7 +17,7 @@
 #include "zpiv/zpivmodule.h"
 
 
-static bool CheckZerocoinSpend(const CTransactionRef _tx, CValidationState& state)
+static bool CheckZerocoinSpend(const CTransactionRef _tx, CValidationState& state, bool fCheckSigs)
 {
     const CTransaction& tx = *_tx;
     //max needed non-mint outputs should be 2 - one for redemption address and a possible 2nd for change
@@ -81,7 +81,7 @@ static bool CheckZerocoinSpend(const CTransactionRef _tx, CValidationState& stat
         if (isPublicSpend) {
             libzerocoin::ZerocoinParams* params = consensus.Zerocoin_Params(false);
             PublicCoinSpend ret(params);
-            if (!ZPIVModule::validateInput(txin, prevOut, tx, ret)){
+            if (!ZPIVModule::validateInput(txin, prevOut, tx, ret, fCheckSigs)){
                 return state.DoS(100, error("%s: public zerocoin spend did not verify", __func__));
             }
         }
@@ -135,7 +135,7 @@ bool CheckPublicCoinSpendVersion(int version) {
     return version == CurrentPublicCoinSpendVersion();
 }
 
-bool ContextualCheckZerocoinTx(const CTransactionRef& tx, CValidationState& state, const Consensus::Params& consensus, int nHeight)
+bool ContextualCheckZerocoinTx(const CTransactionRef& tx, CValidationState& state, const Consensus::Params& consensus, int nHeight, bool fCheckSigs)
 {
     // zerocoin enforced via block time. First block with a zc mint is 863735
     const bool fZerocoinEnforced = (nHeight >= consensus.ZC_HeightStart);
@@ -180,7 +180,7 @@ bool ContextualCheckZerocoinTx(const CTransactionRef& tx, CValidationState& stat
     }
 
     if (hasPrivateSpendInputs || hasPublicSpendInputs) {
-        if (!CheckZerocoinSpend(tx, state))
+        if (!CheckZerocoinSpend(tx, state, fCheckSigs))
             return false;   // failure reason logged in validation state
     }
 
@@ -194,9 +194,9 @@ bool ContextualCheckZerocoinTx(const CTransactionRef& tx, CValidationState& stat
     return true;
 }
 
-bool ContextualCheckZerocoinSpend(const CTransaction& tx, const libzerocoin::CoinSpend* spend, int nHeight, const uint256& hashBlock)
+bool ContextualCheckZerocoinSpend(const CTransaction& tx, const libzerocoin::CoinSpend* spend, int nHeight, const uint256& hashBlock, bool fCheckSigs)
 {
-    if(!ContextualCheckZerocoinSpendNoSerialCheck(tx, spend, nHeight, hashBlock)){
+    if(!ContextualCheckZerocoinSpendNoSerialCheck(tx, spend, nHeight, hashBlock, fCheckSigs)){
         return false;
     }
 
@@ -209,13 +209,13 @@ bool ContextualCheckZerocoinSpend(const CTransaction& tx, const libzerocoin::Coi
     return true;
 }
 
-bool ContextualCheckZerocoinSpendNoSerialCheck(const CTransaction& tx, const libzerocoin::CoinSpend* spend, int nHeight, const uint256& hashBlock)
+bool ContextualCheckZerocoinSpendNoSerialCheck(const CTransaction& tx, const libzerocoin::CoinSpend* spend, int nHeight, const uint256& hashBlock, bool fCheckSigs)
 {
     const Consensus::Params& consensus = Params().GetConsensus();
     //Check to see if the zPIV is properly signed
     if (consensus.NetworkUpgradeActive(nHeight, Consensus::UPGRADE_ZC_V2)) {
         try {
-            if (!spend->HasValidSignature())
+            if (fCheckSigs && !spend->HasValidSignature())
                 return error("%s: V2 zPIV spend does not have a valid signature\n", __func__);
         } catch (const libzerocoin::InvalidSerialException& e) {
             // Check if we are in the range of the attack
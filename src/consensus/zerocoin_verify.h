@@ -15,8 +15,9 @@ bool isBlockBetweenFakeSerialAttackRange(int nHeight);
 bool CheckPublicCoinSpendEnforced(int blockHeight, bool isPublicSpend);
 int CurrentPublicCoinSpendVersion();
 bool CheckPublicCoinSpendVersion(int version);
-bool ContextualCheckZerocoinTx(const CTransactionRef& tx, CValidationState& state, const Consensus::Params& consensus, int nHeight);
-bool ContextualCheckZerocoinSpend(const CTransaction& tx, const libzerocoin::CoinSpend* spend, int nHeight, const uint256& hashBlock);
-bool ContextualCheckZerocoinSpendNoSerialCheck(const CTransaction& tx, const libzerocoin::CoinSpend* spend, int nHeight, const uint256& hashBlock);
+// fCheckSigs=false skips the verification of the spend signatures (assumed-valid blocks)
+bool ContextualCheckZerocoinTx(const CTransactionRef& tx, CValidationState& state, const Consensus::Params& consensus, int nHeight, bool fCheckSigs = true);
+bool ContextualCheckZerocoinSpend(const CTransaction& tx, const libzerocoin::CoinSpend* spend, int nHeight, const uint256& hashBlock, bool fCheckSigs = true);
+bool ContextualCheckZerocoinSpendNoSerialCheck(const CTransaction& tx, const libzerocoin::CoinSpend* spend, int nHeight, const uint256& hashBlock, bool fCheckSigs = true);
 
 #endif //PIVX_CONSENSUS_ZEROCOIN_VERIFY_H
@@ -49,8 +49,8 @@ class CDBBatch
 private:
     leveldb::WriteBatch batch;
 
-    CDataStream ssKey;
-    CDataStream ssValue;
+    CPooledDataStream ssKey;
+    CPooledDataStream ssValue;
 
     size_t size_estimate;
 
@@ -76,11 +76,12 @@ public:
     }
 
     template <typename V>
-    void Write(const CDataStream& _ssKey, const V& value)
+    void Write(const CPooledDataStream& _ssKey, const V& value)
     {
         leveldb::Slice slKey(_ssKey.data(), _ssKey.size());
 
-        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        // The key and value buffers of the batch are reused (clear() keeps their capacity),
+        // so writing a record doesn't allocate
         ssValue.reserve(DBWRAPPER_PREALLOC_VALUE_SIZE);
         ssValue << value;
         leveldb::Slice slValue(ssValue.data(), ssValue.size());
@@ -107,7 +108,7 @@ public:
         ssKey.clear();
     }
 
-    void Erase(const CDataStream& _ssKey)
+    void Erase(const CPooledDataStream& _ssKey)
     {
         leveldb::Slice slKey(_ssKey.data(), _ssKey.size());
 
@@ -142,13 +143,13 @@ public:
 
     template<typename K> void Seek(const K& key)
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CPooledDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
         Seek(ssKey);
     }
 
-    void Seek(const CDataStream& ssKey)
+    void Seek(const CPooledDataStream& ssKey)
     {
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
         piter->Seek(slKey);
@@ -159,7 +160,7 @@ public:
     template<typename K> bool GetKey(K& key)
     {
         try {
-            CDataStream ssKey = GetKey();
+            CPooledDataStream ssKey = GetKey();
             ssKey >> key;
         } catch(const std::exception& e) {
             return false;
@@ -167,10 +168,10 @@ public:
         return true;
     }
 
-    CDataStream GetKey()
+    CPooledDataStream GetKey()
     {
         leveldb::Slice slKey = piter->key();
-        return CDataStream(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+        return CPooledDataStream(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
     }
 
     unsigned int GetKeySize()
@@ -182,7 +183,7 @@ public:
     {
         leveldb::Slice slValue = piter->value();
         try {
-            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CPooledDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
             ssValue >> value;
         } catch(const std::exception& e) {
             return false;
@@ -232,15 +233,15 @@ public:
     ~CDBWrapper();
 
     template <typename K>
-    bool ReadDataStream(const K& key, CDataStream& ssValue) const
+    bool ReadDataStream(const K& key, CPooledDataStream& ssValue) const
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CPooledDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
         return ReadDataStream(ssKey, ssValue);
     }
 
-    bool ReadDataStream(const CDataStream& ssKey, CDataStream& ssValue) const
+    bool ReadDataStream(const CPooledDataStream& ssKey, CPooledDataStream& ssValue) const
     {
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
 
@@ -252,7 +253,7 @@ public:
             LogPrintf("LevelDB read failure: %s\n", status.ToString());
             dbwrapper_private::HandleError(status);
         }
-        CDataStream ssValueTmp(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
+        CPooledDataStream ssValueTmp(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
         ssValue = std::move(ssValueTmp);
         return true;
     }
@@ -260,16 +261,16 @@ public:
     template <typename K, typename V>
     bool Read(const K& key, V& value) const
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CPooledDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
         return Read(ssKey, value);
     }
 
     template <typename V>
-    bool Read(const CDataStream& ssKey, V& value) const
+    bool Read(const CPooledDataStream& ssKey, V& value) const
     {
-        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        CPooledDataStream ssValue(SER_DISK, CLIENT_VERSION);
         if (!ReadDataStream(ssKey, ssValue)) {
             return false;
         }
@@ -292,13 +293,13 @@ public:
     template <typename K>
     bool Exists(const K& key) const
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CPooledDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
         return Exists(ssKey);
     }
 
-    bool Exists(const CDataStream& key) const
+    bool Exists(const CPooledDataStream& key) const
     {
         leveldb::Slice slKey(key.data(), key.size());
 
@@ -349,7 +350,7 @@ public:
     template<typename K>
     size_t EstimateSize(const K& key_begin, const K& key_end) const
     {
-        CDataStream ssKey1(SER_DISK, CLIENT_VERSION), ssKey2(SER_DISK, CLIENT_VERSION);
+        CPooledDataStream ssKey1(SER_DISK, CLIENT_VERSION), ssKey2(SER_DISK, CLIENT_VERSION);
         ssKey1.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey2.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey1 << key_begin;
@@ -368,7 +369,7 @@ public:
     template<typename K>
     void CompactRange(const K& key_begin, const K& key_end) const
     {
-        CDataStream ssKey1(SER_DISK, CLIENT_VERSION), ssKey2(SER_DISK, CLIENT_VERSION);
+        CPooledDataStream ssKey1(SER_DISK, CLIENT_VERSION), ssKey2(SER_DISK, CLIENT_VERSION);
         ssKey1.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey2.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey1 << key_begin;
@@ -399,7 +400,7 @@ private:
     // is advanced.
     typename CDBTransaction::WritesMap::iterator transactionIt;
     std::unique_ptr<ParentIterator> parentIt;
-    CDataStream parentKey;
+    CPooledDataStream parentKey;
     bool curIsParent{false};
 
 public:
@@ -425,7 +426,7 @@ public:
         Seek(CDBTransaction::KeyToDataStream(key));
     }
 
-    void Seek(const CDataStream& ssKey)
+    void Seek(const CPooledDataStream& ssKey)
     {
         transactionIt = transaction.writes.lower_bound(ssKey);
         parentIt->Seek(ssKey);
@@ -466,7 +467,7 @@ public:
         } else {
             try {
                 // TODO try to avoid this copy (we need a stream that allows reading from external buffers)
-                CDataStream ssKey = transactionIt->first;
+                CPooledDataStream ssKey = transactionIt->first;
                 ssKey >> key;
             } catch (const std::exception&) {
                 return false;
@@ -475,10 +476,10 @@ public:
         }
     }
 
-    CDataStream GetKey()
+    CPooledDataStream GetKey()
     {
         if (!Valid()) {
-            return CDataStream(SER_DISK, CLIENT_VERSION);
+            return CPooledDataStream(SER_DISK, CLIENT_VERSION);
         }
         if (curIsParent) {
             return parentIt->GetKey();
@@ -550,20 +551,20 @@ protected:
     ssize_t memoryUsage{0}; // signed, just in case we made an error in the calculations so that we don't get an overflow
 
     struct DataStreamCmp {
-        static bool less(const CDataStream& a, const CDataStream& b)
+        static bool less(const CPooledDataStream& a, const CPooledDataStream& b)
         {
             return std::lexicographical_compare(
                     (const uint8_t*)a.data(), (const uint8_t*)a.data() + a.size(),
                     (const uint8_t*)b.data(), (const uint8_t*)b.data() + b.size());
         }
-        bool operator()(const CDataStream& a, const CDataStream& b) const { return less(a, b); }
+        bool operator()(const CPooledDataStream& a, const CPooledDataStream& b) const { return less(a, b); }
     };
 
     struct ValueHolder {
         size_t memoryUsage;
         ValueHolder(size_t _memoryUsage) : memoryUsage(_memoryUsage) {}
         virtual ~ValueHolder() = default;
-        virtual void Write(const CDataStream& ssKey, CommitTarget &parent) = 0;
+        virtual void Write(const CPooledDataStream& ssKey, CommitTarget &parent) = 0;
     };
     typedef std::unique_ptr<ValueHolder> ValueHolderPtr;
 
@@ -571,7 +572,7 @@ protected:
     struct ValueHolderImpl : ValueHolder {
         ValueHolderImpl(const V &_value, size_t _memoryUsage) : ValueHolder(_memoryUsage), value(_value) {}
 
-        virtual void Write(const CDataStream& ssKey, CommitTarget &commitTarget)
+        virtual void Write(const CPooledDataStream& ssKey, CommitTarget &commitTarget)
         {
             // we're moving the value instead of copying it. This means that Write() can only be called once per
             // ValueHolderImpl instance. Commit() clears the write maps, so this ok.
@@ -581,16 +582,16 @@ protected:
     };
 
     template<typename K>
-    static CDataStream KeyToDataStream(const K& key)
+    static CPooledDataStream KeyToDataStream(const K& key)
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CPooledDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
         return ssKey;
     }
 
-    typedef std::map<CDataStream, ValueHolderPtr, DataStreamCmp> WritesMap;
-    typedef std::set<CDataStream, DataStreamCmp> DeletesSet;
+    typedef std::map<CPooledDataStream, ValueHolderPtr, DataStreamCmp> WritesMap;
+    typedef std::set<CPooledDataStream, DataStreamCmp> DeletesSet;
 
     WritesMap writes;
     DeletesSet deletes;
@@ -605,7 +606,7 @@ public:
     }
 
     template <typename V>
-    void Write(const CDataStream& ssKey, const V& v)
+    void Write(const CPooledDataStream& ssKey, const V& v)
     {
         auto valueMemoryUsage = ::GetSerializeSize(v, SER_DISK, CLIENT_VERSION);
         if (deletes.erase(ssKey)) {
@@ -627,7 +628,7 @@ public:
     }
 
     template <typename V>
-    bool Read(const CDataStream& ssKey, V& value)
+    bool Read(const CPooledDataStream& ssKey, V& value)
     {
         if (deletes.count(ssKey)) {
             return false;
@@ -652,7 +653,7 @@ public:
         return Exists(KeyToDataStream(key));
     }
 
-    bool Exists(const CDataStream& ssKey)
+    bool Exists(const CPooledDataStream& ssKey)
     {
         if (deletes.count(ssKey)) {
             return false;
@@ -671,7 +672,7 @@ public:
         return Erase(KeyToDataStream(key));
     }
 
-    void Erase(const CDataStream& ssKey)
+    void Erase(const CPooledDataStream& ssKey)
     {
         auto it = writes.find(ssKey);
         if (it != writes.end()) {
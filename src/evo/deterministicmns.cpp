@@ -12,6 +12,7 @@
 #include "key_io.h"
 #include "guiinterface.h"
 #include "masternode.h" // for MasternodeCollateralMinConf
+#include "masternode-collaterals.h"
 #include "masternodeman.h" // for mnodeman (!TODO: remove)
 #include "script/standard.h"
 #include "spork.h"
@@ -93,10 +94,10 @@ void CDeterministicMN::ToJson(UniValue& obj) const
     obj.pushKV("collateralIndex", (int)collateralOutpoint.n);
 
     std::string collateralAddressStr = "";
-    Coin coin;
-    if (GetUTXOCoin(collateralOutpoint, coin)) {
+    const CollateralStatus& collateral = g_collateralWatchSet.Lookup(collateralOutpoint);
+    if (collateral.IsUnspent()) {
         CTxDestination dest;
-        if (ExtractDestination(coin.out.scriptPubKey, dest)) {
+        if (ExtractDestination(collateral.out.scriptPubKey, dest)) {
             collateralAddressStr = EncodeDestination(dest);
         }
     }
@@ -553,6 +554,7 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
 
     // Don't hold cs while calling signals
     if (diff.HasChanges()) {
+        UpdateCollateralWatchSet(oldList, diff, false);
         GetMainSignals().NotifyMasternodeListChanged(false, oldList, diff);
         uiInterface.NotifyMasternodeListChanged(newList);
     }
@@ -590,6 +592,7 @@ bool CDeterministicMNManager::UndoBlock(const CBlock& block, const CBlockIndex*
     }
 
     if (diff.HasChanges()) {
+        UpdateCollateralWatchSet(prevList, diff, true);
         auto inversedDiff = curList.BuildDiff(prevList);
         GetMainSignals().NotifyMasternodeListChanged(true, curList, inversedDiff);
         uiInterface.NotifyMasternodeListChanged(prevList);
@@ -604,6 +607,39 @@ void CDeterministicMNManager::UpdatedBlockTip(const CBlockIndex* pindex)
     tipIndex = pindex;
 }
 
+void CDeterministicMNManager::UpdateCollateralWatchSet(const CDeterministicMNList& prevList, const CDeterministicMNListDiff& diff, bool fUndo)
+{
+    AssertLockNotHeld(cs);
+    // the collaterals of the removed masternodes are in the list before the diff
+    for (uint64_t internalId : diff.removedMns) {
+        const auto& dmn = prevList.GetMNByInternalId(internalId);
+        if (!dmn) continue;
+        if (fUndo) {
+            g_collateralWatchSet.Watch(dmn->collateralOutpoint, CCollateralWatchSet::DETERMINISTIC);
+        } else {
+            g_collateralWatchSet.Unwatch(dmn->collateralOutpoint, CCollateralWatchSet::DETERMINISTIC);
+        }
+    }
+    for (const auto& dmn : diff.addedMNs) {
+        if (fUndo) {
+            g_collateralWatchSet.Unwatch(dmn->collateralOutpoint, CCollateralWatchSet::DETERMINISTIC);
+        } else {
+            g_collateralWatchSet.Watch(dmn->collateralOutpoint, CCollateralWatchSet::DETERMINISTIC);
+        }
+    }
+}
+
+void CDeterministicMNManager::WatchCollaterals()
+{
+    AssertLockHeld(cs_main);
+    const CBlockIndex* pindexTip = chainActive.Tip();
+    if (!pindexTip) return;
+    const CDeterministicMNList& mnList = GetListForBlock(pindexTip);
+    mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+        g_collateralWatchSet.Watch(dmn->collateralOutpoint, CCollateralWatchSet::DETERMINISTIC);
+    });
+}
+
 bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const CBlockIndex* pindexPrev, CValidationState& _state, CDeterministicMNList& mnListRet, bool debugLogs)
 {
     AssertLockHeld(cs);
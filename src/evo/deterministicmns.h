@@ -582,6 +582,9 @@ public:
 
     void UpdatedBlockTip(const CBlockIndex* pindex);
 
+    // Add the collaterals of the masternodes registered at the chain tip to the collateral watch-set
+    void WatchCollaterals();
+
     // the returned list will not contain the correct block hash (we can't know it yet as the coinbase TX is not updated yet)
     bool BuildNewListFromBlock(const CBlock& block, const CBlockIndex* pindexPrev, CValidationState& state, CDeterministicMNList& mnListRet, bool debugLogs);
     void DecreasePoSePenalties(CDeterministicMNList& mnList);
@@ -600,6 +603,8 @@ public:
 
 private:
     void CleanupCache(int nHeight);
+    // Keep the collateral watch-set in sync with the diff of a connected (or disconnected, fUndo) block
+    void UpdateCollateralWatchSet(const CDeterministicMNList& prevList, const CDeterministicMNListDiff& diff, bool fUndo);
 };
 
 extern std::unique_ptr<CDeterministicMNManager> deterministicMNManager;
@@ -11,6 +11,7 @@ void EvoNotificationInterface::InitializeCurrentBlockTip()
 {
     LOCK(cs_main);
     UpdatedBlockTip(chainActive.Tip(), nullptr, IsInitialBlockDownload());
+    deterministicMNManager->WatchCollaterals();
 }
 
 void EvoNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
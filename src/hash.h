@@ -295,6 +295,7 @@ class CHashVerifier : public CHashWriter
 {
 private:
     Source* source;
+    size_t nReadSize{0};
 
 public:
     CHashVerifier(Source* source_) : CHashWriter(source_->GetType(), source_->GetVersion()), source(source_) {}
@@ -303,8 +304,12 @@ public:
     {
         source->read(pch, nSize);
         this->write(pch, nSize);
+        nReadSize += nSize;
     }
 
+    //! Number of bytes read (and hashed) so far
+    size_t GetReadSize() const { return nReadSize; }
+
     void ignore(size_t nSize)
     {
         char data[1024];
@@ -39,6 +39,7 @@
 #include "net_processing.h"
 #include "policy/feerate.h"
 #include "policy/policy.h"
+#include "recentblocks.h"
 #include "rpc/register.h"
 #include "rpc/server.h"
 #include "script/sigcache.h"
@@ -46,6 +47,7 @@
 #include "scheduler.h"
 #include "spork.h"
 #include "sporkdb.h"
+#include "support/bufferpool.h"
 #include "evo/deterministicmns.h"
 #include "evo/evodb.h"
 #include "txdb.h"
@@ -68,6 +70,7 @@
 
 #include <atomic>
 #include <fstream>
+#include <future>
 #include <stdint.h>
 #include <stdio.h>
 #include <memory>
@@ -439,6 +442,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-?", _("This help message"));
     strUsage += HelpMessageOpt("-version", _("Print version and exit"));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
+    strUsage += HelpMessageOpt("-assumevalid=<hex>", strprintf(_("If this block is in the chain assume that it and its ancestors are valid and skip their signature and proof verification (0 to verify all, default: %s, testnet: %s)"), defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), _("the last checkpoint")));
     strUsage += HelpMessageOpt("-blocksdir=<dir>", _("Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)"));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
     strUsage += HelpMessageOpt("-checkblocks=<n>", strprintf(_("How many blocks to check at startup (default: %u, 0 = all)"), DEFAULT_CHECKBLOCKS));
@@ -468,6 +472,7 @@ std::string HelpMessage(HelpMessageMode mode)
 #ifndef WIN32
     strUsage += HelpMessageOpt("-pid=<file>", strprintf(_("Specify pid file (default: %s)"), PIVX_PID_FILENAME));
 #endif
+    strUsage += HelpMessageOpt("-recentblockscache=<n>", strprintf(_("Keep the last connected blocks (and their undo data) in memory up to <n> megabytes, for reorgs (0 to disable, default: %u)"), DEFAULT_RECENT_BLOCKS_CACHE_MB));
     strUsage += HelpMessageOpt("-reindex-chainstate", _("Rebuild chain state from the currently indexed blocks"));
     strUsage += HelpMessageOpt("-reindex", _("Rebuild block chain index from current blk000??.dat files") + " " + _("on startup"));
     strUsage += HelpMessageOpt("-resync", _("Delete blockchain folders and resync from scratch") + " " + _("on startup"));
@@ -493,6 +498,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-maxconnections=<n>", strprintf(_("Maintain at most <n> connections to peers (default: %u)"), DEFAULT_MAX_PEER_CONNECTIONS));
     strUsage += HelpMessageOpt("-maxreceivebuffer=<n>", strprintf(_("Maximum per-connection receive buffer, <n>*1000 bytes (default: %u)"), DEFAULT_MAXRECEIVEBUFFER));
     strUsage += HelpMessageOpt("-maxsendbuffer=<n>", strprintf(_("Maximum per-connection send buffer, <n>*1000 bytes (default: %u)"), DEFAULT_MAXSENDBUFFER));
+    strUsage += HelpMessageOpt("-netrecvthreads=<n>", strprintf(_("Number of threads framing and checksumming the messages received from peers, 0 to do it in the socket thread (0 to %d, default: %d)"), MAX_NET_RECV_THREADS, DEFAULT_NET_RECV_THREADS));
     strUsage += HelpMessageOpt("-onion=<ip:port>", strprintf(_("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: %s)"), "-proxy"));
     strUsage += HelpMessageOpt("-onlynet=<net>", _("Only connect to nodes in network <net> (ipv4, ipv6 or onion)"));
     strUsage += HelpMessageOpt("-permitbaremultisig", strprintf(_("Relay non-P2SH multisig (default: %u)"), DEFAULT_PERMIT_BAREMULTISIG));
@@ -531,6 +537,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageGroup(_("Debugging/Testing options:"));
     strUsage += HelpMessageOpt("-uacomment=<cmt>", _("Append comment to the user agent string"));
     if (showDebug) {
+        strUsage += HelpMessageOpt("-capturemessages", strprintf("Capture all P2P messages to disk, in <datadir>/message_capture (default: %u)", DEFAULT_CAPTURE_MESSAGES));
         strUsage += HelpMessageOpt("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. Also sets -checkmempool (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkpoints", strprintf(_("Only accept block chain matching built-in checkpoints (default: %u)"), DEFAULT_CHECKPOINTS_ENABLED));
@@ -787,6 +794,54 @@ bool InitSanityCheck(void)
     return true;
 }
 
+namespace { // Timings of the startup phases
+
+    Mutex cs_startup_phases;
+    std::vector<StartupPhase> vStartupPhases GUARDED_BY(cs_startup_phases);
+    std::atomic<int64_t> nStartupBeginTime{0};
+    std::atomic<int64_t> nStartupDuration{-1};
+
+    /**
+     * Measures a startup phase, from its construction to Stop() (or destruction),
+     * logging it and recording it for the getstartupinfo RPC.
+     */
+    class StartupPhaseTimer
+    {
+    private:
+        const std::string name;
+        const bool fConcurrent;
+        const int64_t nStartTime;
+        bool fStopped{false};
+
+    public:
+        explicit StartupPhaseTimer(const std::string& nameIn, bool fConcurrentIn = false) :
+            name(nameIn), fConcurrent(fConcurrentIn), nStartTime(GetTimeMillis()) {}
+        ~StartupPhaseTimer() { Stop(); }
+
+        void Stop()
+        {
+            if (fStopped) return;
+            fStopped = true;
+            const int64_t nDuration = GetTimeMillis() - nStartTime;
+            LogPrintf("Startup phase %s completed in %dms%s\n", name, nDuration, fConcurrent ? " (concurrent)" : "");
+            LOCK(cs_startup_phases);
+            vStartupPhases.push_back({name, nStartTime - nStartupBeginTime, nDuration, fConcurrent});
+        }
+    };
+
+} // anon namespace
+
+std::vector<StartupPhase> GetStartupPhases()
+{
+    LOCK(cs_startup_phases);
+    return vStartupPhases;
+}
+
+int64_t GetStartupDuration()
+{
+    return nStartupDuration;
+}
+
 static void LoadSaplingParams()
 {
     struct timeval tv_start{}, tv_end{};
@@ -1112,6 +1167,16 @@ bool AppInitParameterInteraction()
     fCheckBlockIndex = gArgs.GetBoolArg("-checkblockindex", Params().DefaultConsistencyChecks());
     Checkpoints::fEnabled = gArgs.GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
 
+    // Networks without a default assume the blocks up to their last checkpoint valid (as every chain must go through it)
+    uint256 defaultAssumeValid = Params().GetConsensus().defaultAssumeValid;
+    if (defaultAssumeValid.IsNull())
+        defaultAssumeValid = Checkpoints::GetLastCheckpointHash();
+    hashAssumeValid = uint256S(gArgs.GetArg("-assumevalid", defaultAssumeValid.GetHex()));
+    if (!hashAssumeValid.IsNull())
+        LogPrintf("Assuming ancestors of block %s have valid signatures and proofs.\n", hashAssumeValid.GetHex());
+    else
+        LogPrintf("Validating signatures and proofs for all blocks.\n");
+
     // -mempoollimit limits
     int64_t nMempoolSizeLimit = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     int64_t nMempoolDescendantSizeLimit = gArgs.GetArg("-limitdescendantsize", DEFAULT_DESCENDANT_SIZE_LIMIT) * 1000;
@@ -1244,6 +1309,8 @@ bool AppInitSanityChecks()
 
 bool AppInitMain()
 {
+    nStartupBeginTime = GetTimeMillis();
+
     // ********************************************************* Step 4a: application initialization
     // After daemonization get the data directory lock again and hold on to it until exit
     // This creates a slight window for a race condition to happen, however this condition is harmless: it
@@ -1296,10 +1363,26 @@ bool AppInitMain()
         RandAddPeriodic();
     }, 60000);
 
+    // Release the recycled stream buffers left unused for a minute.
+    scheduler.scheduleEvery([]{
+        BufferPool::Instance().ReleaseIdle();
+    }, 60000);
+
     GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
 
-    // Initialize Sapling circuit parameters
-    LoadSaplingParams();
+    // Initialize Sapling circuit parameters.
+    // They are needed only to verify blocks (VerifyDB, then the import and the sync), so
+    // load them on their own thread, alongside the network initialization, the block index
+    // loading and the wallet loading.
+    std::future<void> saplingParamsLoaded = std::async(std::launch::async, [] {
+        util::ThreadRename("pivx-saplingparams");
+        StartupPhaseTimer timer("sapling_params", true);
+        LoadSaplingParams();
+    });
+    auto WaitForSaplingParams = [&saplingParamsLoaded]() {
+        if (saplingParamsLoaded.valid())
+            saplingParamsLoaded.get();
+    };
 
     /* Start the RPC server already.  It will be started in "warmup" mode
      * and not really process calls already (but it will signify connections
@@ -1349,12 +1432,16 @@ bool AppInitMain()
 
 // ********************************************************* Step 5: Verify wallet database integrity
 #ifdef ENABLE_WALLET
-    if (!WalletVerify()) {
-        return false;
+    {
+        StartupPhaseTimer timer("wallet_verify");
+        if (!WalletVerify()) {
+            return false;
+        }
     }
 #endif
 
     // ********************************************************* Step 6: network initialization
+    StartupPhaseTimer networkInitTimer("network_init");
     // Note that we absolutely cannot open any actual connections
     // until the very end ("start node") as the UTXO/block state
     // is not yet setup and may end up being set up twice if we
@@ -1509,6 +1596,8 @@ bool AppInitMain()
     pEvoNotificationInterface = new EvoNotificationInterface(connman);
     RegisterValidationInterface(pEvoNotificationInterface);
 
+    networkInitTimer.Stop();
+
     // ********************************************************* Step 7: load block chain
 
     fReindex = gArgs.GetBoolArg("-reindex", false);
@@ -1530,6 +1619,9 @@ bool AppInitMain()
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set\n", nCoinCacheUsage * (1.0 / 1024 / 1024));
+    const int64_t nRecentBlocksCache = std::max((int64_t)0, gArgs.GetArg("-recentblockscache", DEFAULT_RECENT_BLOCKS_CACHE_MB));
+    g_recentblocks.Init(gArgs.GetArg("-maxreorg", DEFAULT_MAX_REORG_DEPTH), (size_t)nRecentBlocksCache << 20);
+    LogPrintf("* Using up to %dMiB for the recent blocks cache\n", nRecentBlocksCache);
 
     const CChainParams& chainparams = Params();
     const Consensus::Params& consensus = chainparams.GetConsensus();
@@ -1569,6 +1661,8 @@ bool AppInitMain()
                 // End loop if shutdown was requested
                 if (ShutdownRequested()) break;
 
+                StartupPhaseTimer loadBlockIndexTimer("load_block_index");
+
                 // PIVX: load previous sessions sporks if we have them.
                 uiInterface.InitMessage(_("Loading sporks..."));
                 sporkManager.LoadSporksFromDB();
@@ -1608,6 +1702,8 @@ bool AppInitMain()
 
                 // At this point we're either in reindex or we've loaded a useful
                 // block tree into mapBlockIndex!
+                loadBlockIndexTimer.Stop();
+                StartupPhaseTimer replayBlocksTimer("replay_blocks");
 
                 pcoinsdbview = new CCoinsViewDB(nCoinDBCache, false, fReset || fReindexChainState);
                 pcoinscatcher = new CCoinsViewErrorCatcher(pcoinsdbview);
@@ -1627,6 +1723,8 @@ bool AppInitMain()
                     break;
                 }
 
+                replayBlocksTimer.Stop();
+
                 // The on-disk coinsdb is now in a good state, create the cache
                 pcoinsTip = new CCoinsViewCache(pcoinscatcher);
 
@@ -1678,6 +1776,11 @@ bool AppInitMain()
                         }
                     }
 
+                    // VerifyDB can reconnect blocks, checking their Sapling proofs
+                    WaitForSaplingParams();
+                    if (ShutdownRequested()) break;
+
+                    StartupPhaseTimer verifyDBTimer("verify_db");
                     if (!CVerifyDB().VerifyDB(pcoinsdbview, gArgs.GetArg("-checklevel", DEFAULT_CHECKLEVEL),
                             gArgs.GetArg("-checkblocks", DEFAULT_CHECKBLOCKS))) {
                         strLoadError = _("Corrupted block database detected");
@@ -1730,13 +1833,23 @@ bool AppInitMain()
 
 // ********************************************************* Step 8: Backup and Load wallet
 #ifdef ENABLE_WALLET
-    if (!InitLoadWallet())
-        return false;
+    {
+        StartupPhaseTimer timer("wallet");
+        if (!InitLoadWallet())
+            return false;
+    }
 #else
     LogPrintf("No wallet compiled in!\n");
 #endif
     // ********************************************************* Step 9: import blocks
 
+    // From here on, blocks are connected
+    WaitForSaplingParams();
+    if (ShutdownRequested()) {
+        LogPrintf("Shutdown requested. Exiting.\n");
+        return false;
+    }
+
     if (!CheckDiskSpace(GetDataDir())) {
         UIError(strprintf(_("Error: Disk space is low for %s"), GetDataDir()));
         return false;
@@ -1777,6 +1890,7 @@ bool AppInitMain()
     // Wait for genesis block to be processed
     LogPrintf("Waiting for genesis block to be imported...\n");
     {
+        StartupPhaseTimer timer("genesis_import");
         std::unique_lock<std::mutex> lockG(cs_GenesisWait);
         while (!fHaveGenesis) {
             condvar_GenesisWait.wait(lockG);
@@ -1796,28 +1910,50 @@ bool AppInitMain()
     // ********************************************************* Step 10: setup layer 2 data
 
     uiInterface.InitMessage(_("Loading masternode cache..."));
+    StartupPhaseTimer tierTwoTimer("tier_two_caches");
 
     mnodeman.SetBestHeight(nChainHeight);
     LoadBlockHashesCache(mnodeman);
-    CMasternodeDB mndb;
-    CMasternodeDB::ReadResult readResult = mndb.Read(mnodeman);
+    const bool fDryRun = (nChainHeight <= 0);
+    if (!fDryRun) g_budgetman.SetBestHeight(nChainHeight);
+
+    // mncache.dat, budget.dat and mnpayments.dat are read and deserialized concurrently:
+    // they fill unrelated managers. The budget cleaning needs all of them, so it runs after.
+    std::future<CMasternodeDB::ReadResult> mncacheRead = std::async(std::launch::async, [] {
+        StartupPhaseTimer timer("mncache", true);
+        CMasternodeDB mndb;
+        return mndb.Read(mnodeman);
+    });
+    std::future<CBudgetDB::ReadResult> budgetRead = std::async(std::launch::async, [] {
+        StartupPhaseTimer timer("budget", true);
+        CBudgetDB budgetdb;
+        return budgetdb.Read(g_budgetman, true /* fDryRun */);
+    });
+    std::future<CMasternodePaymentDB::ReadResult> mnpaymentsRead = std::async(std::launch::async, [] {
+        StartupPhaseTimer timer("mnpayments", true);
+        CMasternodePaymentDB mnpayments;
+        return mnpayments.Read(masternodePayments);
+    });
+
+    CMasternodeDB::ReadResult readResult = mncacheRead.get();
     if (readResult == CMasternodeDB::FileError)
         LogPrintf("Missing masternode cache file - mncache.dat, will try to recreate\n");
     else if (readResult != CMasternodeDB::Ok) {
         LogPrintf("Error reading mncache.dat - cached data discarded\n");
     }
+    mnodeman.WatchCollaterals();
 
     uiInterface.InitMessage(_("Loading budget cache..."));
 
-    CBudgetDB budgetdb;
-    const bool fDryRun = (nChainHeight <= 0);
-    if (!fDryRun) g_budgetman.SetBestHeight(nChainHeight);
-    CBudgetDB::ReadResult readResult2 = budgetdb.Read(g_budgetman, fDryRun);
-
+    CBudgetDB::ReadResult readResult2 = budgetRead.get();
     if (readResult2 == CBudgetDB::FileError)
         LogPrintf("Missing budget cache - budget.dat, will try to recreate\n");
     else if (readResult2 != CBudgetDB::Ok) {
         LogPrintf("Error reading budget.dat - cached data discarded\n");
+    } else if (!fDryRun) {
+        LogPrint(BCLog::MNBUDGET,"Budget manager - cleaning....\n");
+        g_budgetman.CheckAndRemove();
+        LogPrint(BCLog::MNBUDGET,"Budget manager - result: %s\n", g_budgetman.ToString());
     }
 
     //flag our cached items so we send them to our peers
@@ -1826,14 +1962,13 @@ bool AppInitMain()
 
     uiInterface.InitMessage(_("Loading masternode payment cache..."));
 
-    CMasternodePaymentDB mnpayments;
-    CMasternodePaymentDB::ReadResult readResult3 = mnpayments.Read(masternodePayments);
-
+    CMasternodePaymentDB::ReadResult readResult3 = mnpaymentsRead.get();
     if (readResult3 == CMasternodePaymentDB::FileError)
         LogPrintf("Missing masternode payment cache - mnpayments.dat, will try to recreate\n");
     else if (readResult3 != CMasternodePaymentDB::Ok) {
         LogPrintf("Error reading mnpayments.dat - cached data discarded\n");
     }
+    tierTwoTimer.Stop();
 
     fMasterNode = gArgs.GetBoolArg("-masternode", DEFAULT_MASTERNODE);
 
@@ -1959,6 +2094,8 @@ bool AppInitMain()
     connOptions.m_msgproc = peerLogic.get();
     connOptions.nSendBufferMaxSize = 1000*gArgs.GetArg("-maxsendbuffer", DEFAULT_MAXSENDBUFFER);
     connOptions.nReceiveFloodSize = 1000*gArgs.GetArg("-maxreceivebuffer", DEFAULT_MAXRECEIVEBUFFER);
+    connOptions.nRecvThreads = gArgs.GetArg("-netrecvthreads", DEFAULT_NET_RECV_THREADS);
+    connOptions.m_capture_messages = gArgs.GetBoolArg("-capturemessages", DEFAULT_CAPTURE_MESSAGES);
 
     if (!connman.Start(scheduler, strNodeError, connOptions))
         return UIError(strNodeError);
@@ -1982,6 +2119,9 @@ bool AppInitMain()
     }
 #endif
 
+    nStartupDuration = GetTimeMillis() - nStartupBeginTime;
+    LogPrintf("Startup completed in %dms\n", nStartupDuration);
+
     SetRPCWarmupFinished();
     uiInterface.InitMessage(_("Done loading"));
 
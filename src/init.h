@@ -7,7 +7,9 @@
 #ifndef BITCOIN_INIT_H
 #define BITCOIN_INIT_H
 
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 class CScheduler;
 class CWallet;
@@ -52,6 +54,21 @@ bool AppInitSanityChecks();
  */
 bool AppInitMain();
 
+/** Duration of a phase of AppInitMain */
+struct StartupPhase {
+    std::string name;
+    //! Start, in milliseconds since the beginning of AppInitMain
+    int64_t nStart;
+    //! Duration, in milliseconds
+    int64_t nDuration;
+    //! Whether it ran on its own thread, concurrently with the other phases
+    bool fConcurrent;
+};
+/** The startup phases completed so far, in order of completion */
+std::vector<StartupPhase> GetStartupPhases();
+/** Time (ms) from the beginning of AppInitMain to the end of the initialization, or -1 if not finished yet */
+int64_t GetStartupDuration();
+
 /** The help message mode determines what help message to show */
 enum HelpMessageMode {
     HMM_BITCOIND,
@@ -30,6 +30,12 @@ ZerocoinParams::ZerocoinParams(CBigNum N, uint32_t securityLevel) {
     this->initialized = true;
 }
 
+ZerocoinParams::ZerocoinParams() {
+    this->initialized = false;
+    this->zkp_hash_len = 0;
+    this->zkp_iterations = 0;
+}
+
 AccumulatorAndProofParams::AccumulatorAndProofParams() {
     this->initialized = false;
 }
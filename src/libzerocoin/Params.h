@@ -174,6 +174,13 @@ public:
 	ZerocoinParams(CBigNum accumulatorModulus,
 	       uint32_t securityLevel = ZEROCOIN_DEFAULT_SECURITYLEVEL);
 
+	/** @brief Zerocoin parameters, default constructor
+	*
+	* Allocates an empty (uninitialized) set of parameters,
+	* to be deserialized.
+	**/
+	ZerocoinParams();
+
 	bool initialized;
 
 	AccumulatorAndProofParams accumulatorParams;
@@ -0,0 +1,173 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "masternode-collaterals.h"
+
+#include "primitives/block.h"
+#include "validation.h"
+
+CCollateralWatchSet g_collateralWatchSet;
+
+CollateralStatus CCollateralWatchSet::ReadUTXOStatus(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs_main);
+    CollateralStatus status;
+    Coin coin;
+    if (pcoinsTip->GetCoin(outpoint, coin) && !coin.IsSpent()) {
+        status.out = coin.out;
+        status.nHeight = coin.nHeight;
+    }
+    return status;
+}
+
+void CCollateralWatchSet::Watch(const COutPoint& outpoint, Owner owner)
+{
+    LOCK2(cs_main, cs);
+    nTipHeight = chainActive.Height();
+    auto it = mapCollaterals.find(outpoint);
+    if (it == mapCollaterals.end()) {
+        it = mapCollaterals.emplace(outpoint, Entry()).first;
+        it->second.status = ReadUTXOStatus(outpoint);
+    }
+    it->second.nOwners |= owner;
+}
+
+void CCollateralWatchSet::Unwatch(const COutPoint& outpoint, Owner owner)
+{
+    LOCK(cs);
+    auto it = mapCollaterals.find(outpoint);
+    if (it != mapCollaterals.end()) {
+        it->second.nOwners &= ~owner;
+        if (it->second.nOwners == 0) mapCollaterals.erase(it);
+    }
+}
+
+void CCollateralWatchSet::UnwatchAll(Owner owner)
+{
+    LOCK(cs);
+    for (auto it = mapCollaterals.begin(); it != mapCollaterals.end();) {
+        it->second.nOwners &= ~owner;
+        if (it->second.nOwners == 0) {
+            it = mapCollaterals.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+Optional<CollateralStatus> CCollateralWatchSet::Get(const COutPoint& outpoint) const
+{
+    LOCK(cs);
+    const auto it = mapCollaterals.find(outpoint);
+    if (it == mapCollaterals.end()) return nullopt;
+    return Optional<CollateralStatus>(it->second.status);
+}
+
+int CCollateralWatchSet::GetDepthAtHeight(const COutPoint& outpoint, int nHeight) const
+{
+    LOCK(cs);
+    const auto it = mapCollaterals.find(outpoint);
+    if (it == mapCollaterals.end() || !it->second.status.IsUnspent()) return -1;
+    return nHeight - it->second.status.nHeight + 1;
+}
+
+CollateralStatus CCollateralWatchSet::Lookup(const COutPoint& outpoint) const
+{
+    Optional<CollateralStatus> status = Get(outpoint);
+    if (status) return *status;
+    return WITH_LOCK(cs_main, return ReadUTXOStatus(outpoint); );
+}
+
+Optional<int> CCollateralWatchSet::GetConfirmations(const COutPoint& outpoint) const
+{
+    // nullopt means UTXO is yet unknown or already spent
+    CollateralStatus status;
+    int nChainHeight{-1};
+    bool fWatched{false};
+    {
+        LOCK(cs);
+        const auto it = mapCollaterals.find(outpoint);
+        if (it != mapCollaterals.end()) {
+            status = it->second.status;
+            nChainHeight = nTipHeight;
+            fWatched = true;
+        }
+    }
+    if (!fWatched) {
+        LOCK(cs_main);
+        status = ReadUTXOStatus(outpoint);
+        nChainHeight = chainActive.Height();
+    }
+    if (!status.IsUnspent() || nChainHeight < 0 || status.nHeight > nChainHeight)
+        return nullopt;
+    return Optional<int>(nChainHeight - status.nHeight + 1);
+}
+
+std::vector<COutPoint> CCollateralWatchSet::BlockConnected(const CBlock& block, int nHeight)
+{
+    std::vector<COutPoint> vSpent;
+    LOCK(cs);
+    nTipHeight = nHeight;
+    if (mapCollaterals.empty()) return vSpent;
+
+    for (const auto& tx : block.vtx) {
+        for (const CTxIn& in : tx->vin) {
+            auto it = mapCollaterals.find(in.prevout);
+            if (it != mapCollaterals.end()) {
+                it->second.status.nSpentHeight = nHeight;
+                vSpent.emplace_back(in.prevout);
+            }
+        }
+        // Collaterals watched before being mined (e.g. the output of a ProRegTx)
+        const uint256& txid = tx->GetHash();
+        for (uint32_t i = 0; i < tx->vout.size(); i++) {
+            auto it = mapCollaterals.find(COutPoint(txid, i));
+            if (it != mapCollaterals.end() && it->second.status.nHeight < 0) {
+                it->second.status.out = tx->vout[i];
+                it->second.status.nHeight = nHeight;
+                it->second.status.nSpentHeight = -1;
+            }
+        }
+    }
+    return vSpent;
+}
+
+void CCollateralWatchSet::BlockDisconnected(const CBlock& block, int nHeight)
+{
+    AssertLockHeld(cs_main);
+    LOCK(cs);
+    nTipHeight = nHeight - 1;
+    if (mapCollaterals.empty()) return;
+
+    // The outputs created by the block are gone, and the ones spent by it are back in
+    // the UTXO set: read the watched ones again.
+    for (const auto& tx : block.vtx) {
+        for (const CTxIn& in : tx->vin) {
+            auto it = mapCollaterals.find(in.prevout);
+            if (it != mapCollaterals.end()) {
+                it->second.status = ReadUTXOStatus(in.prevout);
+            }
+        }
+        const uint256& txid = tx->GetHash();
+        for (uint32_t i = 0; i < tx->vout.size(); i++) {
+            auto it = mapCollaterals.find(COutPoint(txid, i));
+            if (it != mapCollaterals.end()) {
+                it->second.status = CollateralStatus();
+            }
+        }
+    }
+}
+
+size_t CCollateralWatchSet::Size() const
+{
+    LOCK(cs);
+    return mapCollaterals.size();
+}
+
+void CCollateralWatchSet::Clear()
+{
+    LOCK(cs);
+    mapCollaterals.clear();
+    nTipHeight = -1;
+}
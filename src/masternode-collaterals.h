@@ -0,0 +1,84 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MASTERNODE_COLLATERALS_H
+#define MASTERNODE_COLLATERALS_H
+
+#include "coins.h"
+#include "optional.h"
+#include "primitives/transaction.h"
+#include "sync.h"
+
+#include <unordered_map>
+#include <vector>
+
+class CBlock;
+class CCollateralWatchSet;
+extern CCollateralWatchSet g_collateralWatchSet;
+
+struct CollateralStatus {
+    CTxOut out;
+    int nHeight{-1};        // height of the block that created the output (-1: not in the chain)
+    int nSpentHeight{-1};   // height of the block that spent it (-1: unspent)
+
+    bool IsUnspent() const { return nHeight >= 0 && nSpentHeight < 0; }
+};
+
+//
+// CCollateralWatchSet: index of the collaterals of the legacy and deterministic masternodes.
+//
+// Each watched outpoint is resolved against the UTXO set once, when it's added.
+// Afterwards its status is only updated by the blocks connected/disconnected from the tip,
+// so that the collateral checks done when processing broadcasts, pings and payment queues
+// are map lookups, and don't need cs_main.
+// Lock order: cs_main -> CMasternodeMan::cs -> cs.
+//
+class CCollateralWatchSet
+{
+public:
+    // Masternode lists referring to a collateral
+    enum Owner : uint8_t {
+        LEGACY = 1 << 0,
+        DETERMINISTIC = 1 << 1,
+    };
+
+private:
+    struct Entry {
+        CollateralStatus status;
+        uint8_t nOwners{0};
+    };
+
+    mutable Mutex cs;
+    std::unordered_map<COutPoint, Entry, SaltedOutpointHasher> mapCollaterals GUARDED_BY(cs);
+    int nTipHeight GUARDED_BY(cs){-1};
+
+    static CollateralStatus ReadUTXOStatus(const COutPoint& outpoint) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+public:
+    // Start watching outpoint on behalf of owner. Reads the UTXO set if the outpoint isn't
+    // watched yet: don't call it while holding locks that come after cs_main.
+    void Watch(const COutPoint& outpoint, Owner owner);
+    void Unwatch(const COutPoint& outpoint, Owner owner);
+    void UnwatchAll(Owner owner);
+
+    // Watched outpoints only
+    Optional<CollateralStatus> Get(const COutPoint& outpoint) const;
+    // Depth of an unspent watched collateral at nHeight, -1 if spent or unknown (as CCoinsViewCache::GetCoinDepthAtHeight)
+    int GetDepthAtHeight(const COutPoint& outpoint, int nHeight) const;
+
+    // Watched outpoints, or a lookup in the UTXO set (taking cs_main) for the others
+    CollateralStatus Lookup(const COutPoint& outpoint) const;
+    // Confirmations of an unspent collateral at the chain tip (nullopt if it's unknown or already spent)
+    Optional<int> GetConfirmations(const COutPoint& outpoint) const;
+
+    // Apply a block connected to the tip. Returns the watched collaterals that it spends.
+    std::vector<COutPoint> BlockConnected(const CBlock& block, int nHeight);
+    // Revert a block disconnected from the tip (after the UTXO set has been updated)
+    void BlockDisconnected(const CBlock& block, int nHeight);
+
+    size_t Size() const;
+    void Clear();
+};
+
+#endif // MASTERNODE_COLLATERALS_H
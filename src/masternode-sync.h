@@ -79,7 +79,7 @@ public:
     void AddedBudgetItem(const uint256& hash);
     void SwitchToNextAsset();
     std::string GetSyncStatus();
-    void ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+    void ProcessMessage(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv);
     bool IsBudgetFinEmpty();
     bool IsBudgetPropEmpty();
 
@@ -101,7 +101,7 @@ public:
     bool IsBlockchainSyncedReadOnly() const;
 
     // Sync message dispatcher
-    bool MessageDispatcher(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+    bool MessageDispatcher(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv);
 
 private:
 
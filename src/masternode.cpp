@@ -7,6 +7,7 @@
 
 #include "addrman.h"
 #include "init.h"
+#include "masternode-collaterals.h"
 #include "masternode-sync.h"
 #include "masternodeman.h"
 #include "netbase.h"
@@ -506,8 +507,8 @@ bool CMasternodeBroadcast::CheckInputsAndAdd(int nChainHeight, int& nDoS)
             mnodeman.Remove(pmn->vin.prevout);
     }
 
-    const Coin& collateralUtxo = pcoinsTip->AccessCoin(vin.prevout);
-    if (collateralUtxo.IsSpent()) {
+    const CollateralStatus& collateralUtxo = g_collateralWatchSet.Lookup(vin.prevout);
+    if (!collateralUtxo.IsUnspent()) {
         LogPrint(BCLog::MASTERNODE,"mnb - vin %s spent\n", vin.prevout.ToString());
         return false;
     }
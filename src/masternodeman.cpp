@@ -8,6 +8,7 @@
 #include "addrman.h"
 #include "evo/deterministicmns.h"
 #include "fs.h"
+#include "masternode-collaterals.h"
 #include "masternode-payments.h"
 #include "masternode-sync.h"
 #include "masternode.h"
@@ -187,20 +188,25 @@ bool CMasternodeMan::Add(CMasternode& mn)
         return false;
     }
 
+    // The watch-set reads the collateral from the UTXO set (under cs_main): do it before locking cs
+    g_collateralWatchSet.Watch(mn.vin.prevout, CCollateralWatchSet::LEGACY);
+
     LOCK(cs);
 
-    if (!mn.IsAvailableState())
+    const auto& it = mapMasternodes.find(mn.vin.prevout);
+    if (it != mapMasternodes.end()) {
         return false;
+    }
 
-    const auto& it = mapMasternodes.find(mn.vin.prevout);
-    if (it == mapMasternodes.end()) {
-        LogPrint(BCLog::MASTERNODE, "Adding new Masternode %s\n", mn.vin.prevout.ToString());
-        mapMasternodes.emplace(mn.vin.prevout, std::make_shared<CMasternode>(mn));
-        LogPrint(BCLog::MASTERNODE, "Masternode added. New total count: %d\n", mapMasternodes.size());
-        return true;
+    if (!mn.IsAvailableState()) {
+        g_collateralWatchSet.Unwatch(mn.vin.prevout, CCollateralWatchSet::LEGACY);
+        return false;
     }
 
-    return false;
+    LogPrint(BCLog::MASTERNODE, "Adding new Masternode %s\n", mn.vin.prevout.ToString());
+    mapMasternodes.emplace(mn.vin.prevout, std::make_shared<CMasternode>(mn));
+    LogPrint(BCLog::MASTERNODE, "Masternode added. New total count: %d\n", mapMasternodes.size());
+    return true;
 }
 
 void CMasternodeMan::AskForMN(CNode* pnode, const CTxIn& vin)
@@ -268,6 +274,7 @@ int CMasternodeMan::CheckAndRemove(bool forceExpiredRemoval)
                 }
             }
 
+            g_collateralWatchSet.Unwatch(it->first, CCollateralWatchSet::LEGACY);
             it = mapMasternodes.erase(it);
             LogPrint(BCLog::MASTERNODE, "Masternode removed.\n");
         } else {
@@ -334,6 +341,7 @@ void CMasternodeMan::Clear()
 {
     LOCK(cs);
     mapMasternodes.clear();
+    g_collateralWatchSet.UnwatchAll(CCollateralWatchSet::LEGACY);
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -459,24 +467,37 @@ CMasternode* CMasternodeMan::Find(const CPubKey& pubKeyMasternode)
     return nullptr;
 }
 
-void CMasternodeMan::CheckSpentCollaterals(const std::vector<CTransactionRef>& vtx)
+void CMasternodeMan::CheckSpentCollaterals(const std::vector<COutPoint>& vSpent)
 {
     // Skip after legacy obsolete. !TODO: remove when transition to DMN is complete
-    if (deterministicMNManager->LegacyMNObsolete()) {
+    if (vSpent.empty() || deterministicMNManager->LegacyMNObsolete()) {
         return;
     }
 
     LOCK(cs);
-    for (const auto& tx : vtx) {
-        for (const auto& in : tx->vin) {
-            auto it = mapMasternodes.find(in.prevout);
-            if (it != mapMasternodes.end()) {
-                it->second->SetSpent();
-            }
+    for (const COutPoint& collateral : vSpent) {
+        auto it = mapMasternodes.find(collateral);
+        if (it != mapMasternodes.end()) {
+            it->second->SetSpent();
         }
     }
 }
 
+void CMasternodeMan::WatchCollaterals()
+{
+    std::vector<COutPoint> vCollaterals;
+    {
+        LOCK(cs);
+        vCollaterals.reserve(mapMasternodes.size());
+        for (const auto& it : mapMasternodes) {
+            vCollaterals.emplace_back(it.first);
+        }
+    }
+    for (const COutPoint& collateral : vCollaterals) {
+        g_collateralWatchSet.Watch(collateral, CCollateralWatchSet::LEGACY);
+    }
+}
+
 static bool canScheduleMN(bool fFilterSigTime, const MasternodeRef& mn, int minProtocol,
                           int nMnCount, int nBlockHeight)
 {
@@ -490,7 +511,7 @@ static bool canScheduleMN(bool fFilterSigTime, const MasternodeRef& mn, int minP
     if (fFilterSigTime && mn->sigTime + (nMnCount * 2.6 * 60) > GetAdjustedTime()) return false;
 
     // make sure it has as many confirmations as there are masternodes
-    if (pcoinsTip->GetCoinDepthAtHeight(mn->vin.prevout, nBlockHeight) < nMnCount) return false;
+    if (g_collateralWatchSet.GetDepthAtHeight(mn->vin.prevout, nBlockHeight) < nMnCount) return false;
 
     return true;
 }
@@ -823,7 +844,7 @@ int CMasternodeMan::ProcessGetMNList(CNode* pfrom, CTxIn& vin)
     return 0;
 }
 
-void CMasternodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv)
+void CMasternodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv)
 {
     int banScore = ProcessMessageInner(pfrom, strCommand, vRecv);
     if (banScore > 0) {
@@ -832,7 +853,7 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CData
     }
 }
 
-int CMasternodeMan::ProcessMessageInner(CNode* pfrom, std::string& strCommand, CDataStream& vRecv)
+int CMasternodeMan::ProcessMessageInner(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv)
 {
     if (fLiteMode) return 0; //disable all Masternode related functionality
     if (!masternodeSync.IsBlockchainSynced()) return 0;
@@ -873,6 +894,7 @@ void CMasternodeMan::Remove(const COutPoint& collateralOut)
     const auto it = mapMasternodes.find(collateralOut);
     if (it != mapMasternodes.end()) {
         mapMasternodes.erase(it);
+        g_collateralWatchSet.Unwatch(collateralOut, CCollateralWatchSet::LEGACY);
     }
 }
 
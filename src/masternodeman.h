@@ -81,7 +81,7 @@ private:
     // Return the banning score (0 if no ban score increase is needed).
     int ProcessMNBroadcast(CNode* pfrom, CMasternodeBroadcast& mnb);
     int ProcessMNPing(CNode* pfrom, CMasternodePing& mnp);
-    int ProcessMessageInner(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+    int ProcessMessageInner(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv);
 
 public:
     // Keep track of all broadcasts I've seen
@@ -138,8 +138,11 @@ public:
     const CMasternode* Find(const COutPoint& collateralOut) const;
     CMasternode* Find(const CPubKey& pubKeyMasternode);
 
-    /// Check all transactions in a block, for spent masternode collateral outpoints (marking them as spent)
-    void CheckSpentCollaterals(const std::vector<CTransactionRef>& vtx);
+    /// Mark the masternodes with the given collaterals (spent by a block connected to the tip) as spent
+    void CheckSpentCollaterals(const std::vector<COutPoint>& vSpent);
+
+    /// Add the collaterals of the masternodes in the list to the collateral watch-set (after loading the list from disk)
+    void WatchCollaterals();
 
     /// Find an entry in the masternode list that is next to be paid
     MasternodeRef GetNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCount, const CBlockIndex* pChainTip = nullptr) const;
@@ -154,7 +157,7 @@ public:
     std::vector<std::pair<int64_t, MasternodeRef>> GetMasternodeRanks(int nBlockHeight) const;
     int GetMasternodeRank(const CTxIn& vin, int64_t nBlockHeight) const;
 
-    void ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+    void ProcessMessage(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv);
 
     // Process GETMNLIST message, returning the banning score (if 0, no ban score increase is needed)
     int ProcessGetMNList(CNode* pfrom, CTxIn& vin);
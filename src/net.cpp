@@ -1172,7 +1172,7 @@ void CConnman::ThreadSocketHandler()
                 // * Hand off all complete messages to the processor, to be handled without
                 //   blocking here.
 
-                bool select_recv = !pnode->fPauseRecv;
+                bool select_recv = !pnode->fPauseRecv && pnode->nRecvQueueBytes < MAX_RECV_QUEUE_BYTES;
                 bool select_send;
                 {
                     LOCK(pnode->cs_vSend);
@@ -1265,25 +1265,19 @@ void CConnman::ThreadSocketHandler()
                             nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
                         }
                         if (nBytes > 0) {
-                            bool notify = false;
-                            if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
-                                pnode->CloseSocketDisconnect();
                             RecordBytesRecv(nBytes);
-                            if (notify) {
-                                size_t nSizeAdded = 0;
-                                auto it(pnode->vRecvMsg.begin());
-                                for (; it != pnode->vRecvMsg.end(); ++it) {
-                                    if (!it->complete())
-                                        break;
-                                    nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
-                                }
+                            if (vRecvQueues.empty()) {
+                                ProcessRecvBytes(pnode, pchBuf, nBytes);
+                            } else {
+                                // Hand the bytes to the recv thread of the peer
+                                RecvQueue& recvQueue = *vRecvQueues[pnode->GetId() % vRecvQueues.size()];
+                                pnode->AddRef();
+                                pnode->nRecvQueueBytes += nBytes;
                                 {
-                                    LOCK(pnode->cs_vProcessMsg);
-                                    pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
-                                    pnode->nProcessQueueSize += nSizeAdded;
-                                    pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
+                                    std::lock_guard<std::mutex> lock(recvQueue.mutex);
+                                    recvQueue.queue.emplace_back(pnode, std::vector<char>(pchBuf, pchBuf + nBytes));
                                 }
-                                WakeMessageHandler();
+                                recvQueue.cond.notify_one();
                             }
                         } else if (nBytes == 0) {
                             // socket closed gracefully
@@ -1341,6 +1335,56 @@ void CConnman::ThreadSocketHandler()
     }
 }
 
+void CConnman::ProcessRecvBytes(CNode* pnode, const char* pch, unsigned int nBytes)
+{
+    bool notify = false;
+    if (!pnode->ReceiveMsgBytes(pch, nBytes, notify)) {
+        // Leave the socket to the socket thread, which may still be reading it: it's closed when the node is disconnected
+        pnode->fDisconnect = true;
+    }
+    if (notify) {
+        size_t nSizeAdded = 0;
+        auto it(pnode->vRecvMsg.begin());
+        for (; it != pnode->vRecvMsg.end(); ++it) {
+            if (!it->complete())
+                break;
+            // Also finish the payload hash for the checksum check, out of the message handler thread
+            it->GetMessageHash();
+            nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
+        }
+        {
+            LOCK(pnode->cs_vProcessMsg);
+            pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
+            pnode->nProcessQueueSize += nSizeAdded;
+            pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
+        }
+        WakeMessageHandler();
+    }
+}
+
+void CConnman::ThreadRecvHandler(int nThread)
+{
+    RecvQueue& recvQueue = *vRecvQueues[nThread];
+    while (true) {
+        std::pair<CNode*, std::vector<char>> item;
+        {
+            std::unique_lock<std::mutex> lock(recvQueue.mutex);
+            recvQueue.cond.wait(lock, [&] { return !recvQueue.queue.empty() || interruptNet; });
+            if (recvQueue.queue.empty())
+                return;
+            item = std::move(recvQueue.queue.front());
+            recvQueue.queue.pop_front();
+        }
+        CNode* pnode = item.first;
+        // Nothing left to frame for a disconnected peer
+        if (!pnode->fDisconnect) {
+            ProcessRecvBytes(pnode, item.second.data(), item.second.size());
+        }
+        pnode->nRecvQueueBytes -= item.second.size();
+        pnode->Release();
+    }
+}
+
 void CConnman::WakeMessageHandler()
 {
     {
@@ -1939,6 +1983,8 @@ bool CConnman::Start(CScheduler& scheduler, std::string& strNodeError, Options c
 
     nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
     nReceiveFloodSize = connOptions.nReceiveFloodSize;
+    nRecvThreads = std::max(0, std::min(connOptions.nRecvThreads, MAX_NET_RECV_THREADS));
+    m_capture_messages = connOptions.m_capture_messages;
 
     SetBestHeight(connOptions.nBestHeight);
 
@@ -2012,6 +2058,14 @@ bool CConnman::Start(CScheduler& scheduler, std::string& strNodeError, Options c
         fMsgProcWake = false;
     }
 
+    // Frame the received bytes
+    for (int i = 0; i < nRecvThreads; i++) {
+        vRecvQueues.emplace_back(new RecvQueue());
+    }
+    for (int i = 0; i < nRecvThreads; i++) {
+        vRecvThreads.emplace_back(&TraceThread<std::function<void()> >, "netrecv", std::function<void()>(std::bind(&CConnman::ThreadRecvHandler, this, i)));
+    }
+
     // Send and receive from sockets, accept connections
     threadSocketHandler = std::thread(&TraceThread<std::function<void()> >, "net", std::function<void()>(std::bind(&CConnman::ThreadSocketHandler, this)));
 
@@ -2069,6 +2123,13 @@ void CConnman::Interrupt()
 
     interruptNet();
     InterruptSocks5(true);
+    for (const auto& recvQueue : vRecvQueues) {
+        {
+            // Taken so that a recv thread can't miss the interrupt between its check and its wait
+            std::lock_guard<std::mutex> lock(recvQueue->mutex);
+        }
+        recvQueue->cond.notify_all();
+    }
 
     if (semOutbound)
         for (int i=0; i<(nMaxOutbound + nMaxFeeler); i++)
@@ -2087,6 +2148,19 @@ void CConnman::Stop()
         threadDNSAddressSeed.join();
     if (threadSocketHandler.joinable())
         threadSocketHandler.join();
+    for (std::thread& thread : vRecvThreads) {
+        if (thread.joinable())
+            thread.join();
+    }
+    vRecvThreads.clear();
+    // Release the nodes of the bytes left unframed
+    for (const auto& recvQueue : vRecvQueues) {
+        for (auto& item : recvQueue->queue) {
+            item.first->nRecvQueueBytes -= item.second.size();
+            item.first->Release();
+        }
+    }
+    vRecvQueues.clear();
 
     if (fAddressesInitialized)
     {
@@ -2343,6 +2417,7 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     nMinPingUsecTime = std::numeric_limits<int64_t>::max();
     fPauseRecv = false;
     fPauseSend = false;
+    nRecvQueueBytes = 0;
     nProcessQueueSize = 0;
 
     for (const std::string &msg : getAllNetMessageTypes())
@@ -2406,6 +2481,9 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
     size_t nMessageSize = msg.data.size();
     size_t nTotalSize = nMessageSize + CMessageHeader::HEADER_SIZE;
     LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n",  SanitizeString(msg.command.c_str()), nMessageSize, pnode->id);
+    if (m_capture_messages) {
+        CaptureMessage(*pnode, msg.command, msg.data.data(), nMessageSize, false);
+    }
 
     std::vector<unsigned char> serializedHeader;
     serializedHeader.reserve(CMessageHeader::HEADER_SIZE);
@@ -2488,3 +2566,30 @@ uint64_t CConnman::CalculateKeyedNetGroup(const CAddress& ad)
     return GetDeterministicRandomizer(RANDOMIZER_ID_NETGROUP).Write(vchNetGroup.data(), vchNetGroup.size()).Finalize();
 }
 
+void CaptureMessage(CNode& node, const std::string& strCommand, const unsigned char* pch, size_t nSize, bool fIncoming)
+{
+    const int64_t nTimeMicros = GetTimeMicros();
+
+    LOCK(node.cs_capture);
+    std::unique_ptr<CAutoFile>& file = fIncoming ? node.captureFileRecv : node.captureFileSent;
+    if (!file) {
+        // Windows doesn't allow ':' in paths
+        std::string strAddr = node.addr.ToString();
+        std::replace(strAddr.begin(), strAddr.end(), ':', '_');
+
+        const fs::path path = GetDataDir() / "message_capture" / strAddr;
+        TryCreateDirectories(path);
+        file.reset(new CAutoFile(fsbridge::fopen(path / (fIncoming ? "msgs_recv.dat" : "msgs_sent.dat"), "ab"), SER_DISK, CLIENT_VERSION));
+        if (file->IsNull()) {
+            LogPrint(BCLog::NET, "%s: unable to open capture file for peer %s\n", __func__, strAddr);
+        }
+    }
+    if (file->IsNull()) return;
+
+    char command[CMessageHeader::COMMAND_SIZE] = {};
+    strncpy(command, strCommand.c_str(), CMessageHeader::COMMAND_SIZE);
+    *file << nTimeMicros;
+    file->write(command, CMessageHeader::COMMAND_SIZE);
+    *file << (uint32_t)nSize;
+    file->write((const char*)pch, nSize);
+}
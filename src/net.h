@@ -75,6 +75,14 @@ static const ServiceFlags REQUIRED_SERVICES = NODE_NETWORK;
 static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
+/** -netrecvthreads default, number of threads framing the received bytes into messages (0 = socket thread) */
+static const int DEFAULT_NET_RECV_THREADS = 0;
+static const int MAX_NET_RECV_THREADS = 16;
+/** Maximum bytes read from a peer's socket and still waiting to be framed, before pausing the reads */
+static const size_t MAX_RECV_QUEUE_BYTES = 1024 * 1024;
+
+/** -capturemessages default */
+static const bool DEFAULT_CAPTURE_MESSAGES = false;
 
 // NOTE: When adjusting this, update rpcnet:setban's help ("24h")
 static const unsigned int DEFAULT_MISBEHAVING_BANTIME = 60 * 60 * 24;  // Default 24-hour ban
@@ -137,6 +145,8 @@ public:
         NetEventsInterface* m_msgproc = nullptr;
         unsigned int nSendBufferMaxSize = 0;
         unsigned int nReceiveFloodSize = 0;
+        int nRecvThreads = 0;
+        bool m_capture_messages = false;
     };
     CConnman(uint64_t seed0, uint64_t seed1);
     ~CConnman();
@@ -151,6 +161,12 @@ public:
 
     void PushMessage(CNode* pnode, CSerializedNetMsg&& msg);
 
+    /**
+     * Frame the bytes received from the peer (on its recv thread, or on the socket thread without them),
+     * hash the payloads of the complete messages, and hand these to the message handler
+     */
+    void ProcessRecvBytes(CNode* pnode, const char* pch, unsigned int nBytes);
+
     template<typename Callable>
     bool ForEachNodeContinueIf(Callable&& func)
     {
@@ -269,6 +285,7 @@ public:
     CSipHasher GetDeterministicRandomizer(uint64_t id);
 
     unsigned int GetReceiveFloodSize() const;
+    bool GetCaptureMessages() const { return m_capture_messages; }
 private:
     struct ListenSocket {
         SOCKET socket;
@@ -283,6 +300,7 @@ private:
     void ThreadMessageHandler();
     void AcceptConnection(const ListenSocket& hListenSocket);
     void ThreadSocketHandler();
+    void ThreadRecvHandler(int nThread);
     void ThreadDNSAddressSeed();
 
     void WakeMessageHandler();
@@ -333,6 +351,8 @@ private:
 
     unsigned int nSendBufferMaxSize{0};
     unsigned int nReceiveFloodSize{0};
+    int nRecvThreads{0};
+    bool m_capture_messages{false};
 
     std::vector<ListenSocket> vhListenSocket;
     banmap_t setBanned;
@@ -378,6 +398,19 @@ private:
     std::thread threadDNSAddressSeed;
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
+
+    /**
+     * Received bytes waiting to be framed (and the payloads hashed) by the recv threads.
+     * Each peer is served by a single thread, picked by id, so its bytes stay in order.
+     * The queued nodes hold a reference.
+     */
+    struct RecvQueue {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::deque<std::pair<CNode*, std::vector<char>>> queue;
+    };
+    std::vector<std::unique_ptr<RecvQueue>> vRecvQueues;
+    std::vector<std::thread> vRecvThreads;
     std::thread threadOpenConnections;
     std::thread threadMessageHandler;
 };
@@ -387,6 +420,13 @@ unsigned short GetListenPort();
 bool BindListenPort(const CService& bindAddr, std::string& strError, bool fWhitelisted = false);
 void CheckOffsetDisconnectedPeers(const CNetAddr& ip);
 
+/**
+ * Append a P2P message to <datadir>/message_capture/<peer address>/msgs_{recv,sent}.dat (-capturemessages).
+ * Record format: time of capture in microseconds (8 bytes LE), command (12 bytes, null padded),
+ * payload size (4 bytes LE), payload. The received messages can be replayed with bench_pivx.
+ */
+void CaptureMessage(CNode& node, const std::string& strCommand, const unsigned char* pch, size_t nSize, bool fIncoming);
+
 struct CombinerAll {
     typedef bool result_type;
 
@@ -492,11 +532,11 @@ private:
 public:
     bool in_data; // parsing header (false) or data (true)
 
-    CDataStream hdrbuf; // partially received header
+    CPooledDataStream hdrbuf; // partially received header
     CMessageHeader hdr; // complete header
     unsigned int nHdrPos;
 
-    CDataStream vRecv; // received message data
+    CPooledDataStream vRecv; // received message data
     unsigned int nDataPos;
 
     int64_t nTime; // time (in microseconds) of message receipt.
@@ -552,6 +592,11 @@ public:
 
     RecursiveMutex cs_sendProcessing;
 
+    // -capturemessages files of the peer, opened by the first message captured in each direction
+    Mutex cs_capture;
+    std::unique_ptr<CAutoFile> captureFileRecv GUARDED_BY(cs_capture);
+    std::unique_ptr<CAutoFile> captureFileSent GUARDED_BY(cs_capture);
+
     std::deque<CInv> vRecvGetData;
     uint64_t nRecvBytes;
     std::atomic<int> nRecvVersion;
@@ -590,6 +635,8 @@ public:
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv;
     std::atomic_bool fPauseSend;
+    // Bytes read from the socket, waiting in a recv queue to be framed
+    std::atomic<size_t> nRecvQueueBytes;
 protected:
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
@@ -655,7 +702,7 @@ private:
     const ServiceFlags nLocalServices;
     const int nMyStartingHeight;
     int nSendVersion;
-    std::list<CNetMessage> vRecvMsg;  // Used only by SocketHandler thread
+    std::list<CNetMessage> vRecvMsg;  // Used only by the thread framing the peer's bytes
 
     mutable RecursiveMutex cs_addrName;
     std::string addrName;
@@ -5,6 +5,9 @@
 #ifndef BITCOIN_OPTIONAL_H
 #define BITCOIN_OPTIONAL_H
 
+#include <cassert>
+#include <memory>
+
 #include <boost/optional.hpp>
 
 //! Substitute for C++17 std::optional
@@ -14,4 +17,35 @@ using Optional = boost::optional<T>;
 //! Substitute for C++17 std::nullopt
 static auto& nullopt = boost::none;
 
+/**
+ * Read-only optional value, held out of line: a disengaged instance takes a single
+ * pointer, and copies share the same value (which can also be shared on purpose,
+ * e.g. a common empty instance).
+ */
+template <typename T>
+class SharedOptional
+{
+public:
+    SharedOptional() {}
+    SharedOptional(boost::none_t) {}
+    explicit SharedOptional(std::shared_ptr<const T> valueIn) : value(std::move(valueIn)) {}
+    explicit SharedOptional(const Optional<T>& opt) : value(opt ? std::make_shared<const T>(*opt) : nullptr) {}
+    explicit SharedOptional(Optional<T>&& opt) : value(opt ? std::make_shared<const T>(std::move(*opt)) : nullptr) {}
+
+    explicit operator bool() const { return value != nullptr; }
+    bool operator!() const { return value == nullptr; }
+    const T& operator*() const { assert(value); return *value; }
+    const T* operator->() const { assert(value); return value.get(); }
+
+    const std::shared_ptr<const T>& GetShared() const { return value; }
+    //! Copy of the value, held in place
+    Optional<T> ToOptional() const { return value ? Optional<T>(*value) : Optional<T>(); }
+
+    friend bool operator==(const SharedOptional& a, boost::none_t) { return a.value == nullptr; }
+    friend bool operator!=(const SharedOptional& a, boost::none_t) { return a.value != nullptr; }
+
+private:
+    std::shared_ptr<const T> value;
+};
+
 #endif // BITCOIN_OPTIONAL_H
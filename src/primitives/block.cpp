@@ -33,6 +33,18 @@ uint256 CBlockHeader::GetHash() const
     return SerializeHash(*this);
 }
 
+std::vector<unsigned int> CBlock::GetTxOffsets() const
+{
+    std::vector<unsigned int> vOffsets;
+    vOffsets.reserve(vtx.size());
+    unsigned int nOffset = GetSizeOfCompactSize(vtx.size());
+    for (const CTransactionRef& tx : vtx) {
+        vOffsets.push_back(nOffset);
+        nOffset += tx->GetTotalSize();
+    }
+    return vOffsets;
+}
+
 std::string CBlock::ToString() const
 {
     std::stringstream s;
@@ -151,6 +151,10 @@ public:
         return !IsProofOfStake();
     }
 
+    //! Offsets of the transactions in the serialized block, from the end of the
+    //! header (as CDiskTxPos::nTxOffset). Free to compute, as tx sizes are cached.
+    std::vector<unsigned int> GetTxOffsets() const;
+
     std::string ToString() const;
     void print() const;
 };
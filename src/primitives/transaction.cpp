@@ -109,27 +109,92 @@ std::string CTxOut::ToString() const
 }
 
 CMutableTransaction::CMutableTransaction() : nVersion(CTransaction::CURRENT_VERSION), nType(CTransaction::TxType::NORMAL), nLockTime(0) {}
-CMutableTransaction::CMutableTransaction(const CTransaction& tx) : nVersion(tx.nVersion), nType(tx.nType), vin(tx.vin), vout(tx.vout), nLockTime(tx.nLockTime), sapData(tx.sapData), extraPayload(tx.extraPayload) {}
+CMutableTransaction::CMutableTransaction(const CTransaction& tx) : nVersion(tx.nVersion), nType(tx.nType), vin(tx.vin), vout(tx.vout), nLockTime(tx.nLockTime), sapData(tx.sapData.ToOptional()), extraPayload(tx.extraPayload.ToOptional()) {}
 
 uint256 CMutableTransaction::GetHash() const
 {
     return SerializeHash(*this);
 }
 
-uint256 CTransaction::ComputeHash() const
+namespace {
+/** Hash writer that also counts the bytes written */
+class CSizeHashWriter
 {
-    return SerializeHash(*this);
+private:
+    CHashWriter hasher;
+    size_t nSize{0};
+
+public:
+    CSizeHashWriter(int nTypeIn, int nVersionIn) : hasher(nTypeIn, nVersionIn) {}
+
+    int GetType() const { return hasher.GetType(); }
+    int GetVersion() const { return hasher.GetVersion(); }
+
+    void write(const char* pch, size_t size)
+    {
+        hasher.write(pch, size);
+        nSize += size;
+    }
+
+    template <typename T>
+    CSizeHashWriter& operator<<(const T& obj)
+    {
+        ::Serialize(*this, obj);
+        return (*this);
+    }
+
+    size_t size() const { return nSize; }
+    uint256 GetHash() { return hasher.GetHash(); }
+};
+} // anon namespace
+
+uint256 CTransaction::ComputeHash()
+{
+    // Single serialization pass for both the hash and the size
+    CSizeHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << *this;
+    nTotalSize = ss.size();
+    return ss.GetHash();
+}
+
+// Empty instance, shared by all the transactions without shielded data
+static const std::shared_ptr<const SaplingTxData>& EmptySaplingData()
+{
+    static const std::shared_ptr<const SaplingTxData> empty = std::make_shared<const SaplingTxData>();
+    return empty;
+}
+
+template <typename SapData>
+static SharedOptional<SaplingTxData> MakeSaplingData(SapData&& sapData)
+{
+    if (!sapData) return nullopt;
+    if (sapData->IsEmpty()) return SharedOptional<SaplingTxData>(EmptySaplingData());
+    return SharedOptional<SaplingTxData>(std::forward<SapData>(sapData));
 }
 
 size_t CTransaction::DynamicMemoryUsage() const
 {
-    return memusage::RecursiveDynamicUsage(vin) + memusage::RecursiveDynamicUsage(vout);
+    size_t usage = memusage::RecursiveDynamicUsage(vin) + memusage::RecursiveDynamicUsage(vout);
+    if (sapData && sapData.GetShared() != EmptySaplingData()) {
+        usage += memusage::DynamicUsage(sapData.GetShared()) +
+                 memusage::DynamicUsage(sapData->vShieldedSpend) +
+                 memusage::DynamicUsage(sapData->vShieldedOutput);
+    }
+    if (extraPayload) {
+        usage += memusage::DynamicUsage(extraPayload.GetShared()) + memusage::DynamicUsage(*extraPayload);
+    }
+    return usage;
 }
 
 /* For backward compatibility, the hash is initialized to 0. TODO: remove the need for this default constructor entirely. */
-CTransaction::CTransaction() : nVersion(CTransaction::CURRENT_VERSION), nType(TxType::NORMAL), vin(), vout(), nLockTime(0), hash() {}
-CTransaction::CTransaction(const CMutableTransaction &tx) : nVersion(tx.nVersion), nType(tx.nType), vin(tx.vin), vout(tx.vout), nLockTime(tx.nLockTime), sapData(tx.sapData), extraPayload(tx.extraPayload), hash(ComputeHash()) {}
-CTransaction::CTransaction(CMutableTransaction &&tx) : nVersion(tx.nVersion), nType(tx.nType), vin(std::move(tx.vin)), vout(std::move(tx.vout)), nLockTime(tx.nLockTime), sapData(tx.sapData), extraPayload(tx.extraPayload), hash(ComputeHash()) {}
+CTransaction::CTransaction() : nVersion(CTransaction::CURRENT_VERSION), nType(TxType::NORMAL), vin(), vout(), nLockTime(0), sapData(EmptySaplingData()), hash()
+{
+    // Only the size: for backward compatibility the hash is left null (see above)
+    ComputeHash();
+}
+CTransaction::CTransaction(const CMutableTransaction &tx) : nVersion(tx.nVersion), nType(tx.nType), vin(tx.vin), vout(tx.vout), nLockTime(tx.nLockTime), sapData(MakeSaplingData(tx.sapData)), extraPayload(tx.extraPayload), hash(ComputeHash()) {}
+CTransaction::CTransaction(CMutableTransaction &&tx) : nVersion(tx.nVersion), nType(tx.nType), vin(std::move(tx.vin)), vout(std::move(tx.vout)), nLockTime(tx.nLockTime), sapData(MakeSaplingData(std::move(tx.sapData))), extraPayload(std::move(tx.extraPayload)), hash(ComputeHash()) {}
+CTransaction::CTransaction(CHashedMutableTransaction&& htx) : nVersion(htx.tx.nVersion), nType(htx.tx.nType), vin(std::move(htx.tx.vin)), vout(std::move(htx.tx.vout)), nLockTime(htx.tx.nLockTime), sapData(MakeSaplingData(std::move(htx.tx.sapData))), extraPayload(std::move(htx.tx.extraPayload)), nTotalSize(htx.nSize), hash(htx.hash.IsNull() ? ComputeHash() : htx.hash) {}
 
 bool CTransaction::HasZerocoinSpendInputs() const
 {
@@ -262,11 +327,6 @@ unsigned int CTransaction::CalculateModifiedSize(unsigned int nTxSize) const
     return nTxSize;
 }
 
-unsigned int CTransaction::GetTotalSize() const
-{
-    return ::GetSerializeSize(*this, SER_NETWORK, PROTOCOL_VERSION);
-}
-
 std::string CTransaction::ToString() const
 {
     std::ostringstream ss;
@@ -8,6 +8,7 @@
 #define BITCOIN_PRIMITIVES_TRANSACTION_H
 
 #include "amount.h"
+#include "hash.h"
 #include "memusage.h"
 #include "script/script.h"
 #include "serialize.h"
@@ -213,6 +214,7 @@ public:
 };
 
 struct CMutableTransaction;
+struct CHashedMutableTransaction;
 
 /**
  * Transaction serialization format:
@@ -288,8 +290,10 @@ public:
     std::vector<CTxIn> vin;
     std::vector<CTxOut> vout;
     const uint32_t nLockTime;
-    Optional<SaplingTxData> sapData{SaplingTxData()}; // Future: Don't initialize it by default
-    Optional<std::vector<uint8_t>> extraPayload{nullopt};     // only available for special transaction types
+    // Held out of line, and allocated only when not empty: transparent transactions
+    // share a single empty SaplingTxData, and have no extraPayload.
+    SharedOptional<SaplingTxData> sapData;
+    SharedOptional<std::vector<uint8_t>> extraPayload;     // only available for special transaction types
 
     /** Construct a CTransaction that qualifies as IsNull() */
     CTransaction();
@@ -300,15 +304,21 @@ public:
 
     CTransaction(const CTransaction& tx) = default;
 
+    void Serialize(CSizeComputer& s) const
+    {
+        // Optimized implementation for ::GetSerializeSize: the size is cached
+        s.seek(nTotalSize);
+    }
     template <typename Stream>
     inline void Serialize(Stream& s) const {
         SerializeTransaction(*this, s);
     }
 
     /** This deserializing constructor is provided instead of an Unserialize method.
-      *  Unserialize is not possible, since it would require overwriting const fields. */
+      *  Unserialize is not possible, since it would require overwriting const fields.
+      *  When possible, the hash is computed on the bytes while they are read (see ReadHashed). */
     template <typename Stream>
-    CTransaction(deserialize_type, Stream& s) : CTransaction(CMutableTransaction(deserialize, s)) {}
+    CTransaction(deserialize_type, Stream& s) : CTransaction(ReadHashed(s)) {}
 
     bool IsNull() const {
         return vin.empty() && vout.empty();
@@ -411,7 +421,8 @@ public:
         return a.hash != b.hash;
     }
 
-    unsigned int GetTotalSize() const;
+    // Serialized size (the same for every serialization type and version), computed along with the hash
+    unsigned int GetTotalSize() const { return nTotalSize; }
 
     std::string ToString() const;
 
@@ -419,8 +430,13 @@ public:
 
 private:
     /** Memory only. */
+    unsigned int nTotalSize{0}; // set by ComputeHash: must be declared before the hash
     const uint256 hash;
-    uint256 ComputeHash() const;
+    uint256 ComputeHash();
+
+    CTransaction(CHashedMutableTransaction&& htx);
+    template <typename Stream>
+    static CHashedMutableTransaction ReadHashed(Stream& s);
 };
 
 /** A mutable version of CTransaction. */
@@ -472,6 +488,31 @@ struct CMutableTransaction
     }
 };
 
+/** A deserialized transaction, with the hash and size of the bytes it was read from */
+struct CHashedMutableTransaction
+{
+    CMutableTransaction tx;
+    uint256 hash;               // null if the bytes read can't be used for the hash
+    unsigned int nSize{0};
+};
+
+template <typename Stream>
+CHashedMutableTransaction CTransaction::ReadHashed(Stream& s)
+{
+    CHashedMutableTransaction htx;
+    CHashVerifier<Stream> hashreader(&s);
+    htx.tx.Unserialize(hashreader);
+    // The encoding of the transparent versions is canonical (compact sizes are checked
+    // on read), so their txid is the hash of the bytes read, and there is no need to
+    // serialize them again. The optional fields of the Sapling version accept any
+    // non-zero discriminant instead: those are hashed as re-serialized.
+    if (!htx.tx.isSaplingVersion()) {
+        htx.hash = hashreader.GetHash();
+        htx.nSize = hashreader.GetReadSize();
+    }
+    return htx;
+}
+
 typedef std::shared_ptr<const CTransaction> CTransactionRef;
 static inline CTransactionRef MakeTransactionRef() { return std::make_shared<const CTransaction>(); }
 template <typename Tx> static inline CTransactionRef MakeTransactionRef(Tx&& txIn) { return std::make_shared<const CTransaction>(std::forward<Tx>(txIn)); }
@@ -12,9 +12,11 @@
 #include "clientmodel.h"
 #include "optionsmodel.h"
 #include "utiltime.h"
+#include <limits>
 #include <QPainter>
 #include <QModelIndex>
 #include <QList>
+#include <QTime>
 #include <QGraphicsLayout>
 
 #define DECORATION_SIZE 65
@@ -481,58 +483,37 @@ void DashboardWidget::changeChartColors()
     if (set1) set1->setBorderColor(gridLineColorX);
 }
 
-void DashboardWidget::updateStakeFilter()
+static int64_t toLocalTime(const QDate& date)
 {
-    if (!stakesFilter) return;
-    if (chartShow != ALL) {
-        bool filterByMonth = false;
-        if (monthFilter != 0 && chartShow == MONTH) {
-            filterByMonth = true;
-        }
-        if (yearFilter != 0) {
-            if (filterByMonth) {
-                QDate monthFirst = QDate(yearFilter, monthFilter, 1);
-                stakesFilter->setDateRange(
-                        QDateTime(monthFirst),
-                        QDateTime(QDate(yearFilter, monthFilter, monthFirst.daysInMonth()))
-                );
-            } else {
-                stakesFilter->setDateRange(
-                        QDateTime(QDate(yearFilter, 1, 1)),
-                        QDateTime(QDate(yearFilter, 12, 31))
-                );
-            }
-        } else if (filterByMonth) {
-            QDate currentDate = QDate::currentDate();
-            QDate monthFirst = QDate(currentDate.year(), monthFilter, 1);
-            stakesFilter->setDateRange(
-                    QDateTime(monthFirst),
-                    QDateTime(QDate(currentDate.year(), monthFilter, monthFirst.daysInMonth()))
-            );
-            ui->comboBoxYears->setCurrentText(QString::number(currentDate.year()));
-        } else {
-            stakesFilter->clearDateRange();
-        }
-    } else {
-        stakesFilter->clearDateRange();
-    }
+    return QDateTime(date, QTime(0, 0)).toMSecsSinceEpoch() / 1000;
 }
 
 // pair PIV, zPIV
 const QMap<int, std::pair<qint64, qint64>> DashboardWidget::getAmountBy()
 {
-    if (filterUpdateNeeded) {
-        filterUpdateNeeded = false;
-        updateStakeFilter();
+    // Days of the selected month or year (local time)
+    int64_t nTimeFrom = 0;
+    int64_t nTimeTo = std::numeric_limits<int64_t>::max();
+    if (chartShow != ALL) {
+        const int year = yearFilter != 0 ? yearFilter : QDate::currentDate().year();
+        if (monthFilter != 0 && chartShow == MONTH) {
+            const QDate monthFirst = QDate(year, monthFilter, 1);
+            nTimeFrom = toLocalTime(monthFirst);
+            nTimeTo = toLocalTime(monthFirst.addMonths(1)) - 1;
+        } else if (yearFilter != 0) {
+            nTimeFrom = toLocalTime(QDate(year, 1, 1));
+            nTimeTo = toLocalTime(QDate(year + 1, 1, 1)) - 1;
+        }
     }
-    const int size = stakesFilter->rowCount();
+
+    // Read the rewards aggregate of the wallet (quarter hours, summed into the local days)
     QMap<int, std::pair<qint64, qint64>> amountBy;
-    // Get all of the stakes
-    for (int i = 0; i < size; ++i) {
-        QModelIndex modelIndex = stakesFilter->index(i, TransactionTableModel::ToAddress);
-        qint64 amount = llabs(modelIndex.data(TransactionTableModel::AmountRole).toLongLong());
-        QDate date = modelIndex.data(TransactionTableModel::DateRole).toDateTime().date();
-        bool isPiv = modelIndex.data(TransactionTableModel::TypeRole).toInt() != TransactionRecord::StakeZPIV;
+    for (const auto& it : walletModel->getStakingRewards(nTimeFrom, nTimeTo)) {
+        const qint64 amountPiv = it.second.nStake + it.second.nDelegated + it.second.nGenerated;
+        const qint64 amountZpiv = it.second.nZpivStake;
+        if (amountPiv == 0 && amountZpiv == 0) continue;
+        if (amountZpiv != 0) hasZpivStakes = true;
+        QDate date = QDateTime::fromMSecsSinceEpoch(it.first * 1000).date();
 
         int time = 0;
         switch (chartShow) {
@@ -553,17 +534,10 @@ const QMap<int, std::pair<qint64, qint64>> DashboardWidget::getAmountBy()
                 return amountBy;
         }
         if (amountBy.contains(time)) {
-            if (isPiv) {
-                amountBy[time].first += amount;
-            } else
-                amountBy[time].second += amount;
+            amountBy[time].first += amountPiv;
+            amountBy[time].second += amountZpiv;
         } else {
-            if (isPiv) {
-                amountBy[time] = std::make_pair(amount, 0);
-            } else {
-                amountBy[time] = std::make_pair(0, amount);
-                hasZpivStakes = true;
-            }
+            amountBy[time] = std::make_pair(amountPiv, amountZpiv);
         }
     }
     return amountBy;
@@ -620,7 +594,6 @@ void DashboardWidget::onChartYearChanged(const QString& yearStr)
         int newYear = yearStr.toInt();
         if (newYear != yearFilter) {
             yearFilter = newYear;
-            filterUpdateNeeded = true;
             refreshChart();
         }
     }
@@ -632,7 +605,6 @@ void DashboardWidget::onChartMonthChanged(const QString& monthStr)
         int newMonth = ui->comboBoxMonths->currentData().toInt();
         if (newMonth != monthFilter) {
             monthFilter = newMonth;
-            filterUpdateNeeded = true;
             refreshChart();
 #ifndef Q_OS_MAC
         // quick hack to re paint the chart view.
@@ -825,7 +797,6 @@ void DashboardWidget::onChartArrowClicked(bool goLeft)
             }
         }
     }
-    filterUpdateNeeded = true;
     refreshChart();
     //Check if data end day is current date and monthfilter is current month
     bool fEndDayisCurrent = dataenddate  == currentDate.day() && monthFilter == currentDate.month();
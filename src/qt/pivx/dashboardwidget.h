@@ -170,13 +170,11 @@ private:
     ChartData* chartData{nullptr};
     bool hasStakes{false};
     bool fShowCharts{true};
-    std::atomic<bool> filterUpdateNeeded{false};
 
     void initChart();
     void showHideEmptyChart(bool show, bool loading, bool forceView = false);
     bool refreshChart();
     void tryChartRefresh();
-    void updateStakeFilter();
     const QMap<int, std::pair<qint64, qint64>> getAmountBy();
     bool loadChartData(bool withMonthNames);
     void updateAxisX(const QStringList *arg = nullptr);
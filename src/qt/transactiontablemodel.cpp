@@ -13,25 +13,24 @@
 #include "transactionrecord.h"
 #include "walletmodel.h"
 
+#include "coins.h"
 #include "interfaces/handler.h"
 #include "sync.h"
 #include "uint256.h"
 #include "wallet/wallet.h"
 
 #include <algorithm>
+#include <limits>
+#include <unordered_map>
 
 #include <QColor>
 #include <QDateTime>
 #include <QIcon>
-#include <QtConcurrent/QtConcurrent>
-#include <QFuture>
 
-#define SINGLE_THREAD_MAX_TXES_SIZE 4000
-
-// Maximum amount of loaded records in ram in the first load.
-// If the user has more and want to load them:
-// TODO, add load on demand in pages (not every tx loaded all the time into the records list).
-#define MAX_AMOUNT_LOADED_RECORDS 20000
+// Amount of wallet transactions decomposed into records per page.
+// The first page is loaded with the model, the following ones on demand (fetchMore),
+// when the views reach the end of the loaded records.
+#define TX_PAGE_SIZE 1000
 
 // Amount column is right-aligned it contains numbers
 static int column_alignments[] = {
@@ -43,28 +42,6 @@ static int column_alignments[] = {
     Qt::AlignRight | Qt::AlignVCenter /* amount */
 };
 
-// Comparison operator for sort/binary search of model tx list
-struct TxLessThan {
-    bool operator()(const TransactionRecord& a, const TransactionRecord& b) const
-    {
-        return a.hash < b.hash;
-    }
-    bool operator()(const TransactionRecord& a, const uint256& b) const
-    {
-        return a.hash < b;
-    }
-    bool operator()(const uint256& a, const TransactionRecord& b) const
-    {
-        return a < b.hash;
-    }
-};
-
-struct ConvertTxToVectorResult
-{
-    QList<TransactionRecord> records;
-    qint64 nFirstLoadedTxTime{0};
-};
-
 // Private implementation
 class TransactionTablePriv
 {
@@ -77,102 +54,83 @@ public:
     CWallet* wallet{nullptr};
     TransactionTableModel* parent;
 
-    /* Local cache of wallet.
-     * As it is in the same order as the CWallet, by definition
-     * this is sorted by sha256.
+    /* Local cache of the loaded wallet transactions, newest first
+     * (wallet order, transactions arrived after the first load on top).
+     * The records of a transaction are contiguous.
      */
     QList<TransactionRecord> cachedWallet;
 
+    /* Rows of the transactions in cachedWallet: hash -> (first row + nRowOffset, number of records).
+     * Records inserted on top decrease nRowOffset instead of shifting every entry,
+     * the index is rebuilt only when records are removed.
+     */
+    std::unordered_map<uint256, std::pair<int64_t, int>, SaltedIdHasher> mapRows;
+    int64_t nRowOffset{0};
+
+    void indexRecords(int from, int to)
+    {
+        for (int i = from; i < to; i++) {
+            auto it = mapRows.emplace(cachedWallet[i].hash, std::make_pair(i + nRowOffset, 0)).first;
+            it->second.second++;
+        }
+    }
+
+    void rebuildIndex()
+    {
+        mapRows.clear();
+        nRowOffset = 0;
+        indexRecords(0, cachedWallet.size());
+    }
+
     /**
-     * Time of the oldest transaction loaded into the model.
-     * It can or not be the first tx in the wallet, the model only loads the last 20k txs.
+     * Wallet order position (nOrderPos) of the oldest transaction loaded into the model.
+     * Older transactions are loaded in pages, on demand.
      */
-    qint64 nFirstLoadedTxTime{0};
+    int64_t nLoadedOrderPos{std::numeric_limits<int64_t>::max()};
+    bool fAllLoaded{false};
 
-    /* Query entire wallet anew from core.
+    /* Load the first page of transactions anew from core.
      */
     void refreshWallet()
     {
         qDebug() << "TransactionTablePriv::refreshWallet";
         cachedWallet.clear();
+        nLoadedOrderPos = std::numeric_limits<int64_t>::max();
+        fAllLoaded = false;
+        cachedWallet.append(loadNextPage());
+        rebuildIndex();
+    }
 
-        std::vector<CWalletTx> walletTxes = wallet->getWalletTxs();
-
-        // Divide the work between multiple threads to speedup the process if the vector is larger than 4k txes
-        std::size_t txesSize = walletTxes.size();
-        if (txesSize > SINGLE_THREAD_MAX_TXES_SIZE) {
-
-            // First check if the amount of txs exceeds the UI limit
-            if (txesSize > MAX_AMOUNT_LOADED_RECORDS) {
-                // Sort the txs by date just to be really really sure that them are ordered.
-                // (this extra calculation should be removed in the future if can ensure that
-                // txs are stored in order in the db, which is what should be happening)
-                sort(walletTxes.begin(), walletTxes.end(),
-                        [](const CWalletTx & a, const CWalletTx & b) -> bool {
-                         return a.GetTxTime() > b.GetTxTime();
-                     });
-
-                // Only latest ones.
-                walletTxes = std::vector<CWalletTx>(walletTxes.begin(), walletTxes.begin() + MAX_AMOUNT_LOADED_RECORDS);
-                txesSize = walletTxes.size();
-            }
-
-            // Simple way to get the processors count
-            std::size_t threadsCount = (QThreadPool::globalInstance()->maxThreadCount() / 2 ) + 1;
-
-            // Size of the tx subsets
-            std::size_t const subsetSize = txesSize / (threadsCount + 1);
-            std::size_t totalSumSize = 0;
-            QList<QFuture<ConvertTxToVectorResult>> tasks;
-
-            // Subsets + run task
-            for (std::size_t i = 0; i < threadsCount; ++i) {
-                tasks.append(
-                        QtConcurrent::run(
-                                convertTxToRecords,
-                                wallet,
-                                std::vector<CWalletTx>(walletTxes.begin() + totalSumSize, walletTxes.begin() + totalSumSize + subsetSize)
-                        )
-                 );
-                totalSumSize += subsetSize;
-            }
+    /* Decompose the next page of wallet transactions (older than the loaded ones),
+     * straight from the wallet's ordered index.
+     */
+    QList<TransactionRecord> loadNextPage()
+    {
+        QList<TransactionRecord> records;
+        size_t nTxs = 0;
+        nLoadedOrderPos = wallet->ForEachOrderedTx(nLoadedOrderPos, TX_PAGE_SIZE,
+                [this, &records, &nTxs](const CWalletTx& wtx) {
+                    records.append(TransactionRecord::decomposeTransaction(wallet, wtx));
+                    nTxs++;
+                });
+        fAllLoaded = nTxs < TX_PAGE_SIZE;
+        return records;
+    }
 
-            // Now take the remaining ones and do the work here
-            std::size_t const remainingSize = txesSize - totalSumSize;
-            auto res = convertTxToRecords(wallet,
-                                          std::vector<CWalletTx>(walletTxes.end() - remainingSize, walletTxes.end())
-            );
-            cachedWallet.append(res.records);
-            nFirstLoadedTxTime = res.nFirstLoadedTxTime;
-
-            for (auto &future : tasks) {
-                future.waitForFinished();
-                ConvertTxToVectorResult convertRes = future.result();
-                cachedWallet.append(convertRes.records);
-                if (nFirstLoadedTxTime > convertRes.nFirstLoadedTxTime) {
-                    nFirstLoadedTxTime = convertRes.nFirstLoadedTxTime;
-                }
-            }
-        } else {
-            // Single thread flow
-            ConvertTxToVectorResult convertRes = convertTxToRecords(wallet, walletTxes);
-            cachedWallet.append(convertRes.records);
-            nFirstLoadedTxTime = convertRes.nFirstLoadedTxTime;
-        }
+    bool canFetchMore() const
+    {
+        return !fAllLoaded;
     }
 
-    static ConvertTxToVectorResult convertTxToRecords(const CWallet* wallet, const std::vector<CWalletTx>& walletTxes) {
-        ConvertTxToVectorResult res;
-        for (const auto& tx : walletTxes) {
-            QList<TransactionRecord> records = TransactionRecord::decomposeTransaction(wallet, tx);
-            if (records.isEmpty()) continue;
-            qint64 time = records.first().time;
-            if (res.nFirstLoadedTxTime == 0 || res.nFirstLoadedTxTime > time) {
-                res.nFirstLoadedTxTime = time;
-            }
-            res.records.append(records);
-        }
-        return res;
+    void fetchMore()
+    {
+        if (fAllLoaded) return;
+        QList<TransactionRecord> records = loadNextPage();
+        if (records.isEmpty()) return;
+        parent->beginInsertRows(QModelIndex(), cachedWallet.size(), cachedWallet.size() + records.size() - 1);
+        cachedWallet.append(records);
+        indexRecords(cachedWallet.size() - records.size(), cachedWallet.size());
+        parent->endInsertRows();
     }
 
     /* Update our model of the wallet incrementally, to synchronize our model of the wallet
@@ -185,13 +143,10 @@ public:
         qDebug() << "TransactionTablePriv::updateWallet : " + QString::fromStdString(hash.ToString()) + " " + QString::number(status);
 
         // Find bounds of this transaction in model
-        QList<TransactionRecord>::iterator lower = std::lower_bound(
-            cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan());
-        QList<TransactionRecord>::iterator upper = std::upper_bound(
-            cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan());
-        int lowerIndex = (lower - cachedWallet.begin());
-        int upperIndex = (upper - cachedWallet.begin());
-        bool inModel = (lower != upper);
+        const auto itRows = mapRows.find(hash);
+        bool inModel = (itRows != mapRows.end());
+        int lowerIndex = inModel ? (int)(itRows->second.first - nRowOffset) : 0;
+        int upperIndex = inModel ? lowerIndex + itRows->second.second : 0;
 
         if (status == CT_UPDATED) {
             if (showTransaction && !inModel)
@@ -218,23 +173,25 @@ public:
                         break;
                     }
 
-                    // As old transactions are still getting updated (+20k range),
-                    // do not add them if we deliberately didn't load them at startup.
-                    if (cachedWallet.size() >= MAX_AMOUNT_LOADED_RECORDS && wtx->GetTxTime() < nFirstLoadedTxTime) {
+                    // Transactions in the pages not loaded yet are going to be decomposed
+                    // when the page is fetched.
+                    if (!fAllLoaded && wtx->nOrderPos < nLoadedOrderPos) {
                         return;
                     }
 
-                    // Added -- insert at the right position
+                    // Added -- insert on top
                     QList<TransactionRecord> toInsert =
                         TransactionRecord::decomposeTransaction(wallet, *wtx);
                     if (!toInsert.isEmpty()) { /* only if something to insert */
-                        parent->beginInsertRows(QModelIndex(), lowerIndex, lowerIndex + toInsert.size() - 1);
-                        int insert_idx = lowerIndex;
+                        parent->beginInsertRows(QModelIndex(), 0, toInsert.size() - 1);
+                        int insert_idx = 0;
                         for (const TransactionRecord& rec : toInsert) {
                             cachedWallet.insert(insert_idx, rec);
                             insert_idx += 1;
                             ret = rec; // Return record
                         }
+                        nRowOffset -= toInsert.size();
+                        indexRecords(0, toInsert.size());
                         parent->endInsertRows();
                     }
                 }
@@ -246,7 +203,8 @@ public:
                 }
                 // Removed -- remove entire transaction from table
                 parent->beginRemoveRows(QModelIndex(), lowerIndex, upperIndex - 1);
-                cachedWallet.erase(lower, upper);
+                cachedWallet.erase(cachedWallet.begin() + lowerIndex, cachedWallet.begin() + upperIndex);
+                rebuildIndex();
                 parent->endRemoveRows();
                 break;
             case CT_UPDATED:
@@ -342,6 +300,18 @@ int TransactionTableModel::rowCount(const QModelIndex& parent) const
     return priv->size();
 }
 
+bool TransactionTableModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && priv->canFetchMore();
+}
+
+void TransactionTableModel::fetchMore(const QModelIndex& parent)
+{
+    if (!parent.isValid()) {
+        priv->fetchMore();
+    }
+}
+
 int TransactionTableModel::columnCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent);
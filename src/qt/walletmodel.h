@@ -174,6 +174,8 @@ public:
     CAmount getLockedBalance() const;
     bool haveWatchOnly() const;
     CAmount getDelegatedBalance() const;
+    /** Per-day (UTC) staking rewards of the wallet between the two times */
+    std::map<int64_t, CStakingRewards> getStakingRewards(int64_t nTimeFrom, int64_t nTimeTo) const { return wallet->GetStakingRewards(nTimeFrom, nTimeTo); }
 
     bool isColdStaking() const;
     void getAvailableP2CSCoins(std::vector<COutput>& vCoins) const;
@@ -0,0 +1,136 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "recentblocks.h"
+
+#include "clientversion.h"
+#include "coins.h"
+#include "consensus/consensus.h"
+#include "primitives/block.h"
+#include "streams.h"
+#include "undo.h"
+#include "version.h"
+
+CRecentBlocksCache g_recentblocks;
+
+CRecentBlocksCache::CRecentBlocksCache() :
+    nMaxDepth(DEFAULT_MAX_REORG_DEPTH)
+{
+    stats.nMaxBytes = DEFAULT_RECENT_BLOCKS_CACHE_MB << 20;
+}
+
+void CRecentBlocksCache::Init(int nMaxDepthIn, size_t nMaxBytesIn)
+{
+    LOCK(cs);
+    nMaxDepth = nMaxDepthIn;
+    stats.nMaxBytes = nMaxBytesIn;
+    Trim();
+}
+
+CRecentBlocksCache::Entry& CRecentBlocksCache::GetEntry(const uint256& hash, int nHeight)
+{
+    AssertLockHeld(cs);
+    auto it = mapEntries.find(hash);
+    if (it == mapEntries.end()) {
+        it = mapEntries.emplace(hash, Entry()).first;
+        it->second.nHeight = nHeight;
+        setByHeight.emplace(nHeight, hash);
+    }
+    if (nHeight > nBestHeight) nBestHeight = nHeight;
+    return it->second;
+}
+
+void CRecentBlocksCache::Evict(std::map<uint256, Entry>::iterator it)
+{
+    AssertLockHeld(cs);
+    Entry& entry = it->second;
+    if (entry.pblock) stats.nBlocks--;
+    if (!entry.vUndo.empty()) stats.nUndos--;
+    stats.nBytes -= entry.nBlockSize + entry.vUndo.size();
+    setByHeight.erase(std::make_pair(entry.nHeight, it->first));
+    mapEntries.erase(it);
+}
+
+void CRecentBlocksCache::Trim()
+{
+    AssertLockHeld(cs);
+    // blocks deeper than the max reorg depth can't be disconnected anymore
+    while (!setByHeight.empty() &&
+           (setByHeight.begin()->first <= nBestHeight - nMaxDepth || stats.nBytes > stats.nMaxBytes)) {
+        Evict(mapEntries.find(setByHeight.begin()->second));
+    }
+}
+
+void CRecentBlocksCache::AddBlock(const uint256& hash, int nHeight, const std::shared_ptr<const CBlock>& pblock)
+{
+    LOCK(cs);
+    if (stats.nMaxBytes == 0) return; // disabled
+    Entry& entry = GetEntry(hash, nHeight);
+    if (!entry.pblock) {
+        entry.pblock = pblock;
+        entry.nBlockSize = ::GetSerializeSize(*pblock, SER_NETWORK, PROTOCOL_VERSION);
+        stats.nBlocks++;
+        stats.nBytes += entry.nBlockSize;
+    }
+    Trim();
+}
+
+void CRecentBlocksCache::AddUndo(const uint256& hash, int nHeight, const CBlockUndoBuffer& undo)
+{
+    LOCK(cs);
+    if (stats.nMaxBytes == 0) return; // disabled
+    Entry& entry = GetEntry(hash, nHeight);
+    if (entry.vUndo.empty()) {
+        entry.vUndo.assign(undo.data(), undo.data() + undo.size());
+        stats.nUndos++;
+        stats.nBytes += entry.vUndo.size();
+    }
+    Trim();
+}
+
+std::shared_ptr<const CBlock> CRecentBlocksCache::GetBlock(const uint256& hash)
+{
+    LOCK(cs);
+    const auto it = mapEntries.find(hash);
+    if (it == mapEntries.end() || !it->second.pblock) {
+        stats.nBlockMisses++;
+        return nullptr;
+    }
+    stats.nBlockHits++;
+    return it->second.pblock;
+}
+
+bool CRecentBlocksCache::GetUndo(const uint256& hash, CBlockUndo& undo)
+{
+    LOCK(cs);
+    const auto it = mapEntries.find(hash);
+    if (it == mapEntries.end() || it->second.vUndo.empty()) {
+        stats.nUndoMisses++;
+        return false;
+    }
+    try {
+        CDataStream ss(it->second.vUndo.data(), it->second.vUndo.data() + it->second.vUndo.size(), SER_DISK, CLIENT_VERSION);
+        ss >> undo;
+    } catch (const std::exception& e) {
+        stats.nUndoMisses++;
+        return false;
+    }
+    stats.nUndoHits++;
+    return true;
+}
+
+CRecentBlocksCache::Stats CRecentBlocksCache::GetStats() const
+{
+    LOCK(cs);
+    return stats;
+}
+
+void CRecentBlocksCache::Clear()
+{
+    LOCK(cs);
+    mapEntries.clear();
+    setByHeight.clear();
+    nBestHeight = -1;
+    stats.nBlocks = stats.nUndos = stats.nBytes = 0;
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PIVX_RECENTBLOCKS_H
+#define PIVX_RECENTBLOCKS_H
+
+#include "sync.h"
+#include "uint256.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+class CBlock;
+class CBlockUndo;
+class CBlockUndoBuffer;
+
+/** Default for the memory limit of the recent blocks cache, in MiB */
+static const unsigned int DEFAULT_RECENT_BLOCKS_CACHE_MB = 64;
+
+/**
+ * Cache of the blocks (and undo data) that can still be involved in a reorg:
+ * the last connected blocks, with the undo data written by ConnectBlock, and the
+ * recently received side-chain blocks.
+ * DisconnectTip/DisconnectBlock and ConnectTip look here before going to disk,
+ * so that shallow reorgs don't read back the blocks (and undo) they just wrote.
+ *
+ * The entries are evicted lowest height first: when they are deeper than the
+ * maximum reorg depth, and when the cache goes over its memory limit.
+ */
+class CRecentBlocksCache
+{
+public:
+    struct Stats {
+        size_t nBlocks{0};
+        size_t nUndos{0};
+        size_t nBytes{0};
+        size_t nMaxBytes{0};
+        uint64_t nBlockHits{0};
+        uint64_t nBlockMisses{0};
+        uint64_t nUndoHits{0};
+        uint64_t nUndoMisses{0};
+    };
+
+    CRecentBlocksCache();
+
+    void Init(int nMaxDepthIn, size_t nMaxBytesIn);
+
+    void AddBlock(const uint256& hash, int nHeight, const std::shared_ptr<const CBlock>& pblock);
+    void AddUndo(const uint256& hash, int nHeight, const CBlockUndoBuffer& undo);
+
+    /** nullptr if the block isn't cached */
+    std::shared_ptr<const CBlock> GetBlock(const uint256& hash);
+    /** false if the undo data of the block isn't cached */
+    bool GetUndo(const uint256& hash, CBlockUndo& undo);
+
+    Stats GetStats() const;
+    void Clear();
+
+private:
+    struct Entry {
+        int nHeight{-1};
+        std::shared_ptr<const CBlock> pblock;
+        size_t nBlockSize{0};
+        std::vector<char> vUndo;    // serialized CBlockUndo
+    };
+
+    mutable Mutex cs;
+    std::map<uint256, Entry> mapEntries GUARDED_BY(cs);
+    std::set<std::pair<int, uint256>> setByHeight GUARDED_BY(cs);
+    int nMaxDepth GUARDED_BY(cs);
+    int nBestHeight GUARDED_BY(cs){-1};
+    Stats stats GUARDED_BY(cs);
+
+    Entry& GetEntry(const uint256& hash, int nHeight) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void Evict(std::map<uint256, Entry>::iterator it) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void Trim() EXCLUSIVE_LOCKS_REQUIRED(cs);
+};
+
+extern CRecentBlocksCache g_recentblocks;
+
+#endif // PIVX_RECENTBLOCKS_H
@@ -15,6 +15,7 @@
 #include "masternodeman.h"
 #include "policy/feerate.h"
 #include "policy/policy.h"
+#include "recentblocks.h"
 #include "rpc/server.h"
 #include "sync.h"
 #include "txdb.h"
@@ -576,7 +577,7 @@ UniValue getblock(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
 
     if (!fVerbose) {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+        CPooledDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
         ssBlock << block;
         std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
         return strHex;
@@ -1145,6 +1146,42 @@ UniValue getchaintips(const JSONRPCRequest& request)
     return res;
 }
 
+UniValue getreorgcacheinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getreorgcacheinfo\n"
+            "Returns the state of the recent blocks cache: the last connected blocks (with their undo data)\n"
+            "and the recently received side-chain blocks, kept in memory so that reorgs don't read them from disk.\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"blocks\": n,             (numeric) number of cached blocks\n"
+            "  \"undos\": n,              (numeric) number of cached undo data\n"
+            "  \"bytes\": n,              (numeric) size of the cached blocks and undo data\n"
+            "  \"max_bytes\": n,          (numeric) memory limit of the cache\n"
+            "  \"block_hits\": n,         (numeric) blocks found in the cache, while connecting or disconnecting them\n"
+            "  \"block_misses\": n,       (numeric) blocks read from disk instead\n"
+            "  \"undo_hits\": n,          (numeric) undo data found in the cache, while disconnecting blocks\n"
+            "  \"undo_misses\": n         (numeric) undo data read from disk instead\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getreorgcacheinfo", "") + HelpExampleRpc("getreorgcacheinfo", ""));
+
+    const CRecentBlocksCache::Stats& stats = g_recentblocks.GetStats();
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("blocks", (int64_t)stats.nBlocks);
+    ret.pushKV("undos", (int64_t)stats.nUndos);
+    ret.pushKV("bytes", (int64_t)stats.nBytes);
+    ret.pushKV("max_bytes", (int64_t)stats.nMaxBytes);
+    ret.pushKV("block_hits", (int64_t)stats.nBlockHits);
+    ret.pushKV("block_misses", (int64_t)stats.nBlockMisses);
+    ret.pushKV("undo_hits", (int64_t)stats.nUndoHits);
+    ret.pushKV("undo_misses", (int64_t)stats.nUndoMisses);
+    return ret;
+}
+
 UniValue mempoolInfoToJSON()
 {
     UniValue ret(UniValue::VOBJ);
@@ -1454,6 +1491,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getfeeinfo",             &getfeeinfo,             true,  {"blocks"} },
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         true,  {} },
     { "blockchain",         "getrawmempool",          &getrawmempool,          true,  {"verbose"} },
+    { "blockchain",         "getreorgcacheinfo",      &getreorgcacheinfo,      true,  {} },
     { "blockchain",         "getsupplyinfo",          &getsupplyinfo,          true,  {"force_update"} },
     { "blockchain",         "gettxout",               &gettxout,               true,  {"txid","n","include_mempool"} },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true,  {} },
@@ -67,6 +67,8 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     { "getreceivedbyaddress", 1, "minconf" },
     { "getreceivedbylabel", 1, "minconf" },
     { "getsaplingnotescount", 0, "minconf" },
+    { "getstakingrewards", 0, "from" },
+    { "getstakingrewards", 1, "to" },
     { "getsupplyinfo", 0, "force_update" },
     { "gettransaction", 1, "include_watchonly" },
     { "gettxout", 1, "n" },
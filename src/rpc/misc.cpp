@@ -747,6 +747,45 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     return obj;
 }
 
+UniValue getstartupinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getstartupinfo\n"
+            "Returns the duration of the node startup, and of each of its phases.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"duration\": xxxxx,            (numeric) Time in milliseconds from the beginning of the initialization to the node being ready\n"
+            "  \"phases\": [                   (json array) The phases, in order of completion\n"
+            "    {\n"
+            "      \"name\": \"xxxx\",           (string) The phase name (e.g. load_block_index, sapling_params, wallet)\n"
+            "      \"start\": xxxxx,           (numeric) Start of the phase, in milliseconds from the beginning of the initialization\n"
+            "      \"duration\": xxxxx,        (numeric) Duration of the phase in milliseconds\n"
+            "      \"concurrent\": true|false, (boolean) Whether the phase ran concurrently with the others\n"
+            "    }\n"
+            "    ,...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getstartupinfo", "")
+            + HelpExampleRpc("getstartupinfo", "")
+        );
+
+    UniValue phases(UniValue::VARR);
+    for (const StartupPhase& phase : GetStartupPhases()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("name", phase.name);
+        obj.pushKV("start", phase.nStart);
+        obj.pushKV("duration", phase.nDuration);
+        obj.pushKV("concurrent", phase.fConcurrent);
+        phases.push_back(obj);
+    }
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("duration", GetStartupDuration());
+    ret.pushKV("phases", phases);
+    return ret;
+}
+
 UniValue echo(const JSONRPCRequest& request)
 {
     if (request.fHelp)
@@ -765,6 +804,7 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------  -----------------------  ------ --------
     { "control",            "getinfo",                &getinfo,                true,  {} }, /* uses wallet if enabled */
     { "control",            "getmemoryinfo",          &getmemoryinfo,          true,  {} },
+    { "control",            "getstartupinfo",         &getstartupinfo,         true,  {} },
     { "control",            "mnsync",                 &mnsync,                 true,  {"mode"} },
     { "control",            "spork",                  &spork,                  true,  {"name","value"} },
 
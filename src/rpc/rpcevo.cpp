@@ -10,6 +10,7 @@
 #include "evo/providertx.h"
 #include "key_io.h"
 #include "masternode.h"
+#include "masternode-collaterals.h"
 #include "messagesigner.h"
 #include "netbase.h"
 #include "operationresult.h"
@@ -628,18 +629,6 @@ static bool CheckWalletOwnsScript(CWallet* pwallet, const CScript& script)
 #endif
 }
 
-static Optional<int> GetUTXOConfirmations(const COutPoint& outpoint)
-{
-    // nullopt means UTXO is yet unknown or already spent
-    Optional<int> coinHeight = GetUTXOHeight(outpoint);
-    if (coinHeight == nullopt || *coinHeight < 0)
-        return nullopt;
-    int nChainHeight(WITH_LOCK(cs_main, return chainActive.Height(); ));
-    if (nChainHeight < 0 || *coinHeight > nChainHeight)
-        return nullopt;
-    return Optional<int>(nChainHeight - *coinHeight + 1);
-}
-
 static void AddDMNEntryToList(UniValue& ret, CWallet* pwallet, const CDeterministicMNCPtr& dmn, bool fVerbose, bool fFromWallet)
 {
     assert(!fFromWallet || pwallet);
@@ -675,7 +664,7 @@ static void AddDMNEntryToList(UniValue& ret, CWallet* pwallet, const CDeterminis
     if (fVerbose) {
         UniValue o(UniValue::VOBJ);
         dmn->ToJson(o);
-        Optional<int> confirmations = GetUTXOConfirmations(dmn->collateralOutpoint);
+        Optional<int> confirmations = g_collateralWatchSet.GetConfirmations(dmn->collateralOutpoint);
         o.pushKV("confirmations", confirmations ? *confirmations : -1);
         o.pushKV("hasOwnerKey", hasOwnerKey);
         o.pushKV("hasOperatorKey", hasOperatorKey);
@@ -1137,6 +1137,82 @@ void IncrementalWitness<Depth, Hash>::append(Hash obj) {
     }
 }
 
+// This finds the position of the next leaf the witness expects: the leaves of
+// the tree, of the filled subtrees, and of the cursor.
+template<size_t Depth, typename Hash>
+uint64_t IncrementalWitness<Depth, Hash>::next_position() const {
+    uint64_t pos = tree.size();
+    for (size_t i = 0; i < filled.size(); i++) {
+        pos += (uint64_t)1 << tree.next_depth(i);
+    }
+    if (cursor) {
+        pos += cursor->size();
+    }
+    return pos;
+}
+
+template<size_t Depth, typename Hash>
+void IncrementalWitness<Depth, Hash>::append(IncrementalMerkleBatch<Depth, Hash>& batch) {
+    uint64_t pos = next_position();
+    if (pos < batch.begin() || pos > batch.end()) {
+        throw std::runtime_error("witness is not contiguous with the batch");
+    }
+
+    // Complete the current cursor first
+    while (cursor && pos < batch.end()) {
+        append(batch.leaf(pos++));
+    }
+
+    // The following uncles are either entirely inside the batch, and shared
+    // with every other witness, or the last incomplete one.
+    while (pos < batch.end()) {
+        cursor_depth = tree.next_depth(filled.size());
+
+        if (cursor_depth >= Depth) {
+            throw std::runtime_error("tree is full");
+        }
+
+        const uint64_t subtree_size = (uint64_t)1 << cursor_depth;
+        if (batch.end() - pos < subtree_size) {
+            cursor = batch.partial_tree(pos);
+            break;
+        }
+        filled.push_back(batch.subtree_root(cursor_depth, pos));
+        pos += subtree_size;
+    }
+}
+
+template<size_t Depth, typename Hash>
+Hash IncrementalMerkleBatch<Depth, Hash>::subtree_root(size_t depth, uint64_t pos) {
+    if (depth == 0) {
+        return leaf(pos);
+    }
+
+    const auto key = std::make_pair(depth, pos);
+    auto it = roots.find(key);
+    if (it != roots.end()) {
+        return it->second;
+    }
+
+    const uint64_t half = (uint64_t)1 << (depth - 1);
+    Hash root = Hash::combine(subtree_root(depth - 1, pos), subtree_root(depth - 1, pos + half), depth - 1);
+    roots.emplace(key, root);
+    return root;
+}
+
+template<size_t Depth, typename Hash>
+const IncrementalMerkleTree<Depth, Hash>& IncrementalMerkleBatch<Depth, Hash>::partial_tree(uint64_t pos) {
+    auto it = partials.find(pos);
+    if (it == partials.end()) {
+        IncrementalMerkleTree<Depth, Hash> tree;
+        for (auto leaf = leaves.begin() + (pos - start); leaf != leaves.end(); ++leaf) {
+            tree.append(*leaf);
+        }
+        it = partials.emplace(pos, tree).first;
+    }
+    return it->second;
+}
+
 template class IncrementalMerkleTree<INCREMENTAL_MERKLE_TREE_DEPTH, SHA256Compress>;
 template class IncrementalMerkleTree<INCREMENTAL_MERKLE_TREE_DEPTH_TESTING, SHA256Compress>;
 
@@ -1149,4 +1225,7 @@ template class IncrementalMerkleTree<INCREMENTAL_MERKLE_TREE_DEPTH_TESTING, Pede
 template class IncrementalWitness<SAPLING_INCREMENTAL_MERKLE_TREE_DEPTH, PedersenHash>;
 template class IncrementalWitness<INCREMENTAL_MERKLE_TREE_DEPTH_TESTING, PedersenHash>;
 
+template class IncrementalMerkleBatch<SAPLING_INCREMENTAL_MERKLE_TREE_DEPTH, PedersenHash>;
+template class IncrementalMerkleBatch<INCREMENTAL_MERKLE_TREE_DEPTH_TESTING, PedersenHash>;
+
 } // end namespace `libzcash`
@@ -15,6 +15,7 @@
 
 #include <array>
 #include <deque>
+#include <map>
 
 namespace libzcash {
 
@@ -82,6 +83,35 @@ bool operator==(const EmptyMerkleRoots<Depth, Hash>& a,
 template<size_t Depth, typename Hash>
 class IncrementalWitness;
 
+template<size_t Depth, typename Hash>
+class IncrementalMerkleTree;
+
+// A batch of leaves (e.g. the note commitments of a block) appended at once after
+// the first `start` leaves of the tree.
+// It caches the roots of the subtrees lying entirely inside the batch, and the
+// trailing incomplete subtrees, so that bringing many witnesses up to date with
+// the same batch hashes every internal node only once.
+template<size_t Depth, typename Hash>
+class IncrementalMerkleBatch {
+public:
+    IncrementalMerkleBatch(uint64_t start, std::vector<Hash> leaves) : start(start), leaves(std::move(leaves)) { }
+
+    uint64_t begin() const { return start; }
+    uint64_t end() const { return start + leaves.size(); }
+    const Hash& leaf(uint64_t pos) const { return leaves.at(pos - start); }
+
+    // Root of the complete subtree of height `depth` whose first leaf is at `pos`
+    Hash subtree_root(size_t depth, uint64_t pos);
+    // Tree holding the leaves from `pos` to the end of the batch
+    const IncrementalMerkleTree<Depth, Hash>& partial_tree(uint64_t pos);
+
+private:
+    uint64_t start;
+    std::vector<Hash> leaves;
+    std::map<std::pair<size_t, uint64_t>, Hash> roots;
+    std::map<uint64_t, IncrementalMerkleTree<Depth, Hash>> partials;
+};
+
 template<size_t Depth, typename Hash>
 class IncrementalMerkleTree {
 
@@ -180,6 +210,8 @@ public:
     }
 
     void append(Hash obj);
+    // Append the leaves of the batch that follow the ones already witnessed
+    void append(IncrementalMerkleBatch<Depth, Hash>& batch);
 
     ADD_SERIALIZE_METHODS;
 
@@ -203,6 +235,7 @@ private:
     Optional<IncrementalMerkleTree<Depth, Hash>> cursor;
     size_t cursor_depth = 0;
     std::deque<Hash> partial_path() const;
+    uint64_t next_position() const;
     IncrementalWitness(IncrementalMerkleTree<Depth, Hash> tree) : tree(tree) {}
 };
 
@@ -258,4 +291,7 @@ typedef libzcash::IncrementalMerkleTree<INCREMENTAL_MERKLE_TREE_DEPTH_TESTING, l
 typedef libzcash::IncrementalWitness<SAPLING_INCREMENTAL_MERKLE_TREE_DEPTH, libzcash::PedersenHash> SaplingWitness;
 typedef libzcash::IncrementalWitness<INCREMENTAL_MERKLE_TREE_DEPTH_TESTING, libzcash::PedersenHash> SaplingTestingWitness;
 
+typedef libzcash::IncrementalMerkleBatch<SAPLING_INCREMENTAL_MERKLE_TREE_DEPTH, libzcash::PedersenHash> SaplingMerkleBatch;
+typedef libzcash::IncrementalMerkleBatch<INCREMENTAL_MERKLE_TREE_DEPTH_TESTING, libzcash::PedersenHash> SaplingTestingMerkleBatch;
+
 #endif /* INCREMENTALMERKLETREE_H_ */
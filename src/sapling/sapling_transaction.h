@@ -150,6 +150,14 @@ public:
 
     explicit SaplingTxData() : valueBalance(0), vShieldedSpend(), vShieldedOutput() { }
     explicit SaplingTxData(const SaplingTxData& from) : valueBalance(from.valueBalance), vShieldedSpend(from.vShieldedSpend), vShieldedOutput(from.vShieldedOutput), bindingSig(from.bindingSig) {}
+    SaplingTxData(SaplingTxData&& from) = default;
+    SaplingTxData& operator=(const SaplingTxData& from) = default;
+    SaplingTxData& operator=(SaplingTxData&& from) = default;
+
+    bool IsEmpty() const
+    {
+        return valueBalance == 0 && vShieldedSpend.empty() && vShieldedOutput.empty() && !hasBindingSig();
+    }
 
     bool hasBindingSig() const
     {
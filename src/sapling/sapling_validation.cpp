@@ -116,7 +116,8 @@ bool ContextualCheckTransaction(
         const CChainParams& chainparams,
         const int nHeight,
         const bool isMined,
-        bool isInitBlockDownload)
+        bool isInitBlockDownload,
+        bool fCheckProofs)
 {
     const int DOS_LEVEL_BLOCK = 100;
     // DoS level set to 10 to be more forgiving.
@@ -158,7 +159,7 @@ bool ContextualCheckTransaction(
                     REJECT_INVALID, "bad-cs-has-shielded-data");
     }
 
-    if (hasShieldedData) {
+    if (hasShieldedData && fCheckProofs) {
         uint256 dataToBeSigned;
         // Empty output script.
         CScript scriptCode;
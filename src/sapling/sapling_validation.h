@@ -21,9 +21,10 @@ bool CheckTransactionWithoutProofVerification(const CTransaction& tx, CValidatio
 
 /** Check a transaction contextually against a set of consensus rules */
 // Note: if v5 upgrade wasn't enforced, this method returns true without performing any check.
+// fCheckProofs=false skips the verification of the proofs and signatures (assumed-valid blocks).
 bool ContextualCheckTransaction(const CTransaction &tx, CValidationState &state,
                                 const CChainParams &chainparams, int nHeight, bool isMined,
-                                bool sInitBlockDownload);
+                                bool sInitBlockDownload, bool fCheckProofs = true);
 
 }; // End SaplingValidation namespace
 
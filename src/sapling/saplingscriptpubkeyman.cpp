@@ -25,7 +25,8 @@ bool SaplingScriptPubKeyMan::IsSaplingSpent(const uint256& nullifier) const {
     for (TxNullifiers::const_iterator it = range.first; it != range.second; ++it) {
         const uint256& wtxid = it->second;
         std::map<uint256, CWalletTx>::const_iterator mit = wallet->mapWallet.find(wtxid);
-        if (mit != wallet->mapWallet.end() && mit->second.GetDepthInMainChain() >= 0) {
+        // as for the transparent outputs, an abandoned spend frees the note
+        if (mit != wallet->mapWallet.end() && mit->second.GetDepthInMainChain() >= 0 && !mit->second.isAbandoned()) {
             return true; // Spent
         }
     }
@@ -50,6 +51,7 @@ void SaplingScriptPubKeyMan::UpdateSaplingNullifierNoteMap(SaplingNoteData& nd,
     AssertLockHeld(wallet->cs_wallet);
     nd.nullifier = nullifier;
     if (nullifier) mapSaplingNullifiersToNotes[*nullifier] = op;
+    UpdateSpendableNote(op, nullifier);
 }
 
 /**
@@ -68,6 +70,7 @@ void SaplingScriptPubKeyMan::UpdateSaplingNullifierNoteMapWithTx(CWalletTx& wtx)
                 mapSaplingNullifiersToNotes.erase(item.second.nullifier.get());
             }
             nd.nullifier = boost::none;
+            UpdateSpendableNote(op, nd.nullifier);
         } else {
             const libzcash::SaplingIncomingViewingKey& ivk = *(nd.ivk);
             uint64_t position = nd.witnesses.front().position();
@@ -137,8 +140,8 @@ void CopyPreviousWitnesses(NoteDataMap& noteDataMap, int indexHeight, int64_t nW
     }
 }
 
-template<typename NoteDataMap>
-void AppendNoteCommitment(NoteDataMap& noteDataMap, int indexHeight, int64_t nWitnessCacheSize, const uint256& note_commitment)
+template<typename NoteDataMap, typename Batch>
+void AppendNoteCommitments(NoteDataMap& noteDataMap, int indexHeight, int64_t nWitnessCacheSize, Batch& batch)
 {
     for (auto& item : noteDataMap) {
         auto* nd = &(item.second);
@@ -148,7 +151,17 @@ void AppendNoteCommitment(NoteDataMap& noteDataMap, int indexHeight, int64_t nWi
             // Check the validity of the cache
             // See comment in CopyPreviousWitnesses about validity.
             assert(nWitnessCacheSize >= (int64_t) nd->witnesses.size());
-            nd->witnesses.front().append(note_commitment);
+            // Appends the commitments that follow the witnessed note
+            try {
+                nd->witnesses.front().append(batch);
+            } catch (const std::runtime_error& e) {
+                // The cached witness doesn't end where the block's commitments
+                // start: drop the cache of this note, it gets rebuilt on rescan.
+                LogPrintf("Inconsistent witness cache state found for %s: %s, clearing it\n",
+                          item.first.ToString(), e.what());
+                nd->witnesses.clear();
+                nd->witnessHeight = -1;
+            }
         }
     }
 }
@@ -217,6 +230,8 @@ void SaplingScriptPubKeyMan::IncrementNoteWitnesses(const CBlockIndex* pindex,
         nWitnessCacheNeedsUpdate = true;
     }
 
+    const uint64_t nTreeSize = saplingTree.size();
+    std::vector<libzcash::PedersenHash> vCommitments;
     for (const auto& tx : pblock->vtx) {
         if (!tx->IsShieldedTx()) continue;
 
@@ -227,11 +242,7 @@ void SaplingScriptPubKeyMan::IncrementNoteWitnesses(const CBlockIndex* pindex,
         for (uint32_t i = 0; i < tx->sapData->vShieldedOutput.size(); i++) {
             const uint256& note_commitment = tx->sapData->vShieldedOutput[i].cmu;
             saplingTree.append(note_commitment);
-
-            // Increment existing witnesses
-            for (std::pair<const uint256, CWalletTx>& wtxItem : wallet->mapWallet) {
-                ::AppendNoteCommitment(wtxItem.second.mapSaplingNoteData, chainHeight, nWitnessCacheSize, note_commitment);
-            }
+            vCommitments.emplace_back(note_commitment);
 
             // If this is our note, witness it
             if (txIsOurs) {
@@ -242,6 +253,15 @@ void SaplingScriptPubKeyMan::IncrementNoteWitnesses(const CBlockIndex* pindex,
 
     }
 
+    // Increment the existing (and the new) witnesses with the block's commitments,
+    // sharing the subtree roots between them
+    if (!vCommitments.empty()) {
+        SaplingMerkleBatch batch(nTreeSize, std::move(vCommitments));
+        for (std::pair<const uint256, CWalletTx>& wtxItem : wallet->mapWallet) {
+            ::AppendNoteCommitments(wtxItem.second.mapSaplingNoteData, chainHeight, nWitnessCacheSize, batch);
+        }
+    }
+
     // Update witness heights
     for (std::pair<const uint256, CWalletTx>& wtxItem : wallet->mapWallet) {
         ::UpdateWitnessHeights(wtxItem.second.mapSaplingNoteData, chainHeight, nWitnessCacheSize);
@@ -394,29 +414,20 @@ std::vector<libzcash::SaplingPaymentAddress> SaplingScriptPubKeyMan::FindMySapli
 void SaplingScriptPubKeyMan::GetNotes(const std::vector<SaplingOutPoint>& saplingOutpoints,
                                       std::vector<SaplingNoteEntry>& saplingEntriesRet) const
 {
+    LOCK(wallet->cs_wallet);
+    if (!fNotesIndexBuilt) BuildNotesIndex();
+
     for (const auto& outpoint : saplingOutpoints) {
         const auto* wtx = wallet->GetWalletTx(outpoint.hash);
         if (!wtx) throw std::runtime_error("No transaction available for hash " + outpoint.hash.GetHex());
-        const int depth = WITH_LOCK(wallet->cs_wallet, return wtx->GetDepthInMainChain(); );
-        const auto& it = wtx->mapSaplingNoteData.find(outpoint);
-        if (it != wtx->mapSaplingNoteData.end()) {
-            const SaplingOutPoint& op = it->first;
-            const SaplingNoteData& nd = it->second;
+        const int depth = wtx->GetDepthInMainChain();
 
-            // skip sent notes
-            if (!nd.IsMyNote()) continue;
+        // skip sent notes
+        const auto& it = mapDecryptedNotes.find(outpoint);
+        if (it == mapDecryptedNotes.end()) continue;
 
-            // recover plaintext and address
-            auto optNotePtAndAddress = wtx->DecryptSaplingNote(op);
-            assert(static_cast<bool>(optNotePtAndAddress));
-
-            const libzcash::SaplingIncomingViewingKey& ivk = *(nd.ivk);
-            const libzcash::SaplingNotePlaintext& notePt = optNotePtAndAddress->first;
-            const libzcash::SaplingPaymentAddress& pa = optNotePtAndAddress->second;
-            auto note = notePt.note(ivk).get();
-
-            saplingEntriesRet.emplace_back(op, pa, note, notePt.memo(), depth);
-        }
+        const SaplingNoteEntry& entry = it->second;
+        saplingEntriesRet.emplace_back(entry.op, entry.address, entry.note, entry.memo, depth);
     }
 }
 
@@ -455,29 +466,68 @@ void SaplingScriptPubKeyMan::GetFilteredNotes(
         bool ignoreLocked) const
 {
     LOCK(wallet->cs_wallet);
+    if (!fNotesIndexBuilt) BuildNotesIndex();
+
+    // Only look at the unspent notes (unless asked otherwise), of the filtered payment addresses (if any)
+    const auto& mapByAddress = ignoreSpent ? mapUnspentNotesByAddress : mapNotesByAddress;
+    std::vector<const SaplingNoteEntry*> vCandidates;
+    const auto addCandidates = [&](const std::set<SaplingOutPoint>& ops) {
+        for (const SaplingOutPoint& op : ops) {
+            vCandidates.emplace_back(&mapDecryptedNotes.at(op));
+        }
+    };
+    if (filterAddresses.empty()) {
+        for (const auto& it : mapByAddress) {
+            addCandidates(it.second);
+        }
+    } else {
+        for (const libzcash::PaymentAddress& address : filterAddresses) {
+            const auto* pa = boost::get<libzcash::SaplingPaymentAddress>(&address);
+            if (!pa) continue;
+            auto it = mapByAddress.find(*pa);
+            if (it != mapByAddress.end()) addCandidates(it->second);
+        }
+    }
 
-    for (auto& p : wallet->mapWallet) {
-        const CWalletTx& wtx = p.second;
+    const int nNextHeight = wallet->GetLastBlockHeight() + 1;
+    const int64_t nAdjustedTime = GetAdjustedTime();
+    for (const SaplingNoteEntry* entry : vCandidates) {
+        const SaplingOutPoint& op = entry->op;
+        const CWalletTx& wtx = wallet->mapWallet.at(op.hash);
 
-        // Filter coinbase/coinstakes transactions that don't have Sapling outputs
-        if ((wtx.IsCoinBase() || wtx.IsCoinStake()) && wtx.mapSaplingNoteData.empty()) {
+        // Filter the transactions before checking the notes
+        const int depth = wtx.GetDepthInMainChain();
+        if (!IsFinalTx(wtx.tx, nNextHeight, nAdjustedTime) ||
+            depth < minDepth || depth > maxDepth) {
             continue;
         }
 
-        // Filter the transactions before checking for notes
-        const int depth = wtx.GetDepthInMainChain();
-        if (!IsFinalTx(wtx.tx, wallet->GetLastBlockHeight() + 1, GetAdjustedTime()) ||
-            depth < minDepth || depth > maxDepth) {
+        // skip notes which cannot be spent
+        if (requireSpendingKey && !HaveSpendingKeyForPaymentAddress(entry->address)) {
             continue;
         }
 
-        for (const auto& it : wtx.mapSaplingNoteData) {
-            const SaplingOutPoint& op = it.first;
-            const SaplingNoteData& nd = it.second;
+        // skip locked notes. todo: Implement locked notes..
+        //if (ignoreLocked && IsLockedNote(op)) {
+        //    continue;
+        //}
 
-            // skip sent notes
-            if (!nd.IsMyNote()) continue;
+        saplingEntries.emplace_back(op, entry->address, entry->note, entry->memo, depth);
+    }
+}
+
+void SaplingScriptPubKeyMan::AddToNotesIndex(const CWalletTx& wtx) const
+{
+    AssertLockHeld(wallet->cs_wallet);
+    for (const auto& it : wtx.mapSaplingNoteData) {
+        const SaplingOutPoint& op = it.first;
+        const SaplingNoteData& nd = it.second;
 
+        // skip sent notes
+        if (!nd.IsMyNote()) continue;
+
+        // decrypt the notes not yet indexed
+        if (!mapDecryptedNotes.count(op)) {
             // recover plaintext and address
             auto optNotePtAndAddress = wtx.DecryptSaplingNote(op);
             assert(static_cast<bool>(optNotePtAndAddress));
@@ -487,28 +537,83 @@ void SaplingScriptPubKeyMan::GetFilteredNotes(
             const libzcash::SaplingPaymentAddress& pa = optNotePtAndAddress->second;
             auto note = notePt.note(ivk).get();
 
-            // skip notes which belong to a different payment address in the wallet
-            if (!(filterAddresses.empty() || filterAddresses.count(pa))) {
-                continue;
-            }
+            mapDecryptedNotes.emplace(op, SaplingNoteEntry(op, pa, note, notePt.memo(), 0));
+            mapNotesByAddress[pa].insert(op);
+        }
+        // the nullifier may have been updated too
+        UpdateSpendableNote(op, nd.nullifier);
+    }
+}
 
-            if (ignoreSpent && nd.nullifier && IsSaplingSpent(*nd.nullifier)) {
-                continue;
-            }
+void SaplingScriptPubKeyMan::UpdateSpendableNote(const SaplingOutPoint& op, const Optional<uint256>& nullifier) const
+{
+    AssertLockHeld(wallet->cs_wallet);
+    const auto& it = mapDecryptedNotes.find(op);
+    if (it == mapDecryptedNotes.end()) return;
 
-            // skip notes which cannot be spent
-            if (requireSpendingKey && !HaveSpendingKeyForPaymentAddress(pa)) {
-                continue;
-            }
+    const libzcash::SaplingPaymentAddress& pa = it->second.address;
+    if (!nullifier || !IsSaplingSpent(*nullifier)) {
+        mapUnspentNotesByAddress[pa].insert(op);
+        return;
+    }
+    auto addrIt = mapUnspentNotesByAddress.find(pa);
+    if (addrIt != mapUnspentNotesByAddress.end()) {
+        addrIt->second.erase(op);
+        if (addrIt->second.empty()) mapUnspentNotesByAddress.erase(addrIt);
+    }
+}
 
-            // skip locked notes. todo: Implement locked notes..
-            //if (ignoreLocked && IsLockedNote(op)) {
-            //    continue;
-            //}
+void SaplingScriptPubKeyMan::UpdateSpentNotes(const CTransaction& tx)
+{
+    AssertLockHeld(wallet->cs_wallet);
+    if (!fNotesIndexBuilt || !tx.IsShieldedTx()) return;
+    for (const SpendDescription& spend : tx.sapData->vShieldedSpend) {
+        const auto& it = mapSaplingNullifiersToNotes.find(spend.nullifier);
+        if (it != mapSaplingNullifiersToNotes.end()) {
+            UpdateSpendableNote(it->second, spend.nullifier);
+        }
+    }
+}
+
+void SaplingScriptPubKeyMan::BuildNotesIndex() const
+{
+    AssertLockHeld(wallet->cs_wallet);
+    for (const auto& it : wallet->mapWallet) {
+        AddToNotesIndex(it.second);
+    }
+    fNotesIndexBuilt = true;
+}
 
-            saplingEntries.emplace_back(op, pa, note, notePt.memo(), depth);
+void SaplingScriptPubKeyMan::UpdateNotesIndex(const CWalletTx& wtx, bool fErased)
+{
+    AssertLockHeld(wallet->cs_wallet);
+    // Nothing to do until the notes are listed the first time
+    if (!fNotesIndexBuilt) return;
+
+    // Remove the notes of the tx which are no longer ours
+    const uint256& txid = wtx.GetHash();
+    auto it = mapDecryptedNotes.lower_bound(SaplingOutPoint(txid, 0));
+    while (it != mapDecryptedNotes.end() && it->first.hash == txid) {
+        const auto& ndIt = wtx.mapSaplingNoteData.find(it->first);
+        if (fErased || ndIt == wtx.mapSaplingNoteData.end() || !ndIt->second.IsMyNote()) {
+            for (auto* mapByAddress : {&mapNotesByAddress, &mapUnspentNotesByAddress}) {
+                auto addrIt = mapByAddress->find(it->second.address);
+                if (addrIt != mapByAddress->end()) {
+                    addrIt->second.erase(it->first);
+                    if (addrIt->second.empty()) mapByAddress->erase(addrIt);
+                }
+            }
+            it = mapDecryptedNotes.erase(it);
+        } else {
+            it++;
         }
     }
+
+    if (!fErased) {
+        AddToNotesIndex(wtx);
+        // The confirmation status of the tx may have changed: so may have the notes it spends
+        UpdateSpentNotes(*wtx.tx);
+    }
 }
 
 /* Return list of available notes grouped by sapling address. */
@@ -780,6 +885,15 @@ bool SaplingScriptPubKeyMan::IsNoteSaplingChange(const std::set<std::pair<libzca
     return false;
 }
 
+const SaplingWitness* SaplingScriptPubKeyMan::GetNoteWitness(const SaplingOutPoint& op) const
+{
+    const CWalletTx* wtx = wallet->GetWalletTx(op.hash);
+    if (!wtx) return nullptr;
+    const auto& it = wtx->mapSaplingNoteData.find(op);
+    if (it == wtx->mapSaplingNoteData.end() || it->second.witnesses.empty()) return nullptr;
+    return &it->second.witnesses.front();
+}
+
 void SaplingScriptPubKeyMan::GetSaplingNoteWitnesses(const std::vector<SaplingOutPoint>& notes,
                                       std::vector<Optional<SaplingWitness>>& witnesses,
                                       uint256& final_anchor) const
@@ -788,11 +902,10 @@ void SaplingScriptPubKeyMan::GetSaplingNoteWitnesses(const std::vector<SaplingOu
     witnesses.resize(notes.size());
     Optional<uint256> rt;
     int i = 0;
-    for (SaplingOutPoint note : notes) {
-        if (wallet->mapWallet.count(note.hash) &&
-            wallet->mapWallet.at(note.hash).mapSaplingNoteData.count(note) &&
-            wallet->mapWallet.at(note.hash).mapSaplingNoteData[note].witnesses.size() > 0) {
-            witnesses[i] = wallet->mapWallet.at(note.hash).mapSaplingNoteData[note].witnesses.front();
+    for (const SaplingOutPoint& note : notes) {
+        const SaplingWitness* witness = GetNoteWitness(note);
+        if (witness) {
+            witnesses[i] = *witness;
             if (!rt) {
                 rt = witnesses[i]->root();
             } else {
@@ -870,6 +983,11 @@ Optional<libzcash::SaplingExtendedFullViewingKey> SaplingScriptPubKeyMan::GetVie
 //! TODO: Should be Sapling address format, SaplingPaymentAddress
 // Generate a new Sapling spending key and return its public payment address
 libzcash::SaplingPaymentAddress SaplingScriptPubKeyMan::GenerateNewSaplingZKey()
+{
+    return GenerateNewSaplingZKeys(1).front();
+}
+
+std::vector<libzcash::SaplingPaymentAddress> SaplingScriptPubKeyMan::GenerateNewSaplingZKeys(size_t count)
 {
     LOCK(wallet->cs_wallet); // mapSaplingZKeyMetadata
 
@@ -887,32 +1005,95 @@ libzcash::SaplingPaymentAddress SaplingScriptPubKeyMan::GenerateNewSaplingZKey()
     // Derive m/32'/coin_type'
     auto m_32h_cth = m_32h.Derive(119 | ZIP32_HARDENED_KEY_LIMIT);
 
-    // Derive account key at next index, skip keys already known to the wallet
-    libzcash::SaplingExtendedSpendingKey xsk;
-    do {
-        xsk = m_32h_cth.Derive(hdChain.nExternalChainCounter | ZIP32_HARDENED_KEY_LIMIT);
-        hdChain.nExternalChainCounter++; // Increment childkey index
-    } while (wallet->HaveSaplingSpendingKey(xsk.ToXFVK()));
+    std::vector<libzcash::SaplingPaymentAddress> vAddresses;
+    vAddresses.reserve(count);
+    CWalletDB batch(wallet->GetDBHandle());
+    while (vAddresses.size() < count) {
+        // Derive the account keys at the next indexes, and their viewing keys and addresses, in parallel
+        const size_t nChunk = std::min(count - vAddresses.size(), (size_t) MAX_KEYS_PER_DB_TXN);
+        const uint32_t nFirstIndex = hdChain.nExternalChainCounter;
+        std::vector<libzcash::SaplingExtendedSpendingKey> vKeys(nChunk);
+        std::vector<libzcash::SaplingExtendedFullViewingKey> vFvks(nChunk);
+        std::vector<libzcash::SaplingPaymentAddress> vChunkAddresses(nChunk);
+        ParallelDeriveKeys(nChunk, [&](size_t i) {
+            vKeys[i] = m_32h_cth.Derive((nFirstIndex + i) | ZIP32_HARDENED_KEY_LIMIT);
+            vFvks[i] = vKeys[i].ToXFVK();
+            vChunkAddresses[i] = vKeys[i].DefaultAddress();
+        });
+
+        // Write the keys and the chain counter in one DB transaction (the key writes go through
+        // the wallet encryption batch, if the wallet is being encrypted). The in-memory keystore
+        // and chain are updated only once the transaction committed.
+        CWalletDB& keyBatch = wallet->pwalletdbEncryption ? *wallet->pwalletdbEncryption : batch;
+        const bool fTxn = !wallet->pwalletdbEncryption && batch.TxnBegin();
+        const bool fCrypted = wallet->IsCrypted();
+        if (!IsEnabled() || (fCrypted && wallet->IsLocked())) {
+            if (fTxn) batch.TxnAbort();
+            throw std::runtime_error(std::string(__func__) + ": AddSaplingZKey failed");
+        }
 
-    // Update the chain model in the database
-    if (!CWalletDB(wallet->GetDBHandle()).WriteHDChain(hdChain))
-        throw std::runtime_error(std::string(__func__) + ": Writing HD chain model failed");
+        CHDChain newChain = hdChain;
+        std::vector<size_t> vNew;
+        std::vector<CKeyMetadata> vMetadata;
+        std::vector<std::vector<unsigned char>> vCryptedSecrets;
+        const int64_t nCreationTime = GetTime();
+        for (size_t i = 0; i < nChunk; i++) {
+            newChain.nExternalChainCounter++; // Increment childkey index
+            // skip keys already known to the wallet
+            if (wallet->HaveSaplingSpendingKey(vFvks[i])) continue;
+
+            // Create new metadata
+            auto ivk = vFvks[i].fvk.in_viewing_key();
+            CKeyMetadata metadata(nCreationTime);
+            metadata.key_origin.path.push_back(32 | BIP32_HARDENED_KEY_LIMIT);
+            metadata.key_origin.path.push_back(119 | BIP32_HARDENED_KEY_LIMIT);
+            metadata.key_origin.path.push_back(newChain.nExternalChainCounter | BIP32_HARDENED_KEY_LIMIT);
+            metadata.hd_seed_id = newChain.GetID();
+
+            bool fWritten;
+            std::vector<unsigned char> vchCryptedSecret;
+            if (fCrypted) {
+                CSecureDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+                ss << vKeys[i];
+                CKeyingMaterial vchSecret(ss.begin(), ss.end());
+                fWritten = EncryptSecret(wallet->GetEncryptionKey(), vchSecret, vFvks[i].fvk.GetFingerprint(), vchCryptedSecret) &&
+                           keyBatch.WriteCryptedSaplingZKey(vFvks[i], vchCryptedSecret, metadata);
+            } else {
+                fWritten = keyBatch.WriteSaplingZKey(ivk, vKeys[i], metadata);
+            }
+            if (!fWritten) {
+                if (fTxn) batch.TxnAbort();
+                throw std::runtime_error(std::string(__func__) + ": AddSaplingZKey failed");
+            }
+            vNew.emplace_back(i);
+            vMetadata.emplace_back(metadata);
+            vCryptedSecrets.emplace_back(std::move(vchCryptedSecret));
+        }
 
-    // Create new metadata
-    int64_t nCreationTime = GetTime();
-    auto ivk = xsk.expsk.full_viewing_key().in_viewing_key();
-    CKeyMetadata metadata(nCreationTime);
-    metadata.key_origin.path.push_back(32 | BIP32_HARDENED_KEY_LIMIT);
-    metadata.key_origin.path.push_back(119 | BIP32_HARDENED_KEY_LIMIT);
-    metadata.key_origin.path.push_back(hdChain.nExternalChainCounter | BIP32_HARDENED_KEY_LIMIT);
-    metadata.hd_seed_id = hdChain.GetID();
-    mapSaplingZKeyMetadata[ivk] = metadata;
+        // Update the chain model in the database
+        const bool fWritten = batch.WriteHDChain(newChain);
+        if (fTxn) {
+            if (!fWritten || !batch.TxnCommit()) {
+                if (!fWritten) batch.TxnAbort();
+                throw std::runtime_error(std::string(__func__) + ": Writing Sapling keys failed");
+            }
+        } else if (!fWritten) {
+            throw std::runtime_error(std::string(__func__) + ": Writing HD chain model failed");
+        }
 
-    if (!AddSaplingZKey(xsk)) {
-        throw std::runtime_error(std::string(__func__) + ": AddSaplingZKey failed");
+        // Committed, add the keys to the wallet
+        hdChain = newChain;
+        for (size_t n = 0; n < vNew.size(); n++) {
+            const size_t i = vNew[n];
+            mapSaplingZKeyMetadata[vFvks[i].fvk.in_viewing_key()] = vMetadata[n];
+            if (!(fCrypted ? LoadCryptedSaplingZKey(vFvks[i], vCryptedSecrets[n]) : LoadSaplingZKey(vKeys[i]))) {
+                throw std::runtime_error(std::string(__func__) + ": AddSaplingZKey failed");
+            }
+            // default sapling payment address
+            vAddresses.emplace_back(vChunkAddresses[i]);
+        }
     }
-    // return default sapling payment address.
-    return xsk.DefaultAddress();
+    return vAddresses;
 }
 
 int64_t SaplingScriptPubKeyMan::GetKeyCreationTime(const libzcash::SaplingIncomingViewingKey& ivk)
@@ -1001,6 +1182,9 @@ bool SaplingScriptPubKeyMan::AddSaplingZKey(
 
     if (!wallet->IsCrypted()) {
         auto ivk = sk.expsk.full_viewing_key().in_viewing_key();
+        if (wallet->pwalletdbEncryption) {
+            return wallet->pwalletdbEncryption->WriteSaplingZKey(ivk, sk, mapSaplingZKeyMetadata[ivk]);
+        }
         return CWalletDB(wallet->GetDBHandle()).WriteSaplingZKey(ivk, sk, mapSaplingZKeyMetadata[ivk]);
     }
 
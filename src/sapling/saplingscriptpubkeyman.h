@@ -235,6 +235,8 @@ public:
 
     //! Generates new Sapling key
     libzcash::SaplingPaymentAddress GenerateNewSaplingZKey();
+    //! Generates count new Sapling keys (derived in parallel, written in batched DB transactions)
+    std::vector<libzcash::SaplingPaymentAddress> GenerateNewSaplingZKeys(size_t count);
     //! Adds Sapling spending key to the store, and saves it to disk
     bool AddSaplingZKey(const libzcash::SaplingExtendedSpendingKey &key);
     bool AddSaplingIncomingViewingKey(
@@ -300,6 +302,11 @@ public:
     /* Return list of available notes grouped by sapling address. */
     std::map<libzcash::SaplingPaymentAddress, std::vector<SaplingNoteEntry>> ListNotes() const;
 
+    //! Keep the index of the decrypted notes in sync with the added, updated or erased transaction
+    void UpdateNotesIndex(const CWalletTx& wtx, bool fErased = false);
+    //! Move the notes spent by the tx in or out of the unspent notes index, after the tx changed confirmation status
+    void UpdateSpentNotes(const CTransaction& tx);
+
     //! Return the address from where the shielded spend is taking the funds from (if possible)
     Optional<libzcash::SaplingPaymentAddress> GetAddressFromInputIfPossible(const CWalletTx* wtx, int index) const;
     Optional<libzcash::SaplingPaymentAddress> GetAddressFromInputIfPossible(const uint256& txHash, int index) const;
@@ -423,6 +430,28 @@ private:
      */
     typedef std::multimap<uint256, uint256> TxNullifiers;
     TxNullifiers mapTxSaplingNullifiers;
+
+    /**
+     * Index of the notes of this wallet, decrypted only once, by outpoint and by
+     * address (the confirmations of the entries are not set: they are computed on use).
+     * The notes which are not spent (see IsSaplingSpent) are indexed by address
+     * once more, so that the note selection doesn't walk the spent ones.
+     * Built the first time that the notes are listed, and then kept up to date by
+     * UpdateNotesIndex, UpdateSpentNotes and the nullifier updates.
+     * Guarded by wallet->cs_wallet: the annotation can't be written here, as CWallet
+     * is an incomplete type (see CWalletTx::GetDepthInMainChain), the accessors
+     * assert that the lock is held instead.
+     */
+    mutable std::map<SaplingOutPoint, SaplingNoteEntry> mapDecryptedNotes;
+    mutable std::map<libzcash::SaplingPaymentAddress, std::set<SaplingOutPoint>> mapNotesByAddress;
+    mutable std::map<libzcash::SaplingPaymentAddress, std::set<SaplingOutPoint>> mapUnspentNotesByAddress;
+    mutable bool fNotesIndexBuilt{false};
+    void BuildNotesIndex() const;
+    //! Index the note as unspent or not, depending on its nullifier
+    void UpdateSpendableNote(const SaplingOutPoint& op, const Optional<uint256>& nullifier) const;
+    //! Latest cached witness of the note (nullptr if none)
+    const SaplingWitness* GetNoteWitness(const SaplingOutPoint& op) const;
+    void AddToNotesIndex(const CWalletTx& wtx) const;
 };
 
 #endif //PIVX_SAPLINGSCRIPTPUBKEYMAN_H
@@ -596,6 +596,7 @@ template<typename T> unsigned int GetSerializeSize(const Optional<T> &item);
 template<typename T> unsigned int GetSerializeSizeNetwork(const Optional<T> &item);
 template<typename Stream, typename T> void Serialize(Stream& os, const Optional<T>& item);
 template<typename Stream, typename T> void Unserialize(Stream& is, Optional<T>& item);
+template<typename Stream, typename T> void Serialize(Stream& os, const SharedOptional<T>& item);
 
 /**
  * array
@@ -659,7 +660,21 @@ void Unserialize(Stream& is, Optional<T>& item)
     } else {
         T object;
         Unserialize(is, object);
-        item = object;
+        item = std::move(object);
+    }
+}
+
+template<typename Stream, typename T>
+void Serialize(Stream& os, const SharedOptional<T>& item)
+{
+    // Same format as Optional
+    if (item) {
+        unsigned char discriminant = 0x01;
+        Serialize(os, discriminant);
+        Serialize(os, *item);
+    } else {
+        unsigned char discriminant = 0x00;
+        Serialize(os, discriminant);
     }
 }
 
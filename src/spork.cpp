@@ -90,7 +90,7 @@ void CSporkManager::LoadSporksFromDB()
     }
 }
 
-void CSporkManager::ProcessSpork(CNode* pfrom, std::string& strCommand, CDataStream& vRecv)
+void CSporkManager::ProcessSpork(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv)
 {
     if (fLiteMode) return; // disable all masternode related functionality
 
@@ -106,7 +106,7 @@ void CSporkManager::ProcessSpork(CNode* pfrom, std::string& strCommand, CDataStr
     }
 }
 
-int CSporkManager::ProcessSporkMsg(CDataStream& vRecv)
+int CSporkManager::ProcessSporkMsg(CPooledDataStream& vRecv)
 {
     CSporkMessage spork;
     vRecv >> spork;
@@ -181,7 +181,7 @@ int CSporkManager::ProcessSporkMsg(CSporkMessage& spork)
     return 0;
 }
 
-void CSporkManager::ProcessGetSporks(CNode* pfrom, std::string& strCommand, CDataStream& vRecv)
+void CSporkManager::ProcessGetSporks(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv)
 {
     LOCK(cs);
 
@@ -106,7 +106,7 @@ public:
     void Clear();
     void LoadSporksFromDB();
 
-    void ProcessSpork(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+    void ProcessSpork(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv);
     int64_t GetSporkValue(SporkId nSporkID);
     // Create/Sign/Relay the spork message, and update the maps
     bool UpdateSpork(SporkId nSporkID, int64_t nValue);
@@ -121,10 +121,10 @@ public:
     std::string ToString() const;
 
     // Process SPORK message, returning the banning score (or 0 if no banning is needed)
-    int ProcessSporkMsg(CDataStream& vRecv);
+    int ProcessSporkMsg(CPooledDataStream& vRecv);
     int ProcessSporkMsg(CSporkMessage& spork);
     // Process GETSPORKS message
-    void ProcessGetSporks(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+    void ProcessGetSporks(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv);
 };
 
 #endif
@@ -8,6 +8,7 @@
 #define BITCOIN_STREAMS_H
 
 #include "serialize.h"
+#include "support/allocators/pooled.h"
 #include "support/allocators/zeroafterfree.h"
 
 #include <algorithm>
@@ -390,6 +391,37 @@ public:
 
 };
 
+/**
+ * Stream for non-secret data (network messages, database records, blocks): its buffer
+ * is recycled through the BufferPool and is not cleared when released.
+ * Use CDataStream for anything that may contain key material.
+ */
+class CPooledDataStream : public CBaseDataStream<CPooledSerializeData>
+{
+public:
+    explicit CPooledDataStream(int nTypeIn, int nVersionIn) : CBaseDataStream(nTypeIn, nVersionIn) { }
+
+    CPooledDataStream(const_iterator pbegin, const_iterator pend, int nTypeIn, int nVersionIn) :
+            CBaseDataStream(pbegin, pend, nTypeIn, nVersionIn) { }
+
+    CPooledDataStream(const char* pbegin, const char* pend, int nTypeIn, int nVersionIn) :
+            CBaseDataStream(pbegin, pend, nTypeIn, nVersionIn) { }
+
+    CPooledDataStream(const vector_type& vchIn, int nTypeIn, int nVersionIn) :
+            CBaseDataStream(vchIn, nTypeIn, nVersionIn) { }
+
+    CPooledDataStream(const std::vector<char>& vchIn, int nTypeIn, int nVersionIn) :
+            CBaseDataStream(vchIn, nTypeIn, nVersionIn) { }
+
+    CPooledDataStream(const std::vector<unsigned char>& vchIn, int nTypeIn, int nVersionIn) :
+            CBaseDataStream(vchIn, nTypeIn, nVersionIn) { }
+
+    template <typename... Args>
+    CPooledDataStream(int nTypeIn, int nVersionIn, Args&&... args) :
+            CBaseDataStream(nTypeIn, nVersionIn, args...) { }
+
+};
+
 
 
 
@@ -569,6 +601,9 @@ public:
         fclose();
     }
 
+    int GetVersion() const { return nVersion; }
+    int GetType() const { return nType; }
+
     void fclose()
     {
         if (src) {
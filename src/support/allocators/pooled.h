@@ -0,0 +1,55 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PIVX_ALLOCATORS_POOLED_H
+#define PIVX_ALLOCATORS_POOLED_H
+
+#include "support/bufferpool.h"
+
+#include <memory>
+#include <vector>
+
+//
+// Allocator recycling its (large) buffers through the BufferPool.
+// Contents are not cleared on deallocation: for non-secret data only.
+//
+template <typename T>
+struct pooled_allocator : public std::allocator<T> {
+    typedef std::allocator<T> base;
+    typedef typename base::size_type size_type;
+    typedef typename base::difference_type difference_type;
+    typedef typename base::pointer pointer;
+    typedef typename base::const_pointer const_pointer;
+    typedef typename base::reference reference;
+    typedef typename base::const_reference const_reference;
+    typedef typename base::value_type value_type;
+    pooled_allocator() noexcept {}
+    pooled_allocator(const pooled_allocator& a) noexcept : base(a) {}
+    template <typename U>
+    pooled_allocator(const pooled_allocator<U>& a) noexcept : base(a)
+    {
+    }
+    ~pooled_allocator() noexcept {}
+    template <typename _Other>
+    struct rebind {
+        typedef pooled_allocator<_Other> other;
+    };
+
+    T* allocate(std::size_t n, const void* hint = 0)
+    {
+        return static_cast<T*>(BufferPool::Instance().Allocate(sizeof(T) * n));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        if (p != nullptr) {
+            BufferPool::Instance().Deallocate(p, sizeof(T) * n);
+        }
+    }
+};
+
+// Byte-vector for non-secret data, with recycled buffers and no clearing before deletion.
+typedef std::vector<char, pooled_allocator<char> > CPooledSerializeData;
+
+#endif // PIVX_ALLOCATORS_POOLED_H
@@ -0,0 +1,112 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "support/bufferpool.h"
+
+#include <algorithm>
+#include <new>
+
+// Size class of the smallest pooled buffers (2^12 = MIN_POOLED_SIZE)
+static const int MIN_SIZE_CLASS = 12;
+
+BufferPool::BufferPool()
+{
+    vFreeLists.resize(SizeClass(MAX_POOLED_SIZE) + 1);
+    vMinFree.resize(vFreeLists.size(), 0);
+}
+
+BufferPool& BufferPool::Instance()
+{
+    static BufferPool* instance = new BufferPool();
+    return *instance;
+}
+
+int BufferPool::SizeClass(size_t size)
+{
+    int n = 0;
+    while (((size_t)1 << (n + MIN_SIZE_CLASS)) < size) n++;
+    return n;
+}
+
+void* BufferPool::Allocate(size_t size)
+{
+    if (size < MIN_POOLED_SIZE || size > MAX_POOLED_SIZE) {
+        return ::operator new(size);
+    }
+    const int nClass = SizeClass(size);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<void*>& vFree = vFreeLists[nClass];
+        if (!vFree.empty()) {
+            void* p = vFree.back();
+            vFree.pop_back();
+            vMinFree[nClass] = std::min(vMinFree[nClass], vFree.size());
+            stats.nPooledBytes -= (size_t)1 << (nClass + MIN_SIZE_CLASS);
+            stats.nReused++;
+            return p;
+        }
+        stats.nAllocated++;
+    }
+    return ::operator new((size_t)1 << (nClass + MIN_SIZE_CLASS));
+}
+
+void BufferPool::Deallocate(void* p, size_t size)
+{
+    if (size < MIN_POOLED_SIZE || size > MAX_POOLED_SIZE) {
+        ::operator delete(p);
+        return;
+    }
+    const int nClass = SizeClass(size);
+    const size_t nClassSize = (size_t)1 << (nClass + MIN_SIZE_CLASS);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stats.nPooledBytes + nClassSize <= MAX_POOLED_BYTES) {
+            vFreeLists[nClass].push_back(p);
+            stats.nPooledBytes += nClassSize;
+            return;
+        }
+        stats.nReleased++;
+    }
+    ::operator delete(p);
+}
+
+BufferPool::Stats BufferPool::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void BufferPool::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::vector<void*>& vFree : vFreeLists) {
+        for (void* p : vFree) {
+            ::operator delete(p);
+        }
+        vFree.clear();
+    }
+    std::fill(vMinFree.begin(), vMinFree.end(), 0);
+    stats.nPooledBytes = 0;
+}
+
+void BufferPool::ReleaseIdle()
+{
+    std::vector<void*> vIdle;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t nClass = 0; nClass < vFreeLists.size(); nClass++) {
+            // The first vMinFree[nClass] buffers of the list were not used since the last call
+            std::vector<void*>& vFree = vFreeLists[nClass];
+            const size_t nIdle = vMinFree[nClass];
+            vIdle.insert(vIdle.end(), vFree.begin(), vFree.begin() + nIdle);
+            vFree.erase(vFree.begin(), vFree.begin() + nIdle);
+            stats.nPooledBytes -= nIdle << (nClass + MIN_SIZE_CLASS);
+            stats.nReleased += nIdle;
+            vMinFree[nClass] = vFree.size();
+        }
+    }
+    for (void* p : vIdle) {
+        ::operator delete(p);
+    }
+}
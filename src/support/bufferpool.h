@@ -0,0 +1,66 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PIVX_SUPPORT_BUFFERPOOL_H
+#define PIVX_SUPPORT_BUFFERPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+/**
+ * Pool of recycled heap buffers, for the large non-secret byte buffers that are
+ * allocated and released at a high rate (received network messages, database
+ * records, serialized blocks).
+ *
+ * Buffers between MIN_POOLED_SIZE and MAX_POOLED_SIZE are rounded up to a power of
+ * two; when released they are kept in the free list of their size class (up to
+ * MAX_POOLED_BYTES in total) and handed out again by the next allocation of that
+ * class. Smaller and larger buffers go straight to the system allocator: for small
+ * buffers (e.g. the database keys and values, see DBWRAPPER_PREALLOC_VALUE_SIZE)
+ * the pool lock would cost as much as the allocation it saves.
+ * Buffers that stay unused in the free lists are returned to the system allocator
+ * by ReleaseIdle.
+ *
+ * The contents of released buffers are NOT wiped: never use it for key material.
+ */
+class BufferPool
+{
+public:
+    static const size_t MIN_POOLED_SIZE = 4096;
+    static const size_t MAX_POOLED_SIZE = 32 << 20;
+    static const size_t MAX_POOLED_BYTES = 64 << 20;
+
+    struct Stats {
+        uint64_t nAllocated{0};     // pooled-size buffers obtained from the system allocator
+        uint64_t nReused{0};        // pooled-size buffers served from a free list
+        uint64_t nReleased{0};      // pooled-size buffers returned to the system allocator (pool full, or idle)
+        size_t nPooledBytes{0};     // bytes currently held in the free lists
+    };
+
+    /** The pool is never destroyed, so that buffers can be released during static destruction */
+    static BufferPool& Instance();
+
+    void* Allocate(size_t size);
+    void Deallocate(void* p, size_t size);
+
+    Stats GetStats() const;
+    /** Return all the pooled buffers to the system allocator */
+    void Clear();
+    /** Return to the system allocator the pooled buffers that were not handed out since the previous call */
+    void ReleaseIdle();
+
+private:
+    BufferPool();
+
+    mutable std::mutex mutex;
+    std::vector<std::vector<void*>> vFreeLists;   // indexed by size class
+    std::vector<size_t> vMinFree;                 // smallest size of each free list since the last ReleaseIdle
+    Stats stats;
+
+    static int SizeClass(size_t size);
+};
+
+#endif // PIVX_SUPPORT_BUFFERPOOL_H
@@ -11,6 +11,8 @@
 
 #include <stdio.h>
 
+#include <atomic>
+#include <chrono>
 #include <map>
 #include <memory>
 #include <set>
@@ -26,6 +28,44 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+#ifdef DEBUG_LOCKHOLDPROBE
+static std::atomic<void*> g_lock_hold_probe{nullptr};
+static std::atomic<int64_t> g_lock_hold_probe_time{0};
+// Only modified by the thread holding the probe target, so they need no protection
+static int g_lock_hold_probe_depth{0};
+static std::chrono::steady_clock::time_point g_lock_hold_probe_start;
+
+void SetLockHoldProbe(RecursiveMutex* cs)
+{
+    g_lock_hold_probe = (void*)cs;
+    g_lock_hold_probe_time = 0;
+}
+
+int64_t GetLockHoldProbeMicros()
+{
+    return g_lock_hold_probe_time;
+}
+
+void LockHoldProbeEnter(void* cs)
+{
+    if (g_lock_hold_probe.load(std::memory_order_relaxed) != cs) return;
+    if (g_lock_hold_probe_depth++ == 0) {
+        g_lock_hold_probe_start = std::chrono::steady_clock::now();
+    }
+}
+
+void LockHoldProbeLeave(void* cs)
+{
+    if (g_lock_hold_probe.load(std::memory_order_relaxed) != cs) return;
+    // the probe could have been set while the lock was already held
+    if (g_lock_hold_probe_depth == 0) return;
+    if (--g_lock_hold_probe_depth == 0) {
+        g_lock_hold_probe_time += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - g_lock_hold_probe_start).count();
+    }
+}
+#endif /* DEBUG_LOCKHOLDPROBE */
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
@@ -13,6 +13,7 @@
 #include <condition_variable>
 #include <thread>
 #include <mutex>
+#include <type_traits>
 
 
 /////////////////////////////////////////////////
@@ -115,6 +116,23 @@ typedef AnnotatedMixin<std::mutex> Mutex;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+#ifdef DEBUG_LOCKHOLDPROBE
+/**
+ * Lock hold-time probe, used for profiling (see bench/p2p_replay.cpp).
+ * While a mutex is set as the probe target, the time it is held (from the outermost
+ * LOCK to the matching release, by any thread) is accumulated.
+ * The target should be set while it is not held. Locks taken with
+ * ENTER_CRITICAL_SECTION are not accounted.
+ * Only a RecursiveMutex can be probed: it can't be waited on with a condition
+ * variable, which would release it without going through UniqueLock.
+ */
+void SetLockHoldProbe(RecursiveMutex* cs);
+/** Total hold time of the probe target, in microseconds, since it was set */
+int64_t GetLockHoldProbeMicros();
+void LockHoldProbeEnter(void* cs);
+void LockHoldProbeLeave(void* cs);
+#endif
+
 /** Wrapper around std::unique_lock style lock for Mutex. */
 template <typename Mutex, typename Base = typename Mutex::UniqueLock>
 class SCOPED_LOCKABLE UniqueLock  : public Base
@@ -130,6 +148,9 @@ private:
         Base::lock();
 #ifdef DEBUG_LOCKCONTENTION
         }
+#endif
+#ifdef DEBUG_LOCKHOLDPROBE
+        if (std::is_same<Mutex, RecursiveMutex>::value) LockHoldProbeEnter((void*)(Base::mutex()));
 #endif
     }
 
@@ -139,6 +160,10 @@ private:
         Base::try_lock();
         if (!Base::owns_lock())
             LeaveCritical();
+#ifdef DEBUG_LOCKHOLDPROBE
+        else if (std::is_same<Mutex, RecursiveMutex>::value)
+            LockHoldProbeEnter((void*)(Base::mutex()));
+#endif
         return Base::owns_lock();
     }
 
@@ -164,8 +189,12 @@ public:
 
     ~UniqueLock() UNLOCK_FUNCTION()
     {
-        if (Base::owns_lock())
+        if (Base::owns_lock()) {
+#ifdef DEBUG_LOCKHOLDPROBE
+            if (std::is_same<Mutex, RecursiveMutex>::value) LockHoldProbeLeave((void*)(Base::mutex()));
+#endif
             LeaveCritical();
+        }
     }
 
     operator bool()
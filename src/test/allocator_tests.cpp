@@ -4,6 +4,8 @@
 
 #include "util/system.h"
 
+#include "streams.h"
+#include "support/allocators/pooled.h"
 #include "support/allocators/zeroafterfree.h"
 #include "test/test_pivx.h"
 
@@ -221,4 +223,65 @@ BOOST_AUTO_TEST_CASE(lockedpool_tests_live)
     BOOST_CHECK(pool.stats().used == initial.used);
 }
 
+// Also uses the live BufferPool object, only checking relative changes of its stats.
+BOOST_AUTO_TEST_CASE(bufferpool_tests_live)
+{
+    BufferPool& pool = BufferPool::Instance();
+    pool.Clear();
+    BufferPool::Stats initial = pool.GetStats();
+    BOOST_CHECK_EQUAL(initial.nPooledBytes, 0);
+
+    // Small buffers bypass the pool
+    void* small = pool.Allocate(BufferPool::MIN_POOLED_SIZE - 1);
+    pool.Deallocate(small, BufferPool::MIN_POOLED_SIZE - 1);
+    BOOST_CHECK_EQUAL(pool.GetStats().nAllocated, initial.nAllocated);
+    BOOST_CHECK_EQUAL(pool.GetStats().nPooledBytes, 0);
+
+    // A released buffer is handed out again to an allocation of the same size class
+    void* a0 = pool.Allocate(5000);
+    memset(a0, 0xab, 8192);
+    pool.Deallocate(a0, 5000);
+    BOOST_CHECK_EQUAL(pool.GetStats().nPooledBytes, 8192);
+    void* a1 = pool.Allocate(8000);
+    BOOST_CHECK(a1 == a0);
+    BOOST_CHECK_EQUAL(pool.GetStats().nReused, initial.nReused + 1);
+    BOOST_CHECK_EQUAL(pool.GetStats().nAllocated, initial.nAllocated + 1);
+    // ...but not to another size class
+    void* a2 = pool.Allocate(9000);
+    BOOST_CHECK(a2 != a1);
+    pool.Deallocate(a1, 8000);
+    pool.Deallocate(a2, 9000);
+    BOOST_CHECK_EQUAL(pool.GetStats().nPooledBytes, 8192 + 16384);
+
+    // Streams using the pool
+    {
+        CPooledDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        std::vector<unsigned char> vch(100000, 0x42);
+        ss << vch;
+        std::vector<unsigned char> vchRead;
+        ss >> vchRead;
+        BOOST_CHECK(vch == vchRead);
+        BOOST_CHECK(ss.empty());
+    }
+    pool.Clear();
+    BOOST_CHECK_EQUAL(pool.GetStats().nPooledBytes, 0);
+
+    // Idle buffers are released: b0 is not handed out between the two ReleaseIdle calls, b1 is
+    void* b0 = pool.Allocate(5000);
+    void* b1 = pool.Allocate(5000);
+    pool.Deallocate(b0, 5000);
+    pool.Deallocate(b1, 5000);
+    pool.ReleaseIdle();
+    BOOST_CHECK_EQUAL(pool.GetStats().nPooledBytes, 2 * 8192);
+    void* b2 = pool.Allocate(5000);
+    BOOST_CHECK(b2 == b1);
+    pool.Deallocate(b2, 5000);
+    const uint64_t nReleased = pool.GetStats().nReleased;
+    pool.ReleaseIdle();
+    BOOST_CHECK_EQUAL(pool.GetStats().nPooledBytes, 8192);
+    BOOST_CHECK_EQUAL(pool.GetStats().nReleased, nReleased + 1);
+    pool.ReleaseIdle();
+    BOOST_CHECK_EQUAL(pool.GetStats().nPooledBytes, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
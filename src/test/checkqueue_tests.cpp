@@ -0,0 +1,191 @@
+// Copyright (c) 2012-2017 The Bitcoin Core developers
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "checkqueue.h"
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <boost/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(checkqueue_tests)
+
+static const unsigned int QUEUE_BATCH_SIZE = 128;
+static const int SCRIPT_CHECK_THREADS = 3;
+
+/** A check counting its runs in a shared array, failing if asked to */
+struct CountingCheck {
+    std::vector<std::atomic<int>>* pRuns{nullptr};
+    size_t nId{0};
+    bool fOk{true};
+
+    CountingCheck() {}
+    CountingCheck(std::vector<std::atomic<int>>& runs, size_t nIdIn, bool fOkIn = true) : pRuns(&runs), nId(nIdIn), fOk(fOkIn) {}
+
+    bool operator()()
+    {
+        (*pRuns)[nId]++;
+        return fOk;
+    }
+
+    void swap(CountingCheck& x)
+    {
+        std::swap(pRuns, x.pRuns);
+        std::swap(nId, x.nId);
+        std::swap(fOk, x.fOk);
+    }
+};
+
+typedef CCheckQueue<CountingCheck> CountingQueue;
+
+/** The queue with its worker threads, interrupted and joined on destruction */
+struct QueueSetup {
+    CountingQueue queue{QUEUE_BATCH_SIZE};
+    boost::thread_group threadGroup;
+
+    QueueSetup(int nThreads = SCRIPT_CHECK_THREADS)
+    {
+        for (int i = 0; i < nThreads; i++) {
+            threadGroup.create_thread([this]() { queue.Thread(); });
+        }
+    }
+
+    ~QueueSetup()
+    {
+        threadGroup.interrupt_all();
+        threadGroup.join_all();
+    }
+};
+
+/** Add nChecks checks in batches of (up to) nBatch, the check nFail (if any) failing, and wait for them */
+static bool RunChecks(CountingQueue& queue, std::vector<std::atomic<int>>& runs, size_t nChecks, size_t nBatch, size_t nFail = std::numeric_limits<size_t>::max())
+{
+    CCheckQueueControl<CountingCheck> control(&queue);
+    for (size_t nPos = 0; nPos < nChecks; nPos += nBatch) {
+        std::vector<CountingCheck> vChecks;
+        for (size_t i = nPos; i < std::min(nChecks, nPos + nBatch); i++) {
+            vChecks.emplace_back(runs, i, i != nFail);
+        }
+        control.Add(vChecks);
+    }
+    return control.Wait();
+}
+
+static void CheckRunOnce(const std::vector<std::atomic<int>>& runs)
+{
+    for (size_t i = 0; i < runs.size(); i++) {
+        if (runs[i] != 1) {
+            BOOST_ERROR("check " << i << " ran " << runs[i] << " times");
+            return;
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(checkqueue_all_checks_run_once)
+{
+    for (int nThreads : {0, 1, SCRIPT_CHECK_THREADS}) {
+        QueueSetup setup(nThreads);
+        for (size_t nChecks : {1, 10, 1000, 100000}) {
+            std::vector<std::atomic<int>> runs(nChecks);
+            BOOST_CHECK(RunChecks(setup.queue, runs, nChecks, nChecks));
+            CheckRunOnce(runs);
+            BOOST_CHECK(setup.queue.IsIdle());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(checkqueue_batches)
+{
+    QueueSetup setup;
+    // Many small batches, then a few large ones, through the same queue
+    for (size_t nBatch : {1, 3, 17, (int)QUEUE_BATCH_SIZE, 5000, 50000}) {
+        const size_t nChecks = 100000;
+        std::vector<std::atomic<int>> runs(nChecks);
+        BOOST_CHECK(RunChecks(setup.queue, runs, nChecks, nBatch));
+        CheckRunOnce(runs);
+        BOOST_CHECK(setup.queue.IsIdle());
+    }
+    // Many rounds, each a handful of checks
+    for (int nRound = 0; nRound < 2000; nRound++) {
+        std::vector<std::atomic<int>> runs(1 + nRound % 7);
+        BOOST_CHECK(RunChecks(setup.queue, runs, runs.size(), 2));
+        CheckRunOnce(runs);
+    }
+    BOOST_CHECK(setup.queue.IsIdle());
+}
+
+BOOST_AUTO_TEST_CASE(checkqueue_failure)
+{
+    QueueSetup setup;
+    for (size_t nFail : {(size_t)0, (size_t)1, (size_t)4999, (size_t)9999}) {
+        std::vector<std::atomic<int>> runs(10000);
+        BOOST_CHECK(!RunChecks(setup.queue, runs, runs.size(), 100, nFail));
+        // The failing check ran, the others at most once, and the queue is reset for the next round
+        BOOST_CHECK_EQUAL(runs[nFail], 1);
+        for (size_t i = 0; i < runs.size(); i++) {
+            BOOST_CHECK(runs[i] <= 1);
+        }
+        BOOST_CHECK(setup.queue.IsIdle());
+
+        std::vector<std::atomic<int>> runsOk(10000);
+        BOOST_CHECK(RunChecks(setup.queue, runsOk, runsOk.size(), 100));
+        CheckRunOnce(runsOk);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(checkqueue_control_early_exit)
+{
+    QueueSetup setup;
+    std::vector<std::atomic<int>> runs(10000);
+    {
+        // Leaving the scope (e.g. an early return on another error) without Wait():
+        // the control waits for the checks added so far on destruction
+        CCheckQueueControl<CountingCheck> control(&setup.queue);
+        std::vector<CountingCheck> vChecks;
+        for (size_t i = 0; i < runs.size(); i++) {
+            vChecks.emplace_back(runs, i, i != 10);
+        }
+        control.Add(vChecks);
+    }
+    BOOST_CHECK(setup.queue.IsIdle());
+    BOOST_CHECK_EQUAL(runs[10], 1);
+
+    // The failure of the abandoned round doesn't leak into the next one
+    std::vector<std::atomic<int>> runsOk(10000);
+    BOOST_CHECK(RunChecks(setup.queue, runsOk, runsOk.size(), 1000));
+    CheckRunOnce(runsOk);
+
+    // A control without a queue does nothing
+    CCheckQueueControl<CountingCheck> control(nullptr);
+    std::vector<CountingCheck> vChecks{CountingCheck(runsOk, 0, false)};
+    control.Add(vChecks);
+    BOOST_CHECK(control.Wait());
+    BOOST_CHECK_EQUAL(runsOk[0], 1);
+}
+
+BOOST_AUTO_TEST_CASE(checkqueue_interrupt)
+{
+    std::unique_ptr<QueueSetup> setup(new QueueSetup());
+    std::vector<std::atomic<int>> runs(10000);
+    BOOST_CHECK(RunChecks(setup->queue, runs, runs.size(), 100));
+
+    // Interrupt the (by now sleeping) workers: they must all exit and be joined
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+    setup->threadGroup.interrupt_all();
+    setup->threadGroup.join_all();
+    BOOST_CHECK_EQUAL(setup->threadGroup.size(), (size_t)SCRIPT_CHECK_THREADS);
+
+    // Without workers the master still runs every check on its own
+    std::vector<std::atomic<int>> runsAfter(10000);
+    BOOST_CHECK(RunChecks(setup->queue, runsAfter, runsAfter.size(), 100));
+    CheckRunOnce(runsAfter);
+    BOOST_CHECK(setup->queue.IsIdle());
+    setup.reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1320,4 +1320,178 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_prefetch)
+{
+    CCoinsViewTest base;
+    CCoinsViewCache parent(&base);
+    std::vector<COutPoint> vOutpoints;
+    for (unsigned int i = 0; i < 100; i++) {
+        const COutPoint outpoint(InsecureRand256(), i % 3);
+        if (i % 4 != 0) {
+            Coin coin;
+            coin.out.nValue = InsecureRand32();
+            coin.nHeight = i + 1;
+            parent.AddCoin(outpoint, std::move(coin), false);
+        }
+        vOutpoints.emplace_back(outpoint);
+    }
+    // a spent coin
+    parent.SpendCoin(vOutpoints[1]);
+
+    CCoinsViewCache cache(&parent);
+    std::vector<COutPoint> vPrefetch(vOutpoints);
+    cache.PrefetchCoins(vPrefetch);
+    BOOST_CHECK(std::is_sorted(vPrefetch.begin(), vPrefetch.end()));
+    for (unsigned int i = 0; i < vOutpoints.size(); i++) {
+        const bool fUnspent = i % 4 != 0 && i != 1;
+        BOOST_CHECK_EQUAL(cache.HaveCoinInCache(vOutpoints[i]), fUnspent);
+        if (fUnspent) {
+            const Coin& coin = cache.AccessCoin(vOutpoints[i]);
+            BOOST_CHECK(coin.out == parent.AccessCoin(vOutpoints[i]).out);
+            BOOST_CHECK_EQUAL(coin.nHeight, parent.AccessCoin(vOutpoints[i]).nHeight);
+        }
+    }
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 74U);
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_sync)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+    std::vector<COutPoint> vOutpoints;
+    for (unsigned int i = 0; i < 100; i++) {
+        vOutpoints.emplace_back(InsecureRand256(), i % 3);
+        Coin coin;
+        coin.out.nValue = InsecureRand32();
+        coin.out.scriptPubKey.assign(InsecureRandRange(60), OP_TRUE);
+        coin.nHeight = i + 1;
+        cache.AddCoin(vOutpoints.back(), std::move(coin), false);
+    }
+
+    // the coins are written, and stay cached as clean entries
+    BOOST_CHECK(cache.Sync());
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 100U);
+    for (const auto& entry : cache.map()) {
+        BOOST_CHECK_EQUAL(entry.second.flags, 0);
+    }
+    for (const COutPoint& outpoint : vOutpoints) {
+        CCoinsViewCache view(&base);
+        BOOST_CHECK(view.HaveCoin(outpoint));
+    }
+
+    // spent coins are written and dropped
+    cache.SpendCoin(vOutpoints[0]);
+    BOOST_CHECK(cache.Sync());
+    cache.SelfTest();
+    BOOST_CHECK(!cache.HaveCoinInCache(vOutpoints[0]));
+    BOOST_CHECK(!CCoinsViewCache(&base).HaveCoin(vOutpoints[0]));
+
+    // only the least recently used coins are evicted to get under the target
+    for (unsigned int i = 50; i < 100; i++) {
+        cache.AccessCoin(vOutpoints[i]);
+    }
+    const size_t nTargetUsage = cache.DynamicMemoryUsage() - 1;
+    BOOST_CHECK(cache.Sync(nTargetUsage));
+    cache.SelfTest();
+    BOOST_CHECK(cache.DynamicMemoryUsage() <= nTargetUsage);
+    BOOST_CHECK(cache.GetCacheSize() < 99U);
+    for (unsigned int i = 50; i < 100; i++) {
+        BOOST_CHECK(cache.HaveCoinInCache(vOutpoints[i]));
+    }
+
+    // evicted coins are read back from the base
+    BOOST_CHECK(cache.Sync(0));
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    for (unsigned int i = 1; i < 100; i++) {
+        BOOST_CHECK_EQUAL(cache.AccessCoin(vOutpoints[i]).nHeight, i + 1);
+    }
+
+    // beyond the copy budget, the least recently used dirty coins are evicted instead of copied
+    for (unsigned int i = 1; i < 100; i++) {
+        Coin coin = cache.AccessCoin(vOutpoints[i]);
+        coin.nHeight += 100;
+        cache.AddCoin(vOutpoints[i], std::move(coin), true);
+    }
+    size_t nRecentUsage = 0;
+    for (unsigned int i = 50; i < 100; i++) {
+        nRecentUsage += memusage::MallocUsage(sizeof(memusage::unordered_node<CCoinsMap::value_type>)) +
+                        cache.AccessCoin(vOutpoints[i]).DynamicMemoryUsage();
+    }
+    BOOST_CHECK(cache.Sync(std::numeric_limits<size_t>::max(), nRecentUsage));
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 50U);
+    for (unsigned int i = 50; i < 100; i++) {
+        BOOST_CHECK(cache.HaveCoinInCache(vOutpoints[i]));
+    }
+    for (const auto& entry : cache.map()) {
+        BOOST_CHECK_EQUAL(entry.second.flags, 0);
+    }
+    for (unsigned int i = 1; i < 100; i++) {
+        BOOST_CHECK_EQUAL(CCoinsViewCache(&base).AccessCoin(vOutpoints[i]).nHeight, i + 101);
+    }
+
+    // without a copy budget, the dirty coins are all evicted, and the clean ones stay
+    for (unsigned int i = 50; i < 75; i++) {
+        Coin coin = cache.AccessCoin(vOutpoints[i]);
+        cache.AddCoin(vOutpoints[i], std::move(coin), true);
+    }
+    BOOST_CHECK(cache.Sync(std::numeric_limits<size_t>::max(), 0));
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 25U);
+    for (unsigned int i = 75; i < 100; i++) {
+        BOOST_CHECK(cache.HaveCoinInCache(vOutpoints[i]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_undo_buffer)
+{
+    // The buffer holds the serialization of the CBlockUndo, built one tx at a time
+    CBlockUndo blockundo;
+    size_t nInputs = 0;
+    for (unsigned int i = 0; i < 30; i++) {
+        CTxUndo txundo;
+        const unsigned int nPrevouts = InsecureRandRange(5);
+        for (unsigned int j = 0; j < nPrevouts; j++) {
+            Coin coin;
+            coin.out.nValue = InsecureRand32();
+            coin.out.scriptPubKey.assign(InsecureRandRange(60), OP_TRUE);
+            coin.nHeight = InsecureRandRange(4000000);
+            coin.fCoinBase = InsecureRandBool();
+            coin.fCoinStake = !coin.fCoinBase && InsecureRandBool();
+            txundo.vprevout.emplace_back(std::move(coin));
+        }
+        nInputs += nPrevouts;
+        blockundo.vtxundo.emplace_back(std::move(txundo));
+    }
+
+    CBlockUndoBuffer buffer(blockundo.vtxundo.size(), nInputs);
+    for (const CTxUndo& txundo : blockundo.vtxundo) {
+        BOOST_CHECK(!buffer.IsComplete());
+        buffer.Add(txundo);
+    }
+    BOOST_CHECK(buffer.IsComplete());
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << blockundo;
+    BOOST_CHECK_EQUAL(HexStr(ss.begin(), ss.end()), HexStr(buffer.data(), buffer.data() + buffer.size()));
+
+    CBlockUndo blockundo2;
+    CDataStream ss2(buffer.data(), buffer.data() + buffer.size(), SER_DISK, CLIENT_VERSION);
+    ss2 >> blockundo2;
+    BOOST_CHECK_EQUAL(blockundo2.vtxundo.size(), blockundo.vtxundo.size());
+    for (unsigned int i = 0; i < blockundo.vtxundo.size(); i++) {
+        const std::vector<Coin>& vprevout = blockundo.vtxundo[i].vprevout;
+        const std::vector<Coin>& vprevout2 = blockundo2.vtxundo[i].vprevout;
+        BOOST_CHECK_EQUAL(vprevout2.size(), vprevout.size());
+        for (unsigned int j = 0; j < vprevout.size(); j++) {
+            BOOST_CHECK(vprevout2[j].out == vprevout[j].out);
+            BOOST_CHECK_EQUAL(vprevout2[j].nHeight, vprevout[j].nHeight);
+            BOOST_CHECK_EQUAL(vprevout2[j].fCoinBase, vprevout[j].fCoinBase);
+            BOOST_CHECK_EQUAL(vprevout2[j].fCoinStake, vprevout[j].fCoinStake);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
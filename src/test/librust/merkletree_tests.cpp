@@ -134,6 +134,57 @@ BOOST_AUTO_TEST_CASE(SaplingVectors) {
     );
 }
 
+BOOST_AUTO_TEST_CASE(SaplingBatchAppend) {
+    UniValue commitment_tests = read_json(MAKE_STRING(json_tests::merkle_commitments_sapling));
+
+    // Blocks of commitments, filling the testing tree
+    const std::vector<size_t> block_sizes = {3, 1, 5, 7};
+
+    SaplingTestingMerkleTree tree;
+    SaplingTestingMerkleTree batch_tree;
+    std::vector<SaplingTestingWitness> witnesses;
+    std::vector<SaplingTestingWitness> batch_witnesses;
+    size_t i = 0;
+    for (size_t block_size : block_sizes) {
+        std::vector<libzcash::PedersenHash> commitments;
+        const uint64_t start = batch_tree.size();
+        for (size_t j = 0; j < block_size; j++, i++) {
+            const uint256 test_commitment = uint256S(commitment_tests[i].get_str());
+            commitments.emplace_back(test_commitment);
+
+            // Sequential appends, witnessing every commitment
+            tree.append(test_commitment);
+            for (SaplingTestingWitness& wit : witnesses) {
+                wit.append(test_commitment);
+            }
+            witnesses.push_back(tree.witness());
+
+            // Witnesses of the batch are taken as the block is connected
+            batch_tree.append(test_commitment);
+            batch_witnesses.push_back(batch_tree.witness());
+        }
+
+        SaplingTestingMerkleBatch batch(start, commitments);
+        for (SaplingTestingWitness& wit : batch_witnesses) {
+            wit.append(batch);
+        }
+
+        BOOST_CHECK(batch_tree == tree);
+        BOOST_CHECK_EQUAL(batch_witnesses.size(), witnesses.size());
+        for (size_t k = 0; k < witnesses.size(); k++) {
+            BOOST_CHECK(batch_witnesses[k] == witnesses[k]);
+            BOOST_CHECK(batch_witnesses[k].root() == tree.root());
+        }
+    }
+
+    // A witness must be contiguous with the batch
+    SaplingTestingMerkleTree short_tree;
+    short_tree.append(uint256S(commitment_tests[0].get_str()));
+    SaplingTestingWitness wit = short_tree.witness();
+    SaplingTestingMerkleBatch batch(2, {uint256S(commitment_tests[2].get_str())});
+    BOOST_CHECK_THROW(wit.append(batch), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(emptyroots) {
     libzcash::EmptyMerkleRoots<64, libzcash::SHA256Compress> emptyroots;
     std::array<libzcash::SHA256Compress, 65> computed;
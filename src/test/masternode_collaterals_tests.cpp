@@ -0,0 +1,86 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_pivx.h"
+
+#include "masternode-collaterals.h"
+#include "primitives/block.h"
+#include "validation.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(masternode_collaterals_tests, TestingSetup)
+
+static CTxOut CollateralOut()
+{
+    return CTxOut(10000 * COIN, CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0x42) << OP_EQUALVERIFY << OP_CHECKSIG);
+}
+
+BOOST_AUTO_TEST_CASE(collateral_watch_set)
+{
+    CCollateralWatchSet watchSet;
+    const int nTipHeight = WITH_LOCK(cs_main, return chainActive.Height(); );
+
+    // a collateral already in the UTXO set
+    const COutPoint collateral(InsecureRand256(), 1);
+    WITH_LOCK(cs_main, pcoinsTip->AddCoin(collateral, Coin(CollateralOut(), nTipHeight, false, false), false); );
+    watchSet.Watch(collateral, CCollateralWatchSet::LEGACY);
+    Optional<CollateralStatus> status = watchSet.Get(collateral);
+    BOOST_CHECK(status && status->IsUnspent());
+    BOOST_CHECK_EQUAL(status->nHeight, nTipHeight);
+    BOOST_CHECK(status->out == CollateralOut());
+    BOOST_CHECK_EQUAL(watchSet.GetDepthAtHeight(collateral, nTipHeight + 9), 10);
+    BOOST_CHECK(watchSet.GetConfirmations(collateral) == Optional<int>(1));
+
+    // a block spending it, and creating a collateral watched before being mined
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(collateral);
+    mtx.vout.emplace_back(CollateralOut());
+    CBlock block;
+    block.vtx.emplace_back(MakeTransactionRef(mtx));
+    const COutPoint collateral2(block.vtx[0]->GetHash(), 0);
+    watchSet.Watch(collateral2, CCollateralWatchSet::DETERMINISTIC);
+    BOOST_CHECK(!watchSet.Get(collateral2)->IsUnspent());
+    BOOST_CHECK_EQUAL(watchSet.GetDepthAtHeight(collateral2, nTipHeight), -1);
+    BOOST_CHECK(watchSet.GetConfirmations(collateral2) == nullopt);
+
+    const std::vector<COutPoint>& vSpent = watchSet.BlockConnected(block, nTipHeight + 1);
+    BOOST_CHECK(vSpent == std::vector<COutPoint>{collateral});
+    status = watchSet.Get(collateral);
+    BOOST_CHECK(!status->IsUnspent());
+    BOOST_CHECK_EQUAL(status->nSpentHeight, nTipHeight + 1);
+    BOOST_CHECK_EQUAL(watchSet.GetDepthAtHeight(collateral, nTipHeight + 1), -1);
+    status = watchSet.Get(collateral2);
+    BOOST_CHECK(status->IsUnspent());
+    BOOST_CHECK_EQUAL(status->nHeight, nTipHeight + 1);
+    BOOST_CHECK(status->out == CollateralOut());
+    BOOST_CHECK(watchSet.GetConfirmations(collateral2) == Optional<int>(1));
+
+    // disconnect it (the UTXO set is always updated first)
+    {
+        LOCK(cs_main);
+        watchSet.BlockDisconnected(block, nTipHeight + 1);
+    }
+    status = watchSet.Get(collateral);
+    BOOST_CHECK(status->IsUnspent());
+    BOOST_CHECK_EQUAL(status->nHeight, nTipHeight);
+    BOOST_CHECK(!watchSet.Get(collateral2)->IsUnspent());
+
+    // outpoints stay watched while they have an owner
+    watchSet.Watch(collateral, CCollateralWatchSet::DETERMINISTIC);
+    BOOST_CHECK_EQUAL(watchSet.Size(), 2U);
+    watchSet.Unwatch(collateral, CCollateralWatchSet::LEGACY);
+    BOOST_CHECK(watchSet.Get(collateral) != nullopt);
+    watchSet.UnwatchAll(CCollateralWatchSet::DETERMINISTIC);
+    BOOST_CHECK_EQUAL(watchSet.Size(), 0U);
+
+    // unwatched outpoints are looked up in the UTXO set
+    BOOST_CHECK(watchSet.Get(collateral) == nullopt);
+    BOOST_CHECK_EQUAL(watchSet.GetDepthAtHeight(collateral, nTipHeight), -1);
+    BOOST_CHECK(watchSet.Lookup(collateral).IsUnspent());
+    BOOST_CHECK(watchSet.GetConfirmations(collateral) == Optional<int>(1));
+    BOOST_CHECK(!watchSet.Lookup(collateral2).IsUnspent());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
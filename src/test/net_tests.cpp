@@ -7,6 +7,8 @@
 #include "hash.h"
 #include "net.h"
 #include "netbase.h"
+#include "netmessagemaker.h"
+#include "random.h"
 #include "serialize.h"
 #include "streams.h"
 #include "util/memory.h"
@@ -215,4 +217,131 @@ BOOST_AUTO_TEST_CASE(ipv4_peer_with_ipv6_addrMe_test)
     BOOST_CHECK(1);
 }
 
+/** The bytes of a message as sent on the wire: header (with the checksum of the payload), then payload */
+static std::vector<char> SerializeNetMsg(CSerializedNetMsg&& msg)
+{
+    uint256 hash = Hash(msg.data.data(), msg.data.data() + msg.data.size());
+    CMessageHeader hdr(Params().MessageStart(), msg.command.c_str(), msg.data.size());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+    std::vector<unsigned char> vBytes;
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, vBytes, 0, hdr};
+    vBytes.insert(vBytes.end(), msg.data.begin(), msg.data.end());
+    return std::vector<char>(vBytes.begin(), vBytes.end());
+}
+
+/** A header announcing a payload of nSize bytes */
+static std::vector<char> SerializeNetHeader(const char* pszCommand, unsigned int nSize)
+{
+    CMessageHeader hdr(Params().MessageStart(), pszCommand, nSize);
+    std::vector<unsigned char> vBytes;
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, vBytes, 0, hdr};
+    return std::vector<char>(vBytes.begin(), vBytes.end());
+}
+
+static bool ChecksumMatches(const CNetMessage& msg)
+{
+    return memcmp(msg.GetMessageHash().begin(), msg.hdr.pchChecksum, CMessageHeader::CHECKSUM_SIZE) == 0;
+}
+
+static std::unique_ptr<CNode> MakeRecvNode()
+{
+    in_addr ipv4Addr;
+    ipv4Addr.s_addr = 0xa0b0c001;
+    CAddress addr = CAddress(CService(ipv4Addr, 7777), NODE_NETWORK);
+    return MakeUnique<CNode>(0, NODE_NETWORK, 0, INVALID_SOCKET, addr, 0, 0, std::string{}, true);
+}
+
+/** Feed the bytes to the node in reads of (up to) nChunk bytes */
+static void RecvInChunks(CConnman& connman, CNode* pnode, const std::vector<char>& vBytes, size_t nChunk)
+{
+    for (size_t nPos = 0; nPos < vBytes.size(); nPos += nChunk) {
+        connman.ProcessRecvBytes(pnode, vBytes.data() + nPos, std::min(nChunk, vBytes.size() - nPos));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(recv_framing_split_reads)
+{
+    CConnman connman(0x1337, 0x1337);
+    CNetMsgMaker msgMaker(INIT_PROTO_VERSION);
+    const std::vector<char> vPing = SerializeNetMsg(msgMaker.Make(NetMsgType::PING, (uint64_t)42));
+    const std::vector<char> vInv = SerializeNetMsg(msgMaker.Make(NetMsgType::INV, std::vector<CInv>(100, CInv(MSG_TX, GetRandHash()))));
+    std::vector<char> vBytes(vPing);
+    vBytes.insert(vBytes.end(), vInv.begin(), vInv.end());
+
+    // The same bytes, in reads splitting the headers and the payloads anywhere
+    for (size_t nChunk : {(size_t)1, (size_t)5, (size_t)23, (size_t)25, (size_t)100, vPing.size(), vPing.size() + 1, vBytes.size()}) {
+        std::unique_ptr<CNode> pnode = MakeRecvNode();
+        for (size_t nPos = 0; nPos < vBytes.size(); nPos += nChunk) {
+            const size_t nEnd = std::min(nPos + nChunk, vBytes.size());
+            connman.ProcessRecvBytes(pnode.get(), vBytes.data() + nPos, nEnd - nPos);
+            // Only the complete messages are handed to the message handler
+            LOCK(pnode->cs_vProcessMsg);
+            const size_t nComplete = (nEnd >= vPing.size()) + (nEnd == vBytes.size());
+            BOOST_CHECK_EQUAL(pnode->vProcessMsg.size(), nComplete);
+        }
+        BOOST_CHECK(!pnode->fDisconnect);
+
+        LOCK(pnode->cs_vProcessMsg);
+        BOOST_CHECK_EQUAL(pnode->nProcessQueueSize, vBytes.size());
+        CNetMessage& ping = pnode->vProcessMsg.front();
+        BOOST_CHECK_EQUAL(ping.hdr.GetCommand(), NetMsgType::PING);
+        BOOST_CHECK(ChecksumMatches(ping));
+        uint64_t nonce = 0;
+        ping.vRecv >> nonce;
+        BOOST_CHECK_EQUAL(nonce, 42);
+        const CNetMessage& inv = pnode->vProcessMsg.back();
+        BOOST_CHECK_EQUAL(inv.hdr.GetCommand(), NetMsgType::INV);
+        BOOST_CHECK_EQUAL(inv.vRecv.size(), vInv.size() - CMessageHeader::HEADER_SIZE);
+        BOOST_CHECK(ChecksumMatches(inv));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(recv_framing_checksum_mismatch)
+{
+    CConnman connman(0x1337, 0x1337);
+    CNetMsgMaker msgMaker(INIT_PROTO_VERSION);
+    std::vector<char> vBytes = SerializeNetMsg(msgMaker.Make(NetMsgType::PING, (uint64_t)42));
+    vBytes.back() ^= 1;
+    const std::vector<char> vPing = SerializeNetMsg(msgMaker.Make(NetMsgType::PING, (uint64_t)43));
+    vBytes.insert(vBytes.end(), vPing.begin(), vPing.end());
+
+    for (size_t nChunk : {(size_t)1, (size_t)7, vBytes.size()}) {
+        // The corrupted message is framed (the message handler drops it), and doesn't affect the next one
+        std::unique_ptr<CNode> pnode = MakeRecvNode();
+        RecvInChunks(connman, pnode.get(), vBytes, nChunk);
+        BOOST_CHECK(!pnode->fDisconnect);
+        LOCK(pnode->cs_vProcessMsg);
+        BOOST_CHECK_EQUAL(pnode->vProcessMsg.size(), 2);
+        BOOST_CHECK(!ChecksumMatches(pnode->vProcessMsg.front()));
+        BOOST_CHECK(ChecksumMatches(pnode->vProcessMsg.back()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(recv_framing_oversized_header)
+{
+    CConnman connman(0x1337, 0x1337);
+    CNetMsgMaker msgMaker(INIT_PROTO_VERSION);
+    const std::vector<char> vPing = SerializeNetMsg(msgMaker.Make(NetMsgType::PING, (uint64_t)42));
+
+    // Over the protocol limit, and over the serialization limit
+    for (unsigned int nSize : {MAX_PROTOCOL_MESSAGE_LENGTH + 1, (unsigned int)MAX_SIZE + 1}) {
+        std::vector<char> vBytes(vPing);
+        const std::vector<char> vHeader = SerializeNetHeader(NetMsgType::BLOCK, nSize);
+        vBytes.insert(vBytes.end(), vHeader.begin(), vHeader.end());
+
+        for (size_t nChunk : {(size_t)1, (size_t)10, vBytes.size()}) {
+            std::unique_ptr<CNode> pnode = MakeRecvNode();
+            RecvInChunks(connman, pnode.get(), std::vector<char>(vBytes.begin(), vBytes.end() - 1), nChunk);
+            // The peer is disconnected once the header is complete, before any payload
+            BOOST_CHECK(!pnode->fDisconnect);
+            connman.ProcessRecvBytes(pnode.get(), &vBytes.back(), 1);
+            BOOST_CHECK(pnode->fDisconnect);
+            // The message received before is still handed over
+            LOCK(pnode->cs_vProcessMsg);
+            BOOST_CHECK_EQUAL(pnode->vProcessMsg.size(), 1);
+            BOOST_CHECK(ChecksumMatches(pnode->vProcessMsg.front()));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
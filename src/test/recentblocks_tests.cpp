@@ -0,0 +1,98 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_pivx.h"
+
+#include "coins.h"
+#include "primitives/block.h"
+#include "recentblocks.h"
+#include "undo.h"
+#include "version.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(recentblocks_tests, BasicTestingSetup)
+
+static std::shared_ptr<const CBlock> MakeBlock(size_t nOutputs)
+{
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(COutPoint(InsecureRand256(), 0));
+    mtx.vout.resize(nOutputs, CTxOut(COIN, CScript() << OP_TRUE));
+    std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+    pblock->nNonce = InsecureRand32();
+    pblock->vtx.emplace_back(MakeTransactionRef(mtx));
+    return pblock;
+}
+
+BOOST_AUTO_TEST_CASE(recent_blocks_cache)
+{
+    CRecentBlocksCache cache;
+    cache.Init(10, 1 << 20);
+
+    // blocks and undo data are returned as they were added
+    std::vector<std::shared_ptr<const CBlock>> vBlocks;
+    for (int nHeight = 0; nHeight < 10; nHeight++) {
+        vBlocks.emplace_back(MakeBlock(1));
+        cache.AddBlock(vBlocks.back()->GetHash(), nHeight, vBlocks.back());
+    }
+    CTxUndo txundo;
+    txundo.vprevout.emplace_back(CTxOut(COIN, CScript() << OP_TRUE), 5, false, false);
+    CBlockUndoBuffer undoBuffer(1, 1);
+    undoBuffer.Add(txundo);
+    cache.AddUndo(vBlocks[5]->GetHash(), 5, undoBuffer);
+
+    BOOST_CHECK(cache.GetBlock(vBlocks[5]->GetHash()) == vBlocks[5]);
+    CBlockUndo blockundo;
+    BOOST_CHECK(cache.GetUndo(vBlocks[5]->GetHash(), blockundo));
+    BOOST_CHECK_EQUAL(blockundo.vtxundo.size(), 1U);
+    BOOST_CHECK_EQUAL(blockundo.vtxundo[0].vprevout[0].nHeight, 5U);
+    BOOST_CHECK(blockundo.vtxundo[0].vprevout[0].out == txundo.vprevout[0].out);
+    BOOST_CHECK(!cache.GetUndo(vBlocks[4]->GetHash(), blockundo));
+    BOOST_CHECK(cache.GetBlock(InsecureRand256()) == nullptr);
+
+    CRecentBlocksCache::Stats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.nBlocks, 10U);
+    BOOST_CHECK_EQUAL(stats.nUndos, 1U);
+    BOOST_CHECK_EQUAL(stats.nBlockHits, 1U);
+    BOOST_CHECK_EQUAL(stats.nBlockMisses, 1U);
+    BOOST_CHECK_EQUAL(stats.nUndoHits, 1U);
+    BOOST_CHECK_EQUAL(stats.nUndoMisses, 1U);
+
+    // blocks deeper than the max reorg depth are evicted
+    const std::shared_ptr<const CBlock>& pblockTip = MakeBlock(1);
+    cache.AddBlock(pblockTip->GetHash(), 11, pblockTip);
+    BOOST_CHECK(cache.GetBlock(vBlocks[0]->GetHash()) == nullptr);
+    BOOST_CHECK(cache.GetBlock(vBlocks[1]->GetHash()) == nullptr);
+    BOOST_CHECK(cache.GetBlock(vBlocks[2]->GetHash()) == vBlocks[2]);
+    // a side-chain block at the same height is kept
+    const std::shared_ptr<const CBlock>& pblockFork = MakeBlock(1);
+    cache.AddBlock(pblockFork->GetHash(), 11, pblockFork);
+    BOOST_CHECK(cache.GetBlock(pblockFork->GetHash()) == pblockFork);
+    BOOST_CHECK(cache.GetBlock(pblockTip->GetHash()) == pblockTip);
+    BOOST_CHECK_EQUAL(cache.GetStats().nBlocks, 10U);
+
+    // the lowest blocks are evicted when the cache goes over its memory limit
+    const std::shared_ptr<const CBlock>& pblockBig = MakeBlock(1000);
+    cache.Init(10, ::GetSerializeSize(*pblockBig, SER_NETWORK, PROTOCOL_VERSION) + 100);
+    cache.AddBlock(pblockBig->GetHash(), 12, pblockBig);
+    stats = cache.GetStats();
+    BOOST_CHECK(stats.nBytes <= stats.nMaxBytes);
+    BOOST_CHECK(cache.GetBlock(pblockBig->GetHash()) == pblockBig);
+    BOOST_CHECK(cache.GetBlock(vBlocks[2]->GetHash()) == nullptr);
+    BOOST_CHECK(stats.nBlocks < 10U);
+
+    cache.Clear();
+    stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.nBlocks, 0U);
+    BOOST_CHECK_EQUAL(stats.nBytes, 0U);
+    BOOST_CHECK(cache.GetBlock(pblockBig->GetHash()) == nullptr);
+
+    // -recentblockscache=0 disables the cache
+    cache.Init(10, 0);
+    cache.AddBlock(pblockBig->GetHash(), 12, pblockBig);
+    BOOST_CHECK(cache.GetBlock(pblockBig->GetHash()) == nullptr);
+    BOOST_CHECK_EQUAL(cache.GetStats().nBytes, 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -494,4 +494,55 @@ BOOST_AUTO_TEST_CASE(test_IsStandard)
     BOOST_CHECK(!IsStandardTx(t, 0, reason));
 }
 
+BOOST_AUTO_TEST_CASE(test_compact_payloads)
+{
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(COutPoint(GetRandHash(), 0));
+    mtx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+
+    // Transparent transactions share the same (empty) sapling data
+    const CTransaction tx1(mtx);
+    mtx.nLockTime = 1;
+    const CTransaction tx2(mtx);
+    BOOST_CHECK(tx1.sapData && tx2.sapData);
+    BOOST_CHECK(tx1.sapData.GetShared() == tx2.sapData.GetShared());
+    BOOST_CHECK(tx1.extraPayload == nullopt);
+    BOOST_CHECK_EQUAL(tx1.DynamicMemoryUsage(), memusage::RecursiveDynamicUsage(tx1.vin) + memusage::RecursiveDynamicUsage(tx1.vout));
+    {
+        // Hashed while deserialized
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << tx1;
+        const size_t nSize = ss.size();
+        CTransaction txRead(deserialize, ss);
+        BOOST_CHECK(txRead.GetHash() == tx1.GetHash());
+        BOOST_CHECK_EQUAL(txRead.GetTotalSize(), nSize);
+    }
+
+    // Serialization is unchanged, with empty, missing and non-empty payloads
+    mtx.nVersion = CTransaction::TxVersion::SAPLING;
+    for (int i = 0; i < 4; i++) {
+        if (i == 1) mtx.sapData = nullopt;
+        if (i == 2) {
+            mtx.sapData.emplace();
+            mtx.sapData->valueBalance = 10;
+        }
+        if (i == 3) {
+            mtx.nType = CTransaction::TxType::PROREG;
+            mtx.extraPayload = std::vector<uint8_t>(10, 1);
+        }
+        const CTransaction tx(mtx);
+        BOOST_CHECK(tx.GetHash() == mtx.GetHash());
+        BOOST_CHECK(CMutableTransaction(tx).GetHash() == mtx.GetHash());
+        BOOST_CHECK_EQUAL(tx.sapData != nullopt, mtx.sapData != nullopt);
+        BOOST_CHECK_EQUAL(tx.extraPayload != nullopt, mtx.extraPayload != nullopt);
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << tx;
+        // Cached size
+        BOOST_CHECK_EQUAL(tx.GetTotalSize(), ss.size());
+        BOOST_CHECK_EQUAL(::GetSerializeSize(tx, SER_DISK, CLIENT_VERSION), ss.size());
+        CTransaction txRead(deserialize, ss);
+        BOOST_CHECK(txRead.GetHash() == tx.GetHash());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
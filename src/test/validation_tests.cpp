@@ -4,6 +4,7 @@
 
 #include "test/test_pivx.h"
 #include "blockassembler.h"
+#include "checkpoints.h"
 #include "primitives/transaction.h"
 #include "sapling/sapling_validation.h"
 #include "test/librust/utiltest.h"
@@ -155,4 +156,53 @@ BOOST_FIXTURE_TEST_CASE(zerocoin_rejection_tests, WalletRegTestingSetup)
     CheckMempoolZcRejection(mtx);
 }
 
+BOOST_FIXTURE_TEST_CASE(assumevalid_tests, TestChain100Setup)
+{
+    LOCK(cs_main);
+    const uint256 hashAssumeValidSaved = hashAssumeValid;
+    BOOST_CHECK(pindexBestHeader == chainActive.Tip());
+
+    // -assumevalid=0: every block is verified
+    hashAssumeValid = UINT256_ZERO;
+    for (int i = 0; i <= chainActive.Height(); i++) {
+        BOOST_CHECK(!IsBlockAssumedValid(chainActive[i]));
+    }
+
+    // A hash on the chain: the block and its ancestors are assumed valid
+    hashAssumeValid = chainActive[60]->GetBlockHash();
+    for (int i = 0; i <= chainActive.Height(); i++) {
+        BOOST_CHECK_EQUAL(IsBlockAssumedValid(chainActive[i]), i <= 60);
+    }
+
+    // A hash not on the (best header) chain: nothing is assumed valid
+    const uint256 hashFork = GetRandHash();
+    CBlockIndex fork;
+    fork.pprev = chainActive[40];
+    fork.nHeight = 41;
+    fork.BuildSkip();
+    fork.phashBlock = &(mapBlockIndex.emplace(hashFork, &fork).first->first);
+    hashAssumeValid = hashFork;
+    for (int i = 0; i <= chainActive.Height(); i++) {
+        BOOST_CHECK(!IsBlockAssumedValid(chainActive[i]));
+    }
+    BOOST_CHECK(!IsBlockAssumedValid(&fork));
+    mapBlockIndex.erase(hashFork);
+
+    // A hash beyond the tip (not received yet): nothing is assumed valid until it is on the best header chain
+    hashAssumeValid = GetRandHash();
+    for (int i = 0; i <= chainActive.Height(); i++) {
+        BOOST_CHECK(!IsBlockAssumedValid(chainActive[i]));
+    }
+
+    // The last checkpoint (default of the networks without an assumed-valid block): applies by height
+    hashAssumeValid = Checkpoints::GetLastCheckpointHash();
+    const int nCheckpointHeight = Checkpoints::GetCheckpointHeight(hashAssumeValid);
+    BOOST_CHECK(nCheckpointHeight >= 0);
+    for (int i = 0; i <= chainActive.Height(); i++) {
+        BOOST_CHECK_EQUAL(IsBlockAssumedValid(chainActive[i]), i <= nCheckpointHeight);
+    }
+
+    hashAssumeValid = hashAssumeValidSaved;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+// Copyright (c) 2021 The PIVX developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_pivx.h"
+
+#include "chainparams.h"
+#include "libzerocoin/Params.h"
+#include "libzerocoin/PrecomputedParams.h"
+#include "streams.h"
+#include "utilstrencodings.h"
+#include "version.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(zerocoin_params_tests, BasicTestingSetup)
+
+static std::vector<unsigned char> Serialize(const libzerocoin::ZerocoinParams& params)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << params;
+    return std::vector<unsigned char>(ss.begin(), ss.end());
+}
+
+// Derive the params from the modulus (CalculateParams), and check them against the precomputed set
+static void CheckPrecomputedParams(const CBigNum& bnModulus, const unsigned char* pdata, size_t nSize)
+{
+    const std::vector<unsigned char> precomputed(pdata, pdata + nSize);
+    const std::vector<unsigned char> generated = Serialize(libzerocoin::ZerocoinParams(bnModulus));
+    BOOST_CHECK_MESSAGE(generated == precomputed,
+            "precomputed zerocoin params mismatch, serialized params:\n" + HexStr(generated));
+}
+
+BOOST_AUTO_TEST_CASE(precomputed_params_match_generation)
+{
+    const std::string& strModulus = Params().GetConsensus().ZC_Modulus;
+    CBigNum bnHexModulus = 0;
+    bnHexModulus.SetHex(strModulus);
+    CheckPrecomputedParams(bnHexModulus, libzerocoin::zerocoin_params_hex, sizeof(libzerocoin::zerocoin_params_hex));
+    CBigNum bnDecModulus = 0;
+    bnDecModulus.SetDec(strModulus);
+    CheckPrecomputedParams(bnDecModulus, libzerocoin::zerocoin_params_dec, sizeof(libzerocoin::zerocoin_params_dec));
+}
+
+BOOST_AUTO_TEST_CASE(loaded_params)
+{
+    // Zerocoin_Params returns the precomputed sets, fully initialized
+    const Consensus::Params& consensus = Params().GetConsensus();
+    for (bool fV1 : {true, false}) {
+        const libzerocoin::ZerocoinParams* params = consensus.Zerocoin_Params(fV1);
+        BOOST_CHECK(params->initialized);
+        BOOST_CHECK(params->accumulatorParams.initialized);
+        BOOST_CHECK(params->coinCommitmentGroup.initialized);
+        BOOST_CHECK(params->serialNumberSoKCommitmentGroup.initialized);
+        BOOST_CHECK_EQUAL(params->zkp_iterations, (uint32_t)ZEROCOIN_DEFAULT_SECURITYLEVEL);
+        // the order of the serial number group is the modulus of the coin commitment group
+        BOOST_CHECK(params->serialNumberSoKCommitmentGroup.groupOrder == params->coinCommitmentGroup.modulus);
+        const unsigned char* pdata = fV1 ? libzerocoin::zerocoin_params_hex : libzerocoin::zerocoin_params_dec;
+        const size_t nSize = fV1 ? sizeof(libzerocoin::zerocoin_params_hex) : sizeof(libzerocoin::zerocoin_params_dec);
+        BOOST_CHECK(Serialize(*params) == std::vector<unsigned char>(pdata, pdata + nSize));
+    }
+    BOOST_CHECK(consensus.Zerocoin_Params(true) != consensus.Zerocoin_Params(false));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,7 +8,7 @@
 #include "netmessagemaker.h"
 #include "net_processing.h"         // for Misbehaving
 #include "spork.h"                  // for sporkManager
-#include "streams.h"                // for CDataStream
+#include "streams.h"                // for CPooledDataStream
 
 
 // Update in-flight message status if needed
@@ -38,7 +38,7 @@ bool CMasternodeSync::UpdatePeerSyncState(const NodeId& id, const char* msg, con
     return false;
 }
 
-bool CMasternodeSync::MessageDispatcher(CNode* pfrom, std::string& strCommand, CDataStream& vRecv)
+bool CMasternodeSync::MessageDispatcher(CNode* pfrom, std::string& strCommand, CPooledDataStream& vRecv)
 {
     if (strCommand == NetMsgType::GETSPORKS) {
         // send sporks
@@ -8,10 +8,12 @@
 #define BITCOIN_UNDO_H
 
 #include "chain.h"
+#include "clientversion.h"
 #include "compressor.h"
 #include "consensus/consensus.h"
 #include "primitives/transaction.h"
 #include "serialize.h"
+#include "streams.h"
 
 /** Undo information for a CTxIn
  *  Contains the prevout's CTxOut being spent, and its metadata as well
@@ -114,4 +116,43 @@ public:
     }
 };
 
+/**
+ * Undo data of a block, serialized (in the CBlockUndo format) while the block is connected:
+ * the undo record of each tx is appended as soon as the tx has been applied to the coins view,
+ * so the spent coins are not held until the end of the block, and the whole undo data doesn't
+ * need to be serialized again (for its size, the file and the checksum) when written to disk.
+ */
+class CBlockUndoBuffer
+{
+private:
+    //! Estimate of the serialized size of the undo record of an input (a compressed P2PKH output)
+    static const size_t INPUT_UNDO_SIZE_ESTIMATE = 40;
+
+    CPooledDataStream stream;
+    //! Number of tx undo records declared in the header, and number appended so far
+    const uint64_t nTxUndo;
+    uint64_t nAdded{0};
+
+public:
+    /** Buffer for nTxUndoIn undo records (all but the coinbase), spending nInputs coins in total */
+    CBlockUndoBuffer(uint64_t nTxUndoIn, size_t nInputs) : stream(SER_DISK, CLIENT_VERSION), nTxUndo(nTxUndoIn)
+    {
+        stream.reserve(9 + nTxUndo * 9 + nInputs * INPUT_UNDO_SIZE_ESTIMATE);
+        WriteCompactSize(stream, nTxUndo);
+    }
+
+    void Add(const CTxUndo& txundo)
+    {
+        assert(nAdded < nTxUndo);
+        stream << txundo;
+        nAdded++;
+    }
+
+    //! Whether all the declared undo records have been appended
+    bool IsComplete() const { return nAdded == nTxUndo; }
+
+    const char* data() const { return stream.data(); }
+    size_t size() const { return stream.size(); }
+};
+
 #endif // BITCOIN_UNDO_H
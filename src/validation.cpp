@@ -32,11 +32,13 @@
 #include "interfaces/handler.h"
 #include "legacy/validation_zerocoin_legacy.h"
 #include "kernel.h"
+#include "masternode-collaterals.h"
 #include "masternode-payments.h"
 #include "masternode-sync.h"
 #include "masternodeman.h"
 #include "policy/policy.h"
 #include "pow.h"
+#include "recentblocks.h"
 #include "reverse_iterate.h"
 #include "script/sigcache.h"
 #include "spork.h"
@@ -45,6 +47,7 @@
 #include "txdb.h"
 #include "txmempool.h"
 #include "undo.h"
+#include "util/memory.h"
 #include "util/system.h"
 #include "utilmoneystr.h"
 #include "validationinterface.h"
@@ -103,6 +106,8 @@ size_t nCoinCacheUsage = 5000 * 300;
 /* If the tip is older than this (in seconds), the node is considered to be in initial block download. */
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
 
+uint256 hashAssumeValid;
+
 /** Fees smaller than this (in upiv) are considered zero fee (for relaying, mining and transaction creation)
  * We are ~100 times smaller then bitcoin now (2015-06-23), set minRelayTxFee only 10 times higher
  * so it's still 10 times lower comparing to bitcoin.
@@ -842,6 +847,20 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex)
     return true;
 }
 
+/** Get the block of pindex from the recent blocks cache, or read it from disk (nullptr on failure) */
+static std::shared_ptr<const CBlock> ReadRecentBlock(const CBlockIndex* pindex)
+{
+    std::shared_ptr<const CBlock> pblock = g_recentblocks.GetBlock(pindex->GetBlockHash());
+    if (!pblock) {
+        std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
+        if (!ReadBlockFromDisk(*pblockRead, pindex)) {
+            return nullptr;
+        }
+        pblock = pblockRead;
+    }
+    return pblock;
+}
+
 
 double ConvertBitsToDouble(unsigned int nBits)
 {
@@ -1220,28 +1239,30 @@ static bool AbortNode(CValidationState& state, const std::string& strMessage, co
 
 namespace {
 
-bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint256& hashBlock)
+bool UndoWriteToDisk(const CBlockUndoBuffer& blockundo, FlatFilePos& pos, const uint256& hashBlock)
 {
+    assert(blockundo.IsComplete());
+
     // Open history file to append
     CAutoFile fileout(OpenUndoFile(pos), SER_DISK, CLIENT_VERSION);
     if (fileout.IsNull())
         return error("%s : OpenUndoFile failed", __func__);
 
     // Write index header
-    unsigned int nSize = GetSerializeSize(fileout, blockundo);
+    unsigned int nSize = blockundo.size();
     fileout << Params().MessageStart() << nSize;
 
-    // Write undo data
+    // Write undo data (already serialized)
     long fileOutPos = ftell(fileout.Get());
     if (fileOutPos < 0)
         return error("%s : ftell failed", __func__);
     pos.nPos = (unsigned int)fileOutPos;
-    fileout << blockundo;
+    fileout.write(blockundo.data(), nSize);
 
-    // calculate & write checksum
+    // calculate & write checksum (the undo serialization doesn't depend on the stream type)
     CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
     hasher << hashBlock;
-    hasher << blockundo;
+    hasher.write(blockundo.data(), nSize);
     fileout << hasher.GetHash();
 
     return true;
@@ -1318,8 +1339,9 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
 
 
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
+ *  pblockUndoUnwritten is the undo data of a block not verified yet, not written to disk.
  *  When FAILED is returned, view is left in an indeterminate state. */
-DisconnectResult DisconnectBlock(CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
+DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, const CBlockUndoBuffer* pblockUndoUnwritten = nullptr)
 {
     AssertLockHeld(cs_main);
 
@@ -1334,14 +1356,19 @@ DisconnectResult DisconnectBlock(CBlock& block, const CBlockIndex* pindex, CCoin
     bool fClean = true;
 
     CBlockUndo blockUndo;
-    FlatFilePos pos = pindex->GetUndoPos();
-    if (pos.IsNull()) {
-        error("%s: no undo data available", __func__);
-        return DISCONNECT_FAILED;
-    }
-    if (!UndoReadFromDisk(blockUndo, pos, pindex->pprev->GetBlockHash())) {
-        error("%s: failure reading undo data", __func__);
-        return DISCONNECT_FAILED;
+    if (pblockUndoUnwritten) {
+        CDataStream ss(pblockUndoUnwritten->data(), pblockUndoUnwritten->data() + pblockUndoUnwritten->size(), SER_DISK, CLIENT_VERSION);
+        ss >> blockUndo;
+    } else if (!g_recentblocks.GetUndo(pindex->GetBlockHash(), blockUndo)) {
+        FlatFilePos pos = pindex->GetUndoPos();
+        if (pos.IsNull()) {
+            error("%s: no undo data available", __func__);
+            return DISCONNECT_FAILED;
+        }
+        if (!UndoReadFromDisk(blockUndo, pos, pindex->pprev->GetBlockHash())) {
+            error("%s: failure reading undo data", __func__);
+            return DISCONNECT_FAILED;
+        }
     }
 
     if (blockUndo.vtxundo.size() + 1 != block.vtx.size()) {
@@ -1452,6 +1479,127 @@ void ThreadScriptCheck()
     scriptcheckqueue.Thread();
 }
 
+/** What ConnectBlock writes for a block besides the chain state, none of it undone by DisconnectBlock */
+struct CConnectedBlockWrites
+{
+    CBlockIndex* pindex;
+    std::unique_ptr<CBlockUndoBuffer> pblockundo;
+    std::vector<std::pair<libzerocoin::CoinSpend, uint256> > vSpends;
+    std::vector<std::pair<uint256, CDiskTxPos> > vPos;
+};
+
+/**
+ * Script checks of a batch of blocks connected during IBD. ConnectBlock leaves them running
+ * on the check queue, so that they overlap with the connection of the next blocks.
+ * The batch is neither flushed to disk nor notified, its undo data, spent serials and txindex
+ * entries aren't written, and the mempool isn't updated, until its checks are done. If one of
+ * them fails, the whole batch is disconnected, and connected again one block at a time, to find
+ * the invalid one.
+ */
+class CScriptCheckPipeline
+{
+public:
+    //! The tip the batch is connected on
+    CBlockIndex* const pindexStart;
+    //! Blocks already in the connect trace when the batch started
+    const size_t nTraceStart;
+    //! The blocks whose checks were queued (kept alive until they are done), and the connected ones
+    std::vector<std::shared_ptr<const CBlock>> vBlockRefs;
+    std::vector<CBlockIndex*> vConnected;
+    //! The writes of the connected blocks, done once the batch is verified
+    std::vector<CConnectedBlockWrites> vPendingWrites;
+    //! The zerocoin serials spent in the batch (not in the zerocoin DB yet), with the height of their block
+    std::map<CBigNum, int> mapSpentSerials;
+    //! The signature hashes the checks point to
+    std::vector<std::unique_ptr<std::vector<PrecomputedTransactionData>>> vPrecomTxData;
+    //! Whether a block of the batch asked for the chain state to be written to disk
+    bool fFlushAlways{false};
+    //! Declared last, so that it waits for the checks before the data above is released
+    CCheckQueueControl<CScriptCheck> control;
+
+    CScriptCheckPipeline(CBlockIndex* pindexStartIn, size_t nTraceStartIn) :
+        pindexStart(pindexStartIn),
+        nTraceStart(nTraceStartIn),
+        control(&scriptcheckqueue) {}
+};
+
+/** Blocks up to this height, part of a batch whose checks failed, are connected without pipelining (reset by invalidate/reconsider) */
+static int nSerialConnectHeight = -1;
+
+/**
+ * Whether the block is an ancestor of the -assumevalid block (or the block itself),
+ * so that its script signatures, zerocoin spend signatures and Sapling proofs are not verified.
+ * The assumed-valid block must be on the best header chain. As the blocks are synced
+ * before their headers are known, an assumed-valid checkpoint (which every accepted
+ * chain must go through) applies by height, before it is received.
+ */
+bool IsBlockAssumedValid(const CBlockIndex* pindex)
+{
+    AssertLockHeld(cs_main);
+    if (hashAssumeValid.IsNull()) return false;
+
+    BlockMap::const_iterator it = mapBlockIndex.find(hashAssumeValid);
+    if (it != mapBlockIndex.end()) {
+        const CBlockIndex* pindexAssumeValid = it->second;
+        return pindexAssumeValid->GetAncestor(pindex->nHeight) == pindex &&
+               pindexBestHeader && pindexBestHeader->GetAncestor(pindexAssumeValid->nHeight) == pindexAssumeValid;
+    }
+
+    const int nCheckpointHeight = Checkpoints::GetCheckpointHeight(hashAssumeValid);
+    return nCheckpointHeight >= 0 && pindex->nHeight <= nCheckpointHeight;
+}
+
+/**
+ * Write the data of a connected block, whose scripts are valid, that DisconnectBlock doesn't undo:
+ * its undo data, spent serials and txindex entries, and the cleanups done at some heights.
+ */
+static bool WriteConnectedBlock(CValidationState& state, CBlockIndex* pindex, const CBlockUndoBuffer& blockundo,
+                                const std::vector<std::pair<libzerocoin::CoinSpend, uint256> >& vSpends,
+                                const std::vector<std::pair<uint256, CDiskTxPos> >& vPos)
+{
+    AssertLockHeld(cs_main);
+    const Consensus::Params& consensus = Params().GetConsensus();
+
+    // Write undo information to disk
+    if (pindex->GetUndoPos().IsNull() || !pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
+        if (pindex->GetUndoPos().IsNull()) {
+            FlatFilePos diskPosBlock;
+            if (!FindUndoPos(state, pindex->nFile, diskPosBlock, blockundo.size() + 40))
+                return error("ConnectBlock() : FindUndoPos failed");
+            if (!UndoWriteToDisk(blockundo, diskPosBlock, pindex->pprev->GetBlockHash()))
+                return AbortNode(state, "Failed to write undo data");
+
+            // update nUndoPos in block index
+            pindex->nUndoPos = diskPosBlock.nPos;
+            pindex->nStatus |= BLOCK_HAVE_UNDO;
+        }
+
+        pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
+        setDirtyBlockIndex.insert(pindex);
+    }
+    g_recentblocks.AddUndo(pindex->GetBlockHash(), pindex->nHeight, blockundo);
+
+    // Flush spend/mint info to disk
+    if (!vSpends.empty() && !zerocoinDB->WriteCoinSpendBatch(vSpends))
+        return AbortNode(state, "Failed to record coin serials to database");
+
+    if (fTxIndex)
+        if (!pblocktree->WriteTxIndex(vPos))
+            return AbortNode(state, "Failed to write transaction index");
+
+    // After last Checkpoint block, wipe the checksum database
+    if (pindex->nHeight == consensus.height_last_ZC_AccumCheckpoint) {
+        zerocoinDB->WipeAccChecksums();
+    }
+
+    // 100 blocks after the last invalid out, clean the map contents
+    if (pindex->nHeight == consensus.height_last_invalid_UTXO + 100) {
+        invalid_out::setInvalidOutPoints.clear();
+    }
+
+    return true;
+}
+
 static int64_t nTimeVerify = 0;
 static int64_t nTimeProcessSpecial = 0;
 static int64_t nTimeConnect = 0;
@@ -1461,7 +1609,7 @@ static int64_t nTimeTotal = 0;
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
-static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex, CCoinsViewCache& view, bool fJustCheck = false)
+static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex, CCoinsViewCache& view, bool fJustCheck = false, CScriptCheckPipeline* pipeline = nullptr)
 {
     AssertLockHeld(cs_main);
     // Check it again in case a previous version let a bad block in
@@ -1532,7 +1680,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         }
     }
 
-    bool fScriptChecks = pindex->nHeight >= Checkpoints::GetTotalBlocksEstimate();
+    bool fScriptChecks = !IsBlockAssumedValid(pindex);
 
     // If scripts won't be checked anyways, don't bother seeing if CLTV is activated
     bool fCLTVIsActivated = false;
@@ -1540,18 +1688,18 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         fCLTVIsActivated = consensus.NetworkUpgradeActive(pindex->pprev->nHeight, Consensus::UPGRADE_BIP65);
     }
 
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
+    // With a pipeline, the checks are queued on its control, and aren't waited for here
+    CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads && !pipeline ? &scriptcheckqueue : nullptr);
+    CCheckQueueControl<CScriptCheck>& checkControl = pipeline ? pipeline->control : control;
 
     int64_t nTimeStart = GetTimeMicros();
     CAmount nFees = 0;
     int nInputs = 0;
     unsigned int nSigOps = 0;
-    CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
+    const std::vector<unsigned int> vTxOffsets = block.GetTxOffsets();
     std::vector<std::pair<uint256, CDiskTxPos> > vPos;
     std::vector<std::pair<libzerocoin::CoinSpend, uint256> > vSpends;
     vPos.reserve(block.vtx.size());
-    CBlockUndo blockundo;
-    blockundo.vtxundo.reserve(block.vtx.size() - 1);
     CAmount nValueOut = 0;
     CAmount nValueIn = 0;
     unsigned int nMaxBlockSigOps = MAX_BLOCK_SIGOPS_CURRENT;
@@ -1562,8 +1710,39 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     SaplingMerkleTree sapling_tree;
     assert(view.GetSaplingAnchorAt(view.GetBestAnchor(), sapling_tree));
 
-    std::vector<PrecomputedTransactionData> precomTxData;
+    // Load the coins spent by the block into the view in one pass, skipping the
+    // outputs created within the block (added to the view as their txes are connected).
+    size_t nBlockInputs = 0;
+    {
+        std::vector<uint256> vBlockTxids;
+        vBlockTxids.reserve(block.vtx.size());
+        for (const auto& tx : block.vtx) {
+            vBlockTxids.emplace_back(tx->GetHash());
+        }
+        std::sort(vBlockTxids.begin(), vBlockTxids.end());
+        std::vector<COutPoint> vPrevouts;
+        for (const auto& tx : block.vtx) {
+            if (tx->IsCoinBase() || tx->HasZerocoinSpendInputs()) continue;
+            nBlockInputs += tx->vin.size();
+            for (const CTxIn& txin : tx->vin) {
+                if (!std::binary_search(vBlockTxids.begin(), vBlockTxids.end(), txin.prevout.hash)) {
+                    vPrevouts.emplace_back(txin.prevout);
+                }
+            }
+        }
+        view.PrefetchCoins(vPrevouts);
+    }
+
+    // Undo data, serialized as the txes are connected (the pipeline keeps it until it's written)
+    std::unique_ptr<CBlockUndoBuffer> pblockundo = MakeUnique<CBlockUndoBuffer>(block.vtx.size() - 1, nBlockInputs);
+    CBlockUndoBuffer& blockundo = *pblockundo;
+    CTxUndo txundo;
+
+    // The pipeline owns it, as the checks pointing to it may outlive this call
+    std::unique_ptr<std::vector<PrecomputedTransactionData>> pprecomTxData = MakeUnique<std::vector<PrecomputedTransactionData>>();
+    std::vector<PrecomputedTransactionData>& precomTxData = *pprecomTxData;
     precomTxData.reserve(block.vtx.size()); // Required so that pointers to individual precomTxData don't get invalidated
+    if (pipeline) pipeline->vPrecomTxData.emplace_back(std::move(pprecomTxData));
     bool fInitialBlockDownload = IsInitialBlockDownload();
     bool fZerocoinMaintenance =  (block.nTime > sporkManager.GetSporkValue(SPORK_16_ZEROCOIN_MAINTENANCE_MODE));
     bool fSaplingMaintenance =  (block.nTime > sporkManager.GetSporkValue(SPORK_20_SAPLING_MAINTENANCE));
@@ -1614,14 +1793,14 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                     nValueIn += publicSpend.getDenomination() * COIN;
                     //queue for db write after the 'justcheck' section has concluded
                     vSpends.emplace_back(publicSpend, tx.GetHash());
-                    if (!ContextualCheckZerocoinSpend(tx, &publicSpend, pindex->nHeight, hashBlock))
+                    if (!ContextualCheckZerocoinSpend(tx, &publicSpend, pindex->nHeight, hashBlock, fScriptChecks))
                         return state.DoS(100, error("%s: failed to add block %s with invalid public zc spend", __func__, tx.GetHash().GetHex()), REJECT_INVALID);
                 } else {
                     libzerocoin::CoinSpend spend = TxInToZerocoinSpend(txIn);
                     nValueIn += spend.getDenomination() * COIN;
                     //queue for db write after the 'justcheck' section has concluded
                     vSpends.emplace_back(spend, tx.GetHash());
-                    if (!ContextualCheckZerocoinSpend(tx, &spend, pindex->nHeight, hashBlock))
+                    if (!ContextualCheckZerocoinSpend(tx, &spend, pindex->nHeight, hashBlock, fScriptChecks))
                         return state.DoS(100, error("%s: failed to add block %s with invalid zerocoinspend", __func__, tx.GetHash().GetHex()), REJECT_INVALID);
                 }
             }
@@ -1648,9 +1827,10 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         precomTxData.emplace_back(tx);
 
         if (!tx.IsCoinBase()) {
+            const CAmount nTxValueIn = view.GetValueIn(tx);
             if (!tx.IsCoinStake())
-                nFees += view.GetValueIn(tx) - tx.GetValueOut();
-            nValueIn += view.GetValueIn(tx);
+                nFees += nTxValueIn - tx.GetValueOut();
+            nValueIn += nTxValueIn;
 
             std::vector<CScriptCheck> vChecks;
             unsigned int flags = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_DERSIG;
@@ -1660,16 +1840,16 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
             if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, precomTxData[i], nScriptCheckThreads ? &vChecks : NULL))
                 return error("%s: Check inputs on %s failed with %s", __func__, tx.GetHash().ToString(), FormatStateMessage(state));
-            control.Add(vChecks);
+            checkControl.Add(vChecks);
         }
         nValueOut += tx.GetValueOut();
 
-        CTxUndo undoDummy;
+        const bool fSkipInvalid = SkipInvalidUTXOS(pindex->nHeight);
+        txundo.vprevout.clear();
+        UpdateCoins(tx, view, txundo, pindex->nHeight, fSkipInvalid);
         if (i > 0) {
-            blockundo.vtxundo.emplace_back();
+            blockundo.Add(txundo);
         }
-        const bool fSkipInvalid = SkipInvalidUTXOS(pindex->nHeight);
-        UpdateCoins(tx, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight, fSkipInvalid);
 
         // Sapling update tree
         if (tx.IsShieldedTx() && !tx.sapData->vShieldedOutput.empty()) {
@@ -1678,8 +1858,17 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             }
         }
 
-        vPos.emplace_back(tx.GetHash(), pos);
-        pos.nTxOffset += ::GetSerializeSize(tx, SER_DISK, CLIENT_VERSION);
+        vPos.emplace_back(tx.GetHash(), CDiskTxPos(pindex->GetBlockPos(), vTxOffsets[i]));
+    }
+
+    // The serials spent in the previous blocks of a pipelined batch aren't in the zerocoin DB yet
+    if (pipeline) {
+        for (const auto& spend : vSpends) {
+            const auto it = pipeline->mapSpentSerials.find(spend.first.getCoinSerialNumber());
+            if (it != pipeline->mapSpentSerials.end())
+                return state.DoS(100, error("%s: zPIV spend with serial %s is already in block %d", __func__,
+                                            it->first.GetHex(), it->second), REJECT_INVALID);
+        }
     }
 
     // Push new tree anchor
@@ -1731,7 +1920,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         return false;
     }
 
-    if (!control.Wait())
+    if (!pipeline && !control.Wait())
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
     int64_t nTime2 = GetTimeMicros();
     nTimeVerify += nTime2 - nTimeStart;
@@ -1748,32 +1937,16 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     if (fJustCheck)
         return true;
 
-    // Write undo information to disk
-    if (pindex->GetUndoPos().IsNull() || !pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
-        if (pindex->GetUndoPos().IsNull()) {
-            FlatFilePos diskPosBlock;
-            if (!FindUndoPos(state, pindex->nFile, diskPosBlock, ::GetSerializeSize(blockundo, SER_DISK, CLIENT_VERSION) + 40))
-                return error("ConnectBlock() : FindUndoPos failed");
-            if (!UndoWriteToDisk(blockundo, diskPosBlock, pindex->pprev->GetBlockHash()))
-                return AbortNode(state, "Failed to write undo data");
-
-            // update nUndoPos in block index
-            pindex->nUndoPos = diskPosBlock.nPos;
-            pindex->nStatus |= BLOCK_HAVE_UNDO;
+    // With pipelined checks, the scripts are known to be valid (and the writes done) only once the batch is verified
+    if (pipeline) {
+        for (const auto& spend : vSpends) {
+            pipeline->mapSpentSerials.emplace(spend.first.getCoinSerialNumber(), pindex->nHeight);
         }
-
-        pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
-        setDirtyBlockIndex.insert(pindex);
+        pipeline->vPendingWrites.push_back({pindex, std::move(pblockundo), std::move(vSpends), std::move(vPos)});
+    } else if (!WriteConnectedBlock(state, pindex, blockundo, vSpends, vPos)) {
+        return false;
     }
 
-    // Flush spend/mint info to disk
-    if (!vSpends.empty() && !zerocoinDB->WriteCoinSpendBatch(vSpends))
-        return AbortNode(state, "Failed to record coin serials to database");
-
-    if (fTxIndex)
-        if (!pblocktree->WriteTxIndex(vPos))
-            return AbortNode(state, "Failed to write transaction index");
-
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
     evoDb->WriteBestBlock(pindex->GetBlockHash());
@@ -1786,14 +1959,6 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             pindex->nHeight < consensus.height_last_ZC_AccumCheckpoint) {
         // Legacy Zerocoin DB: If Accumulators Checkpoint is changed, database the checksums
         DataBaseAccChecksum(pindex, true);
-    } else if (pindex->nHeight == consensus.height_last_ZC_AccumCheckpoint) {
-        // After last Checkpoint block, wipe the checksum database
-        zerocoinDB->WipeAccChecksums();
-    }
-
-    // 100 blocks after the last invalid out, clean the map contents
-    if (pindex->nHeight == consensus.height_last_invalid_UTXO + 100) {
-        invalid_out::setInvalidOutPoints.clear();
     }
 
     return true;
@@ -1881,7 +2046,14 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode)
                 return AbortNode(state, "Disk space is low!", _("Error: Disk space is low!"));
             }
             // Flush the chainstate (which may refer to block index entries).
-            if (!pcoinsTip->Flush())
+            // Unless shutting down or explicitly asked to, keep the hot part of the coins cache:
+            // when it got too large only the coldest entries are evicted, otherwise none.
+            const bool fFlushed = mode == FLUSH_STATE_ALWAYS ? pcoinsTip->Flush() :
+                                  pcoinsTip->Sync(fCacheLarge || fCacheCritical ?
+                                                  nCoinCacheUsage / 100 * COINS_CACHE_RETAIN_PERCENT :
+                                                  std::numeric_limits<size_t>::max(),
+                                                  nCoinCacheUsage / 100 * COINS_CACHE_SYNC_COPY_PERCENT);
+            if (!fFlushed)
                 return AbortNode(state, "Failed to write to coin database");
             if (!evoDb->CommitRootTransaction()) {
                 return AbortNode(state, "Failed to commit EvoDB");
@@ -1967,18 +2139,22 @@ void static UpdateTip(CBlockIndex* pindexNew)
   * If disconnectpool is NULL, then no disconnected transactions are added to
   * disconnectpool (note that the caller is responsible for mempool consistency
   * in any case).
+  *
+  * pblockUndoUnverified is set when rolling back a batch of blocks whose script checks failed:
+  * it's the undo data of the tip, never written. The connection of the tip was neither written
+  * to disk nor notified, and so isn't its disconnection.
   */
-bool static DisconnectTip(CValidationState& state, const CChainParams& chainparams, DisconnectedBlockTransactions *disconnectpool)
+bool static DisconnectTip(CValidationState& state, const CChainParams& chainparams, DisconnectedBlockTransactions *disconnectpool, const CBlockUndoBuffer* pblockUndoUnverified = nullptr)
 {
     AssertLockHeld(cs_main);
     AssertLockHeld(mempool.cs);
     CBlockIndex* pindexDelete = chainActive.Tip();
     assert(pindexDelete);
-    // Read block from disk.
-    std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-    CBlock& block = *pblock;
-    if (!ReadBlockFromDisk(block, pindexDelete))
+    // Read block from the recent blocks cache, or from disk.
+    std::shared_ptr<const CBlock> pblock = ReadRecentBlock(pindexDelete);
+    if (!pblock)
         return error("%s: Failed to read block", __func__);
+    const CBlock& block = *pblock;
     // Apply the block atomically to the chain state.
     const uint256& saplingAnchorBeforeDisconnect = pcoinsTip->GetBestAnchor();
     int64_t nStart = GetTimeMicros();
@@ -1987,7 +2163,7 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
 
         CCoinsViewCache view(pcoinsTip);
         assert(view.GetBestBlock() == pindexDelete->GetBlockHash());
-        if (DisconnectBlock(block, pindexDelete, view) != DISCONNECT_OK)
+        if (DisconnectBlock(block, pindexDelete, view, pblockUndoUnverified) != DISCONNECT_OK)
             return error("DisconnectTip() : DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         bool flushed = view.Flush();
         assert(flushed);
@@ -1996,7 +2172,7 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
     LogPrint(BCLog::BENCH, "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
     const uint256& saplingAnchorAfterDisconnect = pcoinsTip->GetBestAnchor();
     // Write the chain state to disk, if necessary.
-    if (!FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED))
+    if (!pblockUndoUnverified && !FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED))
         return false;
     if (disconnectpool) {
         // Save transactions to re-add to mempool at end of reorg
@@ -2018,6 +2194,7 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
     } else {
         mnodeman.UncacheBlockHash(pindexDelete);
     }
+    g_collateralWatchSet.BlockDisconnected(block, pindexDelete->nHeight);
     // Evict from mempool if the anchor changes
     if (saplingAnchorBeforeDisconnect != saplingAnchorAfterDisconnect) {
         // The anchor may not change between block disconnects,
@@ -2028,7 +2205,9 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
     UpdateTip(pindexDelete->pprev);
     // Let wallets know transactions went from 1-confirmed to
     // 0-confirmed or conflicted:
-    GetMainSignals().BlockDisconnected(pblock, pindexDelete->GetBlockHash(), pindexDelete->nHeight, pindexDelete->GetBlockTime());
+    if (!pblockUndoUnverified) {
+        GetMainSignals().BlockDisconnected(pblock, pindexDelete->GetBlockHash(), pindexDelete->nHeight, pindexDelete->GetBlockTime());
+    }
 
     return true;
 }
@@ -2039,6 +2218,23 @@ static int64_t nTimeFlush = 0;
 static int64_t nTimeChainState = 0;
 static int64_t nTimePostConnect = 0;
 
+BlockConnectTimings GetBlockConnectTimings()
+{
+    LOCK(cs_main);
+    BlockConnectTimings timings;
+    timings.nTimeReadFromDisk = nTimeReadFromDisk;
+    timings.nTimeConnect = nTimeConnect;
+    timings.nTimeVerify = nTimeVerify;
+    timings.nTimeProcessSpecial = nTimeProcessSpecial;
+    timings.nTimeIndex = nTimeIndex;
+    timings.nTimeConnectTotal = nTimeConnectTotal;
+    timings.nTimeFlush = nTimeFlush;
+    timings.nTimeChainState = nTimeChainState;
+    timings.nTimePostConnect = nTimePostConnect;
+    timings.nTimeTotal = nTimeTotal;
+    return timings;
+}
+
 struct PerBlockConnectTrace {
     CBlockIndex* pindex = nullptr;
     std::shared_ptr<const CBlock> pblock;
@@ -2067,6 +2263,17 @@ public:
         blocksConnected.emplace_back();
     }
 
+    size_t Size() const {
+        return blocksConnected.size() - 1;
+    }
+
+    //! Forget the blocks connected after the first nBlocks (rolled back before being notified)
+    void Truncate(size_t nBlocks) {
+        assert(nBlocks <= Size());
+        blocksConnected.resize(nBlocks);
+        blocksConnected.emplace_back();
+    }
+
     std::vector<PerBlockConnectTrace>& GetBlocksConnected() {
         // We always keep one extra block at the end of our list because
         // blocks are added after all the conflicted transactions have
@@ -2084,25 +2291,22 @@ public:
  * corresponding to pindexNew, to bypass loading it again from disk.
  *
  * The block is added to connectTrace if connection succeeds.
+ * With a pipeline, the block's script checks are added to it, and the block is neither
+ * reported as checked nor written to disk until they are verified.
  */
-bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions &disconnectpool)
+bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions &disconnectpool, CScriptCheckPipeline* pipeline = nullptr)
 {
     AssertLockHeld(cs_main);
     AssertLockHeld(mempool.cs);
     assert(pindexNew->pprev == chainActive.Tip());
 
-    // Read block from disk.
+    // Read block from the recent blocks cache, or from disk.
     int64_t nTime1 = GetTimeMicros();
-    std::shared_ptr<const CBlock> pthisBlock;
-    if (!pblock) {
-        std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
-        if (!ReadBlockFromDisk(*pblockNew, pindexNew))
-            return AbortNode(state, "Failed to read block");
-        pthisBlock = pblockNew;
-    } else {
-        pthisBlock = pblock;
-    }
+    std::shared_ptr<const CBlock> pthisBlock = pblock ? pblock : ReadRecentBlock(pindexNew);
+    if (!pthisBlock)
+        return AbortNode(state, "Failed to read block");
     const CBlock& blockConnecting = *pthisBlock;
+    if (pipeline) pipeline->vBlockRefs.emplace_back(pthisBlock);
 
     // Apply the block atomically to the chain state.
     int64_t nTime2 = GetTimeMicros();
@@ -2113,8 +2317,10 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, const st
         auto dbTx = evoDb->BeginTransaction();
 
         CCoinsViewCache view(pcoinsTip);
-        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, false);
-        GetMainSignals().BlockChecked(blockConnecting, state);
+        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, false, pipeline);
+        if (!pipeline || !rv) {
+            GetMainSignals().BlockChecked(blockConnecting, state);
+        }
         if (!rv) {
             if (state.IsInvalid())
                 InvalidBlockFound(pindexNew, state);
@@ -2127,6 +2333,8 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, const st
         assert(flushed);
         dbTx->Commit();
     }
+    // Keep the block at hand, in case it's disconnected by a reorg
+    g_recentblocks.AddBlock(pindexNew->GetBlockHash(), pindexNew->nHeight, pthisBlock);
     int64_t nTime4 = GetTimeMicros();
     nTimeFlush += nTime4 - nTime3;
     LogPrint(BCLog::BENCH, "  - Flush: %.2fms [%.2fs]\n", (nTime4 - nTime3) * 0.001, nTimeFlush * 0.000001);
@@ -2135,20 +2343,26 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, const st
     FlushStateMode flushMode = FLUSH_STATE_IF_NEEDED;
     if (pindexNew->pprev && (pindexNew->GetBlockPos().nFile != pindexNew->pprev->GetBlockPos().nFile))
         flushMode = FLUSH_STATE_ALWAYS;
-    if (!FlushStateToDisk(state, flushMode))
+    if (pipeline) {
+        pipeline->fFlushAlways |= flushMode == FLUSH_STATE_ALWAYS;
+    } else if (!FlushStateToDisk(state, flushMode)) {
         return false;
+    }
     int64_t nTime5 = GetTimeMicros();
     nTimeChainState += nTime5 - nTime4;
     LogPrint(BCLog::BENCH, "  - Writing chainstate: %.2fms [%.2fs]\n", (nTime5 - nTime4) * 0.001, nTimeChainState * 0.000001);
 
-    // Remove conflicting transactions from the mempool.
-    mempool.removeForBlock(blockConnecting.vtx, pindexNew->nHeight, !IsInitialBlockDownload());
-    disconnectpool.removeForBlock(blockConnecting.vtx);
+    // Remove conflicting transactions from the mempool (with a pipeline, once the batch is verified).
+    if (!pipeline) {
+        mempool.removeForBlock(blockConnecting.vtx, pindexNew->nHeight, !IsInitialBlockDownload());
+        disconnectpool.removeForBlock(blockConnecting.vtx);
+    }
     // Update chainActive & related variables.
     UpdateTip(pindexNew);
     // Update MN manager cache
     mnodeman.CacheBlockHash(pindexNew);
-    mnodeman.CheckSpentCollaterals(blockConnecting.vtx);
+    // Update the masternode collaterals index
+    mnodeman.CheckSpentCollaterals(g_collateralWatchSet.BlockConnected(blockConnecting, pindexNew->nHeight));
 
     int64_t nTime6 = GetTimeMicros();
     nTimePostConnect += nTime6 - nTime5;
@@ -2156,10 +2370,65 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, const st
     LogPrint(BCLog::BENCH, "  - Connect postprocess: %.2fms [%.2fs]\n", (nTime6 - nTime5) * 0.001, nTimePostConnect * 0.000001);
     LogPrint(BCLog::BENCH, "- Connect block: %.2fms [%.2fs]\n", (nTime6 - nTime1) * 0.001, nTimeTotal * 0.000001);
 
+    if (pipeline) pipeline->vConnected.emplace_back(pindexNew);
     connectTrace.BlockConnected(pindexNew, std::move(pthisBlock));
     return true;
 }
 
+/**
+ * Wait for the script checks of a pipelined batch. If they passed, the blocks are fully
+ * validated: do their pending writes, update the mempool, report them as checked, and write
+ * the chain state to disk if needed. Otherwise disconnect the batch (fRolledBack), leaving
+ * the txindex, the zerocoin DB and the mempool untouched, so that its blocks are connected
+ * again without pipelining. Returns false on system errors.
+ */
+static bool FinishScriptCheckPipeline(CValidationState& state, std::unique_ptr<CScriptCheckPipeline>& pipeline, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool, bool& fRolledBack)
+{
+    AssertLockHeld(cs_main);
+    fRolledBack = false;
+    if (!pipeline) return true;
+    std::unique_ptr<CScriptCheckPipeline> batch = std::move(pipeline);
+
+    int64_t nTimeStart = GetTimeMicros();
+    const bool fChecksOk = batch->control.Wait();
+    LogPrint(BCLog::BENCH, "  - Verify pipelined checks of %u blocks: %.2fms\n", (unsigned)batch->vBlockRefs.size(), (GetTimeMicros() - nTimeStart) * 0.001);
+    if (fChecksOk) {
+        const CValidationState stateValid;
+        for (size_t i = 0; i < batch->vConnected.size(); i++) {
+            const CConnectedBlockWrites& writes = batch->vPendingWrites[i];
+            if (!WriteConnectedBlock(state, writes.pindex, *writes.pblockundo, writes.vSpends, writes.vPos)) {
+                return false;
+            }
+            const std::vector<CTransactionRef>& vtx = batch->vBlockRefs[i]->vtx;
+            mempool.removeForBlock(vtx, writes.pindex->nHeight, !IsInitialBlockDownload());
+            disconnectpool.removeForBlock(vtx);
+            GetMainSignals().BlockChecked(*batch->vBlockRefs[i], stateValid);
+        }
+        return batch->vConnected.empty() ||
+               FlushStateToDisk(state, batch->fFlushAlways ? FLUSH_STATE_ALWAYS : FLUSH_STATE_IF_NEEDED);
+    }
+
+    nSerialConnectHeight = batch->pindexStart->nHeight + batch->vBlockRefs.size();
+    LogPrintf("%s: script checks failed in blocks %d to %d, connecting them again one by one\n",
+              __func__, batch->pindexStart->nHeight + 1, nSerialConnectHeight);
+    // The txes of the batch aren't put back in the mempool: it was left as it was before the batch
+    for (auto it = batch->vPendingWrites.rbegin(); it != batch->vPendingWrites.rend(); ++it) {
+        assert(chainActive.Tip() == it->pindex);
+        if (!DisconnectTip(state, Params(), nullptr, it->pblockundo.get())) {
+            return AbortNode(state, "Failed to disconnect block; see debug.log for details");
+        }
+    }
+    assert(chainActive.Tip() == batch->pindexStart);
+    // The blocks of the batch were pruned from the candidates, as the tip moved past them
+    setBlockIndexCandidates.insert(batch->pindexStart);
+    for (CBlockIndex* pindex : batch->vConnected) {
+        setBlockIndexCandidates.insert(pindex);
+    }
+    connectTrace.Truncate(batch->nTraceStart);
+    fRolledBack = true;
+    return true;
+}
+
 /**
  * Return the tip of the chain with the most work in it, that isn't
  * known to be invalid (it's however far from certain to be valid).
@@ -2264,6 +2533,12 @@ static bool ActivateBestChainStep(CValidationState& state, CBlockIndex* pindexMo
     std::vector<CBlockIndex*> vpindexToConnect;
     bool fContinue = true;
     int nHeight = pindexFork ? pindexFork->nHeight : -1;
+
+    // During IBD, let the script checks of each block overlap with the connection of the next ones
+    std::unique_ptr<CScriptCheckPipeline> pipeline;
+    if (nScriptCheckThreads && nHeight >= nSerialConnectHeight && pindexMostWork->nHeight > nHeight + 1 && IsInitialBlockDownload()) {
+        pipeline = MakeUnique<CScriptCheckPipeline>(chainActive.Tip(), connectTrace.Size());
+    }
     while (fContinue && nHeight != pindexMostWork->nHeight) {
         // Don't iterate the entire list of potential improvements toward the best tip, as we likely only need
         // a few blocks along the way.
@@ -2279,7 +2554,16 @@ static bool ActivateBestChainStep(CValidationState& state, CBlockIndex* pindexMo
 
         // Connect new blocks.
         for (CBlockIndex* pindexConnect : reverse_iterate(vpindexToConnect)) {
-            if (!ConnectTip(state, pindexConnect, (pindexConnect == pindexMostWork) ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
+            if (!ConnectTip(state, pindexConnect, (pindexConnect == pindexMostWork) ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool, pipeline.get())) {
+                // The blocks connected before this one must be verified first
+                bool fRolledBack = false;
+                CValidationState statePipeline;
+                if (!FinishScriptCheckPipeline(statePipeline, pipeline, connectTrace, disconnectpool, fRolledBack)) {
+                    state = statePipeline;
+                    UpdateMempoolForReorg(disconnectpool, false);
+                    return false;
+                }
+                fBlocksDisconnected |= fRolledBack;
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
                     if (!state.CorruptionPossible()) {
@@ -2299,14 +2583,26 @@ static bool ActivateBestChainStep(CValidationState& state, CBlockIndex* pindexMo
             } else {
                 PruneBlockIndexCandidates();
                 if (!pindexOldTip || chainActive.Tip()->nChainWork > pindexOldTip->nChainWork) {
-                    // We're in a better position than we were. Return temporarily to release the lock.
+                    // We're in a better position than we were. Return temporarily to release the lock,
+                    // unless more blocks can be connected while the scripts of this one are verified.
                     fContinue = false;
+                    if (pipeline && pipeline->vConnected.size() < MAX_SCRIPT_CHECK_PIPELINE_BLOCKS) {
+                        continue;
+                    }
                     break;
                 }
             }
         }
     }
 
+    // The connected blocks are fully validated only once their scripts are
+    bool fRolledBack = false;
+    if (!FinishScriptCheckPipeline(state, pipeline, connectTrace, disconnectpool, fRolledBack)) {
+        UpdateMempoolForReorg(disconnectpool, false);
+        return false;
+    }
+    fBlocksDisconnected |= fRolledBack;
+
     if (fBlocksDisconnected) {
         // If any blocks were disconnected, disconnectpool may be non empty.  Add
         // any disconnected transactions back to the mempool.
@@ -2428,6 +2724,8 @@ bool ActivateBestChain(CValidationState& state, std::shared_ptr<const CBlock> pb
 bool InvalidateBlock(CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindex)
 {
     AssertLockHeld(cs_main);
+    // The blocks to connect from now on may no longer include a batch whose checks failed
+    nSerialConnectHeight = -1;
     // Mark the block itself as invalid.
     pindex->nStatus |= BLOCK_FAILED_VALID;
     setDirtyBlockIndex.insert(pindex);
@@ -2471,6 +2769,8 @@ bool InvalidateBlock(CValidationState& state, const CChainParams& chainparams, C
 bool ReconsiderBlock(CValidationState& state, CBlockIndex* pindex)
 {
     AssertLockHeld(cs_main);
+    // The blocks reconsidered may be part of a batch whose checks failed: pipeline them again
+    nSerialConnectHeight = -1;
 
     int nHeight = pindex->nHeight;
 
@@ -3018,7 +3318,7 @@ bool IsTransactionInChain(const uint256& txId, int& nHeightTx)
     return IsTransactionInChain(txId, nHeightTx, tx);
 }
 
-bool ContextualCheckBlock(const CBlock& block, CValidationState& state, CBlockIndex* const pindexPrev)
+bool ContextualCheckBlock(const CBlock& block, CValidationState& state, CBlockIndex* const pindexPrev, bool fCheckProofs)
 {
     const int nHeight = pindexPrev == nullptr ? 0 : pindexPrev->nHeight + 1;
     const CChainParams& chainparams = Params();
@@ -3027,7 +3327,7 @@ bool ContextualCheckBlock(const CBlock& block, CValidationState& state, CBlockIn
     for (const auto& tx : block.vtx) {
 
         // Check transaction contextually against consensus rules at block height
-        if (!ContextualCheckTransaction(tx, state, chainparams, nHeight, true /* isMined */, IsInitialBlockDownload())) {
+        if (!ContextualCheckTransaction(tx, state, chainparams, nHeight, true /* isMined */, IsInitialBlockDownload(), fCheckProofs)) {
             return false;
         }
 
@@ -3150,7 +3450,7 @@ static bool AcceptBlock(const CBlock& block, CValidationState& state, CBlockInde
         return true;
     }
 
-    if (!CheckBlock(block, state) || !ContextualCheckBlock(block, state, pindex->pprev)) {
+    if (!CheckBlock(block, state) || !ContextualCheckBlock(block, state, pindex->pprev, !IsBlockAssumedValid(pindex))) {
         if (state.IsInvalid() && !state.CorruptionPossible()) {
             pindex->nStatus |= BLOCK_FAILED_VALID;
             setDirtyBlockIndex.insert(pindex);
@@ -3241,8 +3541,8 @@ static bool AcceptBlock(const CBlock& block, CValidationState& state, CBlockInde
             // Start at the block we're adding on to
             CBlockIndex *prev = pindexPrev;
 
-            CBlock bl;
-            if (!ReadBlockFromDisk(bl, prev))
+            std::shared_ptr<const CBlock> pbl = ReadRecentBlock(prev);
+            if (!pbl)
                 return error("%s: previous block %s not on disk", __func__, prev->GetBlockHash().GetHex());
 
             std::vector<CBigNum> vBlockSerials;
@@ -3259,7 +3559,7 @@ static bool AcceptBlock(const CBlock& block, CValidationState& state, CBlockInde
                 }
 
                 // Loop through every tx of this block
-                for (const auto& txIn : bl.vtx) {
+                for (const auto& txIn : pbl->vtx) {
                     const CTransaction& t = *txIn;
                     // Loop through every input of this tx
                     for (const CTxIn& in: t.vin) {
@@ -3280,7 +3580,8 @@ static bool AcceptBlock(const CBlock& block, CValidationState& state, CBlockInde
 
                 // Prev block
                 prev = prev->pprev;
-                if (!ReadBlockFromDisk(bl, prev))
+                pbl = ReadRecentBlock(prev);
+                if (!pbl)
                     // Previous block not on disk
                     return error("%s: previous block %s not on disk", __func__, prev->GetBlockHash().GetHex());
 
@@ -3387,6 +3688,12 @@ bool ProcessNewBlock(CValidationState& state, const std::shared_ptr<const CBlock
             return error("%s : AcceptBlock FAILED", __func__);
         }
         newHeight = pindex->nHeight;
+        // Keep the side-chain blocks at hand, in case they are connected by a reorg. Not the blocks
+        // received out of order during the initial sync: they would push the tip's blocks out.
+        if (pindex->pprev && pindex->pprev != chainActive.Tip() &&
+            !IsInitialBlockDownload() && pindex->nHeight <= chainActive.Height() + 1) {
+            g_recentblocks.AddBlock(pindex->GetBlockHash(), pindex->nHeight, pblock);
+        }
     }
 
     if (!ActivateBestChain(state, pblock))
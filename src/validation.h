@@ -105,6 +105,12 @@ static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
 static const unsigned int DATABASE_WRITE_INTERVAL = 60 * 60;
 /** Time to wait (in seconds) between flushing chainstate to disk. */
 static const unsigned int DATABASE_FLUSH_INTERVAL = 24 * 60 * 60;
+/** Maximum number of blocks connected during IBD while the script checks of the first ones are still running */
+static const unsigned int MAX_SCRIPT_CHECK_PIPELINE_BLOCKS = 16;
+/** Share of -dbcache (in percent) still used by the coins cache after it's flushed for being too large */
+static const unsigned int COINS_CACHE_RETAIN_PERCENT = 50;
+/** Share of -dbcache (in percent) that the copies of the dirty coins staying cached can use while the coins cache is written */
+static const unsigned int COINS_CACHE_SYNC_COPY_PERCENT = 10;
 /** Maximum length of reject messages. */
 static const unsigned int MAX_REJECT_MESSAGE_LENGTH = 111;
 /** Average delay between local address broadcasts in seconds. */
@@ -148,6 +154,10 @@ extern bool fCheckBlockIndex;
 extern size_t nCoinCacheUsage;
 extern CFeeRate minRelayTxFee;
 extern int64_t nMaxTipAge;
+/** Block hash whose ancestors we will assume to have valid signatures and proofs, without checking them. */
+extern uint256 hashAssumeValid;
+/** Whether the block is the hashAssumeValid block or one of its ancestors (on the best header chain) */
+bool IsBlockAssumedValid(const CBlockIndex* pindex);
 
 extern bool fLargeWorkForkFound;
 extern bool fLargeWorkInvalidChainFound;
@@ -195,6 +205,22 @@ int ActiveProtocol();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
 
+/** Cumulative block connection timings (in microseconds), as reported by the BCLog::BENCH log lines */
+struct BlockConnectTimings {
+    int64_t nTimeReadFromDisk{0};
+    int64_t nTimeConnect{0};
+    int64_t nTimeVerify{0};
+    int64_t nTimeProcessSpecial{0};
+    int64_t nTimeIndex{0};
+    int64_t nTimeConnectTotal{0};
+    int64_t nTimeFlush{0};
+    int64_t nTimeChainState{0};
+    int64_t nTimePostConnect{0};
+    int64_t nTimeTotal{0};
+};
+/** Snapshot of the ConnectBlock/ConnectTip phase counters accumulated since startup */
+BlockConnectTimings GetBlockConnectTimings();
+
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -331,7 +357,7 @@ bool CheckWork(const CBlock& block, const CBlockIndex* const pindexPrev);
 
 /** Context-dependent validity checks */
 bool ContextualCheckBlockHeader(const CBlockHeader& block, CValidationState& state, CBlockIndex* pindexPrev);
-bool ContextualCheckBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindexPrev);
+bool ContextualCheckBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindexPrev, bool fCheckProofs = true);
 
 /** Check a block is completely valid from start to finish (only works on top of our current best block, with cs_main held) */
 bool TestBlockValidity(CValidationState& state, const CBlock& block, CBlockIndex* pindexPrev, bool fCheckPOW = true, bool fCheckMerkleRoot = true, bool fCheckBlockSig = true);
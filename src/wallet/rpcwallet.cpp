@@ -4387,6 +4387,87 @@ UniValue getstakingstatus(const JSONRPCRequest& request)
     }
 }
 
+static UniValue StakingRewardsToJSON(const CStakingRewards& rewards)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("stake", ValueFromAmount(rewards.nStake));
+    obj.pushKV("zpivstake", ValueFromAmount(rewards.nZpivStake));
+    obj.pushKV("delegated", ValueFromAmount(rewards.nDelegated));
+    obj.pushKV("masternode", ValueFromAmount(rewards.nMasternode));
+    obj.pushKV("generated", ValueFromAmount(rewards.nGenerated));
+    obj.pushKV("total", ValueFromAmount(rewards.GetTotal()));
+    obj.pushKV("count", rewards.nCount);
+    return obj;
+}
+
+UniValue getstakingrewards(const JSONRPCRequest& request)
+{
+    CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
+
+    if (!EnsureWalletIsAvailable(pwallet, request.fHelp))
+        return NullUniValue;
+
+    if (request.fHelp || request.params.size() > 2)
+        throw std::runtime_error(
+            "getstakingrewards ( from to )\n"
+            "\nReturns the staking rewards received by the wallet, per day (UTC), between two times.\n"
+            "Only the confirmed coinstakes and coinbases are counted.\n"
+
+            "\nArguments:\n"
+            "1. from    (numeric, optional, default=0) UNIX epoch time of the first day to include\n"
+            "2. to      (numeric, optional, default=now) UNIX epoch time of the last day to include\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"days\": [                 (array of json objects) days with rewards, oldest first\n"
+            "    {\n"
+            "      \"date\": \"yyyy-mm-dd\",  (string) the day\n"
+            "      \"time\": n,              (numeric) UNIX epoch time of the start of the day\n"
+            "      \"stake\": x.xxx,         (numeric) rewards of the PIV coinstakes of this wallet, in " + CURRENCY_UNIT + "\n"
+            "      \"zpivstake\": x.xxx,     (numeric) rewards of the zPIV coinstakes of this wallet\n"
+            "      \"delegated\": x.xxx,     (numeric) rewards of the coins delegated by this wallet (cold staking)\n"
+            "      \"masternode\": x.xxx,    (numeric) masternode rewards\n"
+            "      \"generated\": x.xxx,     (numeric) rewards of the blocks mined (PoW)\n"
+            "      \"total\": x.xxx,         (numeric) sum of the rewards\n"
+            "      \"count\": n              (numeric) number of coinstakes and coinbases paying the rewards\n"
+            "    }\n"
+            "    ,...\n"
+            "  ],\n"
+            "  \"total\": {...}             (json object) sum of the days, same fields as the day objects (without date and time)\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getstakingrewards", "") + HelpExampleCli("getstakingrewards", "1609459200 1612137599") +
+            HelpExampleRpc("getstakingrewards", "1609459200, 1612137599"));
+
+    const int64_t nTimeFrom = request.params.size() > 0 ? request.params[0].get_int64() : 0;
+    const int64_t nTimeTo = request.params.size() > 1 ? request.params[1].get_int64() : GetTime();
+    if (nTimeFrom < 0 || nTimeTo < nTimeFrom)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid time range");
+
+    // Sum the rewards into the days (UTC) of the range
+    const int64_t nDayFrom = nTimeFrom - nTimeFrom % 86400;
+    const int64_t nDayTo = nTimeTo - nTimeTo % 86400 + 86399;
+    std::map<int64_t, CStakingRewards> mapDays;
+    CStakingRewards total;
+    for (const auto& it : pwallet->GetStakingRewards(nDayFrom, nDayTo)) {
+        mapDays[it.first - it.first % 86400] += it.second;
+        total += it.second;
+    }
+    UniValue days(UniValue::VARR);
+    for (const auto& it : mapDays) {
+        UniValue day(UniValue::VOBJ);
+        day.pushKV("date", FormatISO8601Date(it.first));
+        day.pushKV("time", it.first);
+        day.pushKVs(StakingRewardsToJSON(it.second));
+        days.push_back(day);
+    }
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("days", days);
+    ret.pushKV("total", StakingRewardsToJSON(total));
+    return ret;
+}
+
 UniValue setstakesplitthreshold(const JSONRPCRequest& request)
 {
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
@@ -4744,6 +4825,7 @@ static const CRPCCommand commands[] =
     { "wallet",             "getunconfirmedbalance",    &getunconfirmedbalance,    false, {} },
     { "wallet",             "getwalletinfo",            &getwalletinfo,            false, {} },
     { "wallet",             "getstakingstatus",         &getstakingstatus,         false, {} },
+    { "wallet",             "getstakingrewards",        &getstakingrewards,        false, {"from","to"} },
     { "wallet",             "importprivkey",            &importprivkey,            true,  {"privkey","label","rescan","is_staking_address"} },
     { "wallet",             "importwallet",             &importwallet,             true,  {"filename"} },
     { "wallet",             "importaddress",            &importaddress,            true,  {"address","label","rescan","p2sh"} },
@@ -7,6 +7,32 @@
 #include "crypter.h"
 #include "script/standard.h"
 
+#include <atomic>
+#include <thread>
+
+//! Minimum number of keys derived by each worker thread of ParallelDeriveKeys
+static const size_t MIN_KEYS_PER_DERIVATION_THREAD = 16;
+
+void ParallelDeriveKeys(size_t count, const std::function<void(size_t)>& func)
+{
+    const size_t nThreads = std::min((size_t) std::max(GetNumCores(), 1),
+                                     (count + MIN_KEYS_PER_DERIVATION_THREAD - 1) / MIN_KEYS_PER_DERIVATION_THREAD);
+    std::atomic<size_t> nNext{0};
+    auto worker = [&nNext, count, &func]() {
+        for (size_t i = nNext++; i < count; i = nNext++) {
+            func(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nThreads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
 bool ScriptPubKeyMan::SetupGeneration(bool newKeypool, bool force, bool memOnly)
 {
     if (CanGenerateKeys() && !force) {
@@ -412,12 +438,115 @@ bool ScriptPubKeyMan::TopUp(unsigned int kpSize)
 
 void ScriptPubKeyMan::GeneratePool(CWalletDB& batch, int64_t targetSize, const uint8_t& type)
 {
-    for (int64_t i = targetSize; i--;) {
-        CPubKey pubkey(GenerateNewKey(batch, type));
-        AddKeypoolPubkeyWithDB(pubkey, type, batch);
+    if (!IsHDEnabled()) {
+        for (int64_t i = targetSize; i--;) {
+            CPubKey pubkey(GenerateNewKey(batch, type));
+            AddKeypoolPubkeyWithDB(pubkey, type, batch);
+        }
+        return;
+    }
+
+    // HD keys are derived in parallel and written in chunks, each one in a single DB transaction
+    while (targetSize > 0) {
+        targetSize -= GenerateHDPoolKeys(batch, std::min(targetSize, MAX_KEYS_PER_DB_TXN), type);
     }
 }
 
+int64_t ScriptPubKeyMan::GenerateHDPoolKeys(CWalletDB& batch, int64_t count, const uint8_t& type)
+{
+    AssertLockHeld(wallet->cs_wallet);
+    const int nAccountNumber = 0;
+    CExtKey changeKey;
+    CKeyID masterId;
+    DeriveChangeKey(type, changeKey, masterId);
+
+    // Derive the child keys, and their public keys, in parallel
+    CHDChain newChain = hdChain;
+    uint32_t& chainCounter = newChain.GetChainCounter(type);
+    const uint32_t nFirstIndex = chainCounter;
+    std::vector<CExtKey> vChildKeys(count);
+    std::vector<CPubKey> vPubKeys(count);
+    ParallelDeriveKeys(count, [&](size_t i) {
+        changeKey.Derive(vChildKeys[i], (nFirstIndex + i) | BIP32_HARDENED_KEY_LIMIT);
+        vPubKeys[i] = vChildKeys[i].key.GetPubKey();
+        assert(vChildKeys[i].key.VerifyPubKey(vPubKeys[i]));
+    });
+
+    // Write the keys, their pool entries and the chain counter in one DB transaction (the key
+    // writes go through the wallet encryption batch, if the wallet is being encrypted).
+    // The in-memory keystore, keypool and chain are updated only once the transaction committed.
+    CWalletDB& keyBatch = wallet->pwalletdbEncryption ? *wallet->pwalletdbEncryption : batch;
+    const bool fTxn = !wallet->pwalletdbEncryption && batch.TxnBegin();
+    const bool fCrypted = wallet->IsCrypted();
+    if (fCrypted && wallet->IsLocked()) {
+        if (fTxn) batch.TxnAbort();
+        throw std::runtime_error(std::string(__func__) + ": AddKey failed, wallet locked");
+    }
+
+    if (wallet->CanSupportFeature(FEATURE_COMPRPUBKEY)) {
+        wallet->SetMinVersion(FEATURE_COMPRPUBKEY, &batch);
+    }
+    std::vector<int64_t> vNew;
+    std::vector<CKeyMetadata> vMetadata;
+    std::vector<std::vector<unsigned char>> vCryptedSecrets;
+    int64_t nPoolIndex = m_max_keypool_index;
+    const int64_t nCreationTime = GetTime();
+    for (int64_t i = 0; i < count; i++) {
+        chainCounter++;
+        // skip keys already known to the wallet
+        if (wallet->HaveKey(vPubKeys[i].GetID())) continue;
+
+        // m/44'/119'/account_num'/change'/<n>'
+        CKeyMetadata metadata(nCreationTime);
+        metadata.key_origin.path = {44 | BIP32_HARDENED_KEY_LIMIT, 119 | BIP32_HARDENED_KEY_LIMIT,
+                                    nAccountNumber | BIP32_HARDENED_KEY_LIMIT, type | BIP32_HARDENED_KEY_LIMIT,
+                                    (uint32_t) (nFirstIndex + i) | BIP32_HARDENED_KEY_LIMIT};
+        metadata.hd_seed_id = newChain.GetID();
+        std::copy(masterId.begin(), masterId.begin() + 4, metadata.key_origin.fingerprint);
+
+        bool fWritten;
+        std::vector<unsigned char> vchCryptedSecret;
+        if (fCrypted) {
+            CKeyingMaterial vchSecret(vChildKeys[i].key.begin(), vChildKeys[i].key.end());
+            fWritten = EncryptSecret(wallet->GetEncryptionKey(), vchSecret, vPubKeys[i].GetHash(), vchCryptedSecret) &&
+                       keyBatch.WriteCryptedKey(vPubKeys[i], vchCryptedSecret, metadata);
+        } else {
+            fWritten = keyBatch.WriteKey(vPubKeys[i], vChildKeys[i].key.GetPrivKey(), metadata);
+        }
+        if (!fWritten || !batch.WritePool(++nPoolIndex, CKeyPool(vPubKeys[i], type))) {
+            if (fTxn) batch.TxnAbort();
+            throw std::runtime_error(std::string(__func__) + ": AddKey failed");
+        }
+        vNew.emplace_back(i);
+        vMetadata.emplace_back(metadata);
+        vCryptedSecrets.emplace_back(std::move(vchCryptedSecret));
+    }
+
+    // update the chain model in the database
+    const bool fWritten = batch.WriteHDChain(newChain);
+    if (fTxn) {
+        if (!fWritten || !batch.TxnCommit()) {
+            if (!fWritten) batch.TxnAbort();
+            throw std::runtime_error(std::string(__func__) + ": Writing keypool keys failed");
+        }
+    } else if (!fWritten) {
+        throw std::runtime_error(std::string(__func__) + ": Writing HD chain model failed");
+    }
+
+    // Committed, add the keys to the wallet and the keypool
+    hdChain = newChain;
+    for (size_t n = 0; n < vNew.size(); n++) {
+        const CPubKey& pubkey = vPubKeys[vNew[n]];
+        wallet->mapKeyMetadata[pubkey.GetID()] = vMetadata[n];
+        if (!wallet->LoadGeneratedKey(vChildKeys[vNew[n]].key, pubkey, vCryptedSecrets[n])) {
+            throw std::runtime_error(std::string(__func__) + ": AddKey failed");
+        }
+        LoadKeyPool(m_max_keypool_index + 1, CKeyPool(pubkey, type));
+    }
+    UpdateTimeFirstKey(nCreationTime);
+    return vNew.size();
+}
+
 void ScriptPubKeyMan::AddKeypoolPubkeyWithDB(const CPubKey& pubkey, const uint8_t& type, CWalletDB &batch)
 {
     LOCK(wallet->cs_wallet);
@@ -477,7 +606,7 @@ CPubKey ScriptPubKeyMan::GenerateNewKey(CWalletDB &batch, const uint8_t& type)
     return pubkey;
 }
 
-void ScriptPubKeyMan::DeriveNewChildKey(CWalletDB &batch, CKeyMetadata& metadata, CKey& secret, const uint8_t& changeType)
+void ScriptPubKeyMan::DeriveChangeKey(const uint8_t& changeType, CExtKey& changeKey, CKeyID& masterId)
 {
     AssertLockHeld(wallet->cs_wallet);
     // Use BIP44 keypath scheme i.e. m / purpose' / coin_type' / account' / change / address_index
@@ -486,8 +615,6 @@ void ScriptPubKeyMan::DeriveNewChildKey(CWalletDB &batch, CKeyMetadata& metadata
     CExtKey purposeKey;            //key at m/purpose' --> key at m/44'
     CExtKey cointypeKey;           //key at m/purpose'/coin_type'  --> key at m/44'/119'
     CExtKey accountKey;            //key at m/purpose'/coin_type'/account' ---> key at m/44'/119'/account_num'
-    CExtKey changeKey;             //key at m/purpose'/coin_type'/account'/change ---> key at m/44'/119'/account_num'/change', external = 0' or internal = 1'.
-    CExtKey childKey;              //key at m/purpose'/coin_type'/account'/change/address_index ---> key at m/44'/119'/account_num'/change'/<n>'
 
     // For now only one account.
     int nAccountNumber = 0;
@@ -505,31 +632,47 @@ void ScriptPubKeyMan::DeriveNewChildKey(CWalletDB &batch, CKeyMetadata& metadata
     purposeKey.Derive(cointypeKey, 119 | BIP32_HARDENED_KEY_LIMIT);
     // derive m/purpose'/coin_type'/account' // Hardcoded to account 0 for now.
     cointypeKey.Derive(accountKey, nAccountNumber | BIP32_HARDENED_KEY_LIMIT);
-    // derive m/purpose'/coin_type'/account'/change'
+    // derive m/purpose'/coin_type'/account'/change' ---> m/44'/119'/account_num'/change', external = 0' or internal = 1'.
     accountKey.Derive(changeKey,  changeType | BIP32_HARDENED_KEY_LIMIT);
 
+    masterId = masterKey.key.GetPubKey().GetID();
+}
+
+void ScriptPubKeyMan::DeriveNewChildKey(CWalletDB &batch, CKeyMetadata& metadata, CKey& secret, const uint8_t& changeType)
+{
+    AssertLockHeld(wallet->cs_wallet);
+    CExtKey changeKey;             //key at m/purpose'/coin_type'/account'/change
+    CExtKey childKey;              //key at m/purpose'/coin_type'/account'/change/address_index ---> key at m/44'/119'/account_num'/change'/<n>'
+    CKeyID master_id;
+    DeriveChangeKey(changeType, changeKey, master_id);
+
+    // For now only one account.
+    int nAccountNumber = 0;
+
     // derive child key at next index, skip keys already known to the wallet
+    uint32_t childIndex;
     do {
         // always derive hardened keys
         // childIndex | BIP32_HARDENED_KEY_LIMIT = derive childIndex in hardened child-index-range
         // example: 1 | BIP32_HARDENED_KEY_LIMIT == 0x80000001 == 2147483649
 
-        // m/44'/119'/account_num/change'/<n>'
-        metadata.key_origin.path.push_back(44 | BIP32_HARDENED_KEY_LIMIT);
-        metadata.key_origin.path.push_back(119 | BIP32_HARDENED_KEY_LIMIT);
-        metadata.key_origin.path.push_back(nAccountNumber | BIP32_HARDENED_KEY_LIMIT);
         // Child chain counter
         uint32_t& chainCounter = hdChain.GetChainCounter(changeType);
-        changeKey.Derive(childKey, chainCounter | BIP32_HARDENED_KEY_LIMIT);
-        metadata.key_origin.path.push_back( changeType | BIP32_HARDENED_KEY_LIMIT);
-        metadata.key_origin.path.push_back(chainCounter | BIP32_HARDENED_KEY_LIMIT);
+        childIndex = chainCounter;
+        changeKey.Derive(childKey, childIndex | BIP32_HARDENED_KEY_LIMIT);
         chainCounter++;
 
     } while (wallet->HaveKey(childKey.key.GetPubKey().GetID()));
 
+    // m/44'/119'/account_num/change'/<n>'
+    metadata.key_origin.path.push_back(44 | BIP32_HARDENED_KEY_LIMIT);
+    metadata.key_origin.path.push_back(119 | BIP32_HARDENED_KEY_LIMIT);
+    metadata.key_origin.path.push_back(nAccountNumber | BIP32_HARDENED_KEY_LIMIT);
+    metadata.key_origin.path.push_back(changeType | BIP32_HARDENED_KEY_LIMIT);
+    metadata.key_origin.path.push_back(childIndex | BIP32_HARDENED_KEY_LIMIT);
+
     secret = childKey.key;
     metadata.hd_seed_id = hdChain.GetID();
-    CKeyID master_id = masterKey.key.GetPubKey().GetID();
     std::copy(master_id.begin(), master_id.begin() + 4, metadata.key_origin.fingerprint);
     // update the chain model in the database
     if (!batch.WriteHDChain(hdChain))
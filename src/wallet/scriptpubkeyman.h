@@ -13,6 +13,14 @@
 //! Default for -keypool
 static const unsigned int DEFAULT_KEYPOOL_SIZE = 100;
 static const uint32_t BIP32_HARDENED_KEY_LIMIT = 0x80000000;
+//! Maximum number of new keys written to the wallet database in a single transaction
+static const int64_t MAX_KEYS_PER_DB_TXN = 1000;
+
+/**
+ * Run func(i) for every i in [0, count), spread over worker threads (up to one per core).
+ * Used to derive the keys of a batch in parallel: func must only touch the i-th item.
+ */
+void ParallelDeriveKeys(size_t count, const std::function<void(size_t)>& func);
 
 /*
  * A class implementing ScriptPubKeyMan manages some (or all) scriptPubKeys used in a wallet.
@@ -149,7 +157,13 @@ private:
     /* Complete me */
     void AddKeypoolPubkeyWithDB(const CPubKey& pubkey, const uint8_t& type, CWalletDB& batch);
     void GeneratePool(CWalletDB& batch, int64_t targetSize, const uint8_t& type);
+    /* HD derive (in parallel) up to count new child keys and add them to the pool, in one DB transaction.
+     * The wallet, the pool and the chain counter are updated in memory only after it committed.
+     * Returns the number of keys added (the ones already known to the wallet are skipped) */
+    int64_t GenerateHDPoolKeys(CWalletDB& batch, int64_t count, const uint8_t& type);
 
+    /* HD derive the chain key m/44'/119'/account'/change' (and get the id of the master key) */
+    void DeriveChangeKey(const uint8_t& changeType, CExtKey& changeKey, CKeyID& masterId);
     /* HD derive new child key (on internal or external chain) */
     void DeriveNewChildKey(CWalletDB &batch, CKeyMetadata& metadata, CKey& secret, const uint8_t& type = HDChain::ChangeType::EXTERNAL);
 
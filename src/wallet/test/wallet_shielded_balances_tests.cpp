@@ -311,6 +311,7 @@ FakeBlock SimpleFakeMine(CWalletTx& wtx, SaplingMerkleTree& currentTree, CWallet
  * 2) check available credit.
  * 3) spend one of them.
  * 4) force available credit cache recalculation and validate the updated amount.
+ * 5) check the unspent notes listed, before and after erasing the spend.
  */
 BOOST_AUTO_TEST_CASE(GetShieldedAvailableCredit)
 {
@@ -383,6 +384,29 @@ BOOST_AUTO_TEST_CASE(GetShieldedAvailableCredit)
     BOOST_CHECK_EQUAL(wtxDebitUpdated.GetDebit(ISMINE_SPENDABLE_SHIELDED), credit / 2);
     BOOST_CHECK_EQUAL(wtxDebitUpdated.GetShieldedChange(), change);
     BOOST_CHECK_EQUAL(wtxDebitUpdated.GetCredit(ISMINE_SPENDABLE_SHIELDED), change);
+
+    // The notes index, built when the notes were listed, follows the new tx:
+    // the spent note is filtered out and the change note is listed.
+    std::vector<SaplingNoteEntry> unspentEntries;
+    std::set<libzcash::PaymentAddress> noFilter;
+    wallet.GetSaplingScriptPubKeyMan()->GetFilteredNotes(unspentEntries, noFilter, 0);
+    BOOST_CHECK_EQUAL(unspentEntries.size(), 2);
+    CAmount nUnspent = 0;
+    for (const SaplingNoteEntry& entry : unspentEntries) {
+        nUnspent += entry.note.value();
+    }
+    BOOST_CHECK_EQUAL(nUnspent, credit / 2 + change);
+
+    // Once the spending tx is gone, the spent note is listed again
+    wallet.EraseFromWallet(wtxDebitUpdated.GetHash());
+    unspentEntries.clear();
+    wallet.GetSaplingScriptPubKeyMan()->GetFilteredNotes(unspentEntries, noFilter, 0);
+    BOOST_CHECK_EQUAL(unspentEntries.size(), 2);
+    nUnspent = 0;
+    for (const SaplingNoteEntry& entry : unspentEntries) {
+        nUnspent += entry.note.value();
+    }
+    BOOST_CHECK_EQUAL(nUnspent, credit);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
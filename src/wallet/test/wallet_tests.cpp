@@ -628,4 +628,127 @@ BOOST_AUTO_TEST_CASE(cached_balances_tests)
 
 }
 
+static void CheckIsMine(const CWallet& wallet, const CScript& script, isminetype expected)
+{
+    BOOST_CHECK_EQUAL(wallet.IsMine(CTxOut(1, script)), expected);
+    BOOST_CHECK_EQUAL(::IsMine(wallet, script), expected);
+}
+
+BOOST_AUTO_TEST_CASE(ismine_index_tests)
+{
+    CWallet& wallet = *pwalletMain;
+    LOCK(wallet.cs_wallet);
+
+    CKey key1, key2, key3;
+    key1.MakeNewKey(true);
+    key2.MakeNewKey(true);
+    key3.MakeNewKey(false);
+    const CPubKey pub1 = key1.GetPubKey(), pub2 = key2.GetPubKey(), pub3 = key3.GetPubKey();
+    BOOST_CHECK(wallet.AddKeyPubKey(key1, pub1));
+
+    // P2PKH and P2PK
+    CheckIsMine(wallet, GetScriptForDestination(pub1.GetID()), ISMINE_SPENDABLE);
+    CheckIsMine(wallet, GetScriptForRawPubKey(pub1), ISMINE_SPENDABLE);
+    CheckIsMine(wallet, GetScriptForDestination(pub2.GetID()), ISMINE_NO);
+    CheckIsMine(wallet, GetScriptForRawPubKey(pub2), ISMINE_NO);
+
+    // P2CS
+    CheckIsMine(wallet, GetScriptForStakeDelegation(pub2.GetID(), pub1.GetID()), ISMINE_SPENDABLE_DELEGATED);
+    CheckIsMine(wallet, GetScriptForStakeDelegation(pub1.GetID(), pub2.GetID()), ISMINE_COLD);
+    CheckIsMine(wallet, GetScriptForStakeDelegation(pub2.GetID(), pub2.GetID()), ISMINE_NO);
+
+    // Multisig: ours only once we have all the keys
+    const CScript multisig = GetScriptForMultisig(2, {pub1, pub2});
+    BOOST_CHECK(wallet.AddCScript(multisig));
+    CheckIsMine(wallet, GetScriptForDestination(CScriptID(multisig)), ISMINE_NO);
+    CheckIsMine(wallet, multisig, ISMINE_NO);
+    BOOST_CHECK(wallet.AddKeyPubKey(key2, pub2));
+    CheckIsMine(wallet, GetScriptForDestination(CScriptID(multisig)), ISMINE_SPENDABLE);
+    CheckIsMine(wallet, multisig, ISMINE_SPENDABLE);
+    CheckIsMine(wallet, GetScriptForStakeDelegation(pub2.GetID(), pub2.GetID()), ISMINE_SPENDABLE_DELEGATED);
+
+    // Watch-only, replaced by the key when it is added
+    const CScript p2pkh3 = GetScriptForDestination(pub3.GetID());
+    BOOST_CHECK(wallet.AddWatchOnly(p2pkh3));
+    CheckIsMine(wallet, p2pkh3, ISMINE_WATCH_ONLY);
+    BOOST_CHECK(wallet.RemoveWatchOnly(p2pkh3));
+    CheckIsMine(wallet, p2pkh3, ISMINE_NO);
+    BOOST_CHECK(wallet.AddWatchOnly(p2pkh3));
+    BOOST_CHECK(wallet.AddKeyPubKey(key3, pub3));
+    CheckIsMine(wallet, p2pkh3, ISMINE_SPENDABLE);
+    CheckIsMine(wallet, GetScriptForRawPubKey(pub3), ISMINE_SPENDABLE);
+
+    // Watch-only scripts and P2SH of watch-only redeem scripts, updated when a key they reference is added
+    CKey key4, key5;
+    key4.MakeNewKey(true);
+    key5.MakeNewKey(true);
+    const CPubKey pub4 = key4.GetPubKey(), pub5 = key5.GetPubKey();
+    const CScript p2cs = GetScriptForStakeDelegation(pub4.GetID(), pub5.GetID());
+    BOOST_CHECK(wallet.AddWatchOnly(p2cs));
+    CheckIsMine(wallet, p2cs, ISMINE_WATCH_ONLY);
+    const CScript multisig45 = GetScriptForMultisig(1, {pub4, pub5});
+    BOOST_CHECK(wallet.AddCScript(multisig45));
+    CheckIsMine(wallet, GetScriptForDestination(CScriptID(multisig45)), ISMINE_NO);
+    BOOST_CHECK(wallet.AddWatchOnly(multisig45));
+    CheckIsMine(wallet, GetScriptForDestination(CScriptID(multisig45)), ISMINE_WATCH_ONLY);
+    BOOST_CHECK(wallet.AddKeyPubKey(key4, pub4));
+    CheckIsMine(wallet, p2cs, ISMINE_COLD);
+    CheckIsMine(wallet, GetScriptForDestination(CScriptID(multisig45)), ISMINE_WATCH_ONLY);
+    BOOST_CHECK(wallet.AddKeyPubKey(key5, pub5));
+    CheckIsMine(wallet, p2cs, ISMINE_SPENDABLE_DELEGATED);
+    CheckIsMine(wallet, GetScriptForDestination(CScriptID(multisig45)), ISMINE_SPENDABLE);
+    BOOST_CHECK(wallet.RemoveWatchOnly(multisig45));
+    CheckIsMine(wallet, GetScriptForDestination(CScriptID(multisig45)), ISMINE_SPENDABLE);
+}
+
+BOOST_AUTO_TEST_CASE(keypool_topup_tests)
+{
+    CWallet& wallet = *pwalletMain;
+    LOCK(wallet.cs_wallet);
+    wallet.SetMinVersion(FEATURE_SAPLING);
+    wallet.SetupSPKM(false);
+
+    // Batched (parallel) top-up, more keys than a DB transaction holds
+    const unsigned int nKeys = MAX_KEYS_PER_DB_TXN + 50;
+    ScriptPubKeyMan* spk_man = wallet.GetScriptPubKeyMan();
+    BOOST_CHECK(spk_man->TopUp(nKeys));
+    BOOST_CHECK_EQUAL(spk_man->KeypoolCountExternalKeys(), nKeys);
+    const CHDChain& chain = spk_man->GetHDChain();
+    BOOST_CHECK_EQUAL(chain.nExternalChainCounter, nKeys);
+    BOOST_CHECK_EQUAL(chain.nInternalChainCounter, nKeys);
+    BOOST_CHECK_EQUAL(chain.nStakingChainCounter, nKeys);
+
+    // Every key is the one of its sequential derivation path, m/44'/119'/0'/change'/<n>'
+    CKey seed;
+    BOOST_CHECK(wallet.GetKey(chain.GetID(), seed));
+    CExtKey masterKey, accountKey;
+    masterKey.SetSeed(seed.begin(), seed.size());
+    masterKey.Derive(accountKey, 44 | BIP32_HARDENED_KEY_LIMIT);
+    accountKey.Derive(accountKey, 119 | BIP32_HARDENED_KEY_LIMIT);
+    accountKey.Derive(accountKey, 0 | BIP32_HARDENED_KEY_LIMIT);
+    std::set<std::pair<uint32_t, uint32_t>> setPaths;
+    for (const auto& it : wallet.mapKeyMetadata) {
+        const std::vector<uint32_t>& path = it.second.key_origin.path;
+        if (it.second.hd_seed_id != chain.GetID() || path.size() != 5) continue;
+        CExtKey changeKey, childKey;
+        accountKey.Derive(changeKey, path[3]);
+        changeKey.Derive(childKey, path[4]);
+        BOOST_CHECK(childKey.key.GetPubKey().GetID() == it.first);
+        BOOST_CHECK(setPaths.emplace(path[3], path[4]).second);
+    }
+    BOOST_CHECK_EQUAL(setPaths.size(), 3 * nKeys);
+
+    // Sapling keys, through the same batched path
+    SaplingScriptPubKeyMan* sspk_man = wallet.GetSaplingScriptPubKeyMan();
+    const size_t nSaplingKeys = 40;
+    const uint32_t nSaplingCounter = sspk_man->GetHDChain().nExternalChainCounter;
+    const std::vector<libzcash::SaplingPaymentAddress> vAddresses = sspk_man->GenerateNewSaplingZKeys(nSaplingKeys);
+    BOOST_CHECK_EQUAL(vAddresses.size(), nSaplingKeys);
+    BOOST_CHECK_EQUAL(sspk_man->GetHDChain().nExternalChainCounter, nSaplingCounter + nSaplingKeys);
+    BOOST_CHECK_EQUAL(std::set<libzcash::SaplingPaymentAddress>(vAddresses.begin(), vAddresses.end()).size(), nSaplingKeys);
+    for (const auto& addr : vAddresses) {
+        BOOST_CHECK(sspk_man->HaveSpendingKeyForPaymentAddress(addr));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -167,15 +167,19 @@ const CWalletTx* CWallet::GetWalletTx(const uint256& hash) const
     return &(it->second);
 }
 
-std::vector<CWalletTx> CWallet::getWalletTxs()
+int64_t CWallet::ForEachOrderedTx(int64_t nOrderPosBelow, size_t nMaxTxs, const std::function<void(const CWalletTx&)>& func) const
 {
     LOCK(cs_wallet);
-    std::vector<CWalletTx> result;
-    result.reserve(mapWallet.size());
-    for (const auto& entry : mapWallet) {
-        result.emplace_back(entry.second);
+    int64_t nOldestPos = nOrderPosBelow;
+    size_t nVisited = 0;
+    for (auto it = TxItems::const_reverse_iterator(wtxOrdered.lower_bound(nOrderPosBelow)); it != wtxOrdered.rend(); ++it) {
+        // Never split a position between two calls, the next one starts below it
+        if (nVisited >= nMaxTxs && it->first != nOldestPos) break;
+        func(*it->second);
+        nOldestPos = it->first;
+        nVisited++;
     }
-    return result;
+    return nOldestPos;
 }
 
 PairResult CWallet::getNewAddress(CTxDestination& ret, std::string label){
@@ -261,11 +265,14 @@ bool CWallet::AddKeyPubKey(const CKey& secret, const CPubKey& pubkey)
         RemoveWatchOnly(script);
     }
 
+    UpdateIsMineKey(pubkey);
+    UpdateIsMineDependentScripts(pubkey.GetID());
+
     if (!IsCrypted()) {
-        return CWalletDB(*dbw).WriteKey(
-                pubkey,
-                secret.GetPrivKey(),
-                mapKeyMetadata[pubkey.GetID()]);
+        if (pwalletdbEncryption)
+            return pwalletdbEncryption->WriteKey(pubkey, secret.GetPrivKey(), mapKeyMetadata[pubkey.GetID()]);
+        else
+            return CWalletDB(*dbw).WriteKey(pubkey, secret.GetPrivKey(), mapKeyMetadata[pubkey.GetID()]);
     }
     return true;
 }
@@ -275,6 +282,8 @@ bool CWallet::AddCryptedKey(const CPubKey& vchPubKey,
 {
     if (!CCryptoKeyStore::AddCryptedKey(vchPubKey, vchCryptedSecret))
         return false;
+    UpdateIsMineKey(vchPubKey);
+    UpdateIsMineDependentScripts(vchPubKey.GetID());
     {
         LOCK(cs_wallet);
         if (pwalletdbEncryption)
@@ -302,6 +311,25 @@ bool CWallet::LoadCryptedKey(const CPubKey& vchPubKey, const std::vector<unsigne
     return CCryptoKeyStore::AddCryptedKey(vchPubKey, vchCryptedSecret);
 }
 
+bool CWallet::LoadGeneratedKey(const CKey& key, const CPubKey& pubkey, const std::vector<unsigned char>& vchCryptedSecret)
+{
+    AssertLockHeld(cs_wallet);
+    if (!(IsCrypted() ? LoadCryptedKey(pubkey, vchCryptedSecret) : LoadKey(key, pubkey)))
+        return false;
+
+    // check if we need to remove from watch-only
+    CScript script = GetScriptForDestination(pubkey.GetID());
+    if (HaveWatchOnly(script))
+        RemoveWatchOnly(script);
+    script = GetScriptForRawPubKey(pubkey);
+    if (HaveWatchOnly(script))
+        RemoveWatchOnly(script);
+
+    UpdateIsMineKey(pubkey);
+    UpdateIsMineDependentScripts(pubkey.GetID());
+    return true;
+}
+
 /**
  * Update wallet first key creation time. This should be called whenever keys
  * are added to the wallet, with the oldest key creation time.
@@ -322,6 +350,7 @@ bool CWallet::AddCScript(const CScript& redeemScript)
 {
     if (!CCryptoKeyStore::AddCScript(redeemScript))
         return false;
+    AddIsMineDependentScript(GetScriptForDestination(CScriptID(redeemScript)));
     return CWalletDB(*dbw).WriteCScript(Hash160(redeemScript), redeemScript);
 }
 
@@ -344,6 +373,9 @@ bool CWallet::AddWatchOnly(const CScript& dest)
 {
     if (!CCryptoKeyStore::AddWatchOnly(dest))
         return false;
+    AddIsMineDependentScript(dest);
+    // A P2SH of a known redeem script is watched as well
+    if (HaveCScript(CScriptID(dest))) UpdateIsMineScript(GetScriptForDestination(CScriptID(dest)));
     nTimeFirstKey = 1; // No birthday information for watch-only keys.
     NotifyWatchonlyChanged(true);
     return CWalletDB(*dbw).WriteWatchOnly(dest);
@@ -354,6 +386,8 @@ bool CWallet::RemoveWatchOnly(const CScript& dest)
     AssertLockHeld(cs_wallet);
     if (!CCryptoKeyStore::RemoveWatchOnly(dest))
         return false;
+    UpdateIsMineScript(dest);
+    if (HaveCScript(CScriptID(dest))) UpdateIsMineScript(GetScriptForDestination(CScriptID(dest)));
     if (!HaveWatchOnly())
         NotifyWatchonlyChanged(false);
     if (!CWalletDB(*dbw).EraseWatchOnly(dest))
@@ -367,6 +401,112 @@ bool CWallet::LoadWatchOnly(const CScript& dest)
     return CCryptoKeyStore::AddWatchOnly(dest);
 }
 
+SaltedIsMineHasher::SaltedIsMineHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+void CWallet::UpdateIsMineScript(const CScript& script)
+{
+    LOCK(cs_KeyStore);
+    const isminetype mine = ::IsMine(*this, script);
+    if (mine != ISMINE_NO) {
+        mapIsMineScripts[script] = mine;
+    } else {
+        mapIsMineScripts.erase(script);
+    }
+}
+
+void CWallet::UpdateIsMineKey(const CPubKey& pubkey)
+{
+    LOCK(cs_KeyStore);
+    setIsMineKeys.insert(pubkey.GetID());
+    UpdateIsMineScript(GetScriptForDestination(pubkey.GetID()));
+    UpdateIsMineScript(GetScriptForRawPubKey(pubkey));
+}
+
+/**
+ * Ids of the keys whose addition may change the IsMine type of a script: the keys of
+ * P2PK, P2PKH, P2CS and multisig scripts, and for P2SH the keys of the redeem script,
+ * if known (a P2SH redeem script can't be P2SH again).
+ */
+static void GetIsMineDependencies(const CKeyStore& keystore, const CScript& script, std::vector<CKeyID>& vKeys, bool fRecurse = true)
+{
+    std::vector<std::vector<unsigned char>> vSolutions;
+    txnouttype whichType;
+    if (!Solver(script, whichType, vSolutions)) return;
+    switch (whichType) {
+    case TX_PUBKEY:
+        vKeys.emplace_back(CPubKey(vSolutions[0]).GetID());
+        break;
+    case TX_PUBKEYHASH:
+        vKeys.emplace_back(uint160(vSolutions[0]));
+        break;
+    case TX_COLDSTAKE:
+        vKeys.emplace_back(uint160(vSolutions[0]));
+        vKeys.emplace_back(uint160(vSolutions[1]));
+        break;
+    case TX_MULTISIG:
+        for (size_t i = 1; i + 1 < vSolutions.size(); i++) {
+            vKeys.emplace_back(CPubKey(vSolutions[i]).GetID());
+        }
+        break;
+    case TX_SCRIPTHASH: {
+        CScript subscript;
+        if (fRecurse && keystore.GetCScript(CScriptID(uint160(vSolutions[0])), subscript)) {
+            GetIsMineDependencies(keystore, subscript, vKeys, false);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void CWallet::AddIsMineDependentScript(const CScript& script)
+{
+    LOCK(cs_KeyStore);
+    std::vector<CKeyID> vKeys;
+    GetIsMineDependencies(*this, script, vKeys);
+    for (const CKeyID& keyID : vKeys) {
+        std::vector<CScript>& vDependents = mapIsMineKeyDependents[keyID];
+        if (std::find(vDependents.begin(), vDependents.end(), script) == vDependents.end()) {
+            vDependents.emplace_back(script);
+        }
+    }
+    UpdateIsMineScript(script);
+}
+
+void CWallet::UpdateIsMineDependentScripts(const CKeyID& keyID)
+{
+    LOCK(cs_KeyStore);
+    const auto it = mapIsMineKeyDependents.find(keyID);
+    if (it == mapIsMineKeyDependents.end()) return;
+    // Entries of removed watch-only scripts are left in place, recomputing them is harmless
+    for (const CScript& script : it->second) {
+        UpdateIsMineScript(script);
+    }
+}
+
+void CWallet::RebuildIsMineIndex()
+{
+    LOCK(cs_KeyStore);
+    mapIsMineScripts.clear();
+    setIsMineKeys.clear();
+    mapIsMineKeyDependents.clear();
+    std::set<CKeyID> setKeys;
+    GetKeys(setKeys);
+    for (const CKeyID& keyID : setKeys) {
+        CPubKey pubkey;
+        if (GetPubKey(keyID, pubkey)) {
+            UpdateIsMineKey(pubkey);
+        }
+    }
+    for (const auto& it : mapScripts) {
+        AddIsMineDependentScript(GetScriptForDestination(CScriptID(it.second)));
+    }
+    for (const CScript& script : setWatchOnly) {
+        AddIsMineDependentScript(script);
+    }
+}
+
 bool CWallet::Unlock(const SecureString& strWalletPassphrase, bool stakingOnly)
 {
     CCrypter crypter;
@@ -966,14 +1106,20 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
     //// debug print
     LogPrintf("AddToWallet %s  %s%s\n", wtxIn.GetHash().ToString(), (fInsertedNew ? "new" : ""), (fUpdated ? "update" : ""));
 
+    // Break debit/credit balance caches:
+    wtx.MarkDirty();
+
     // Write to disk
     if (fInsertedNew || fUpdated) {
         if (!walletdb.WriteTx(wtx))
             return false;
-    }
 
-    // Break debit/credit balance caches:
-    wtx.MarkDirty();
+        // Coinstakes connected or disconnected, new or updated notes (only once written)
+        UpdateStakingRewards(wtx);
+        if (HasSaplingSPKM()) {
+            m_sspk_man->UpdateNotesIndex(wtx);
+        }
+    }
 
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
@@ -1029,6 +1175,7 @@ bool CWallet::LoadToWallet(CWalletTx& wtxIn)
     wtx.BindWallet(this);
     // Sapling
     m_sspk_man->UpdateNullifierNoteMapWithTx(wtx);
+    m_sspk_man->UpdateNotesIndex(wtx);
     wtxOrdered.emplace(wtx.nOrderPos, &wtx);
     AddToSpends(hash);
     for (const CTxIn& txin : wtx.tx->vin) {
@@ -1197,6 +1344,9 @@ bool CWallet::AbandonTransaction(const uint256& hashTx)
             wtx.setAbandoned();
             wtx.MarkDirty();
             walletdb.WriteTx(wtx);
+            if (HasSaplingSPKM()) {
+                m_sspk_man->UpdateSpentNotes(*wtx.tx);
+            }
             NotifyTransactionChanged(this, wtx.GetHash(), CT_UPDATED);
             // Iterate over all its outputs, and mark transactions in the wallet that spend them abandoned too
             TxSpends::const_iterator iter = mapTxSpends.lower_bound(COutPoint(now, 0));
@@ -1256,7 +1406,11 @@ void CWallet::MarkConflicted(const uint256& hashBlock, int conflicting_height, c
             wtx.m_confirm.block_height = conflicting_height;
             wtx.setConflicted();
             wtx.MarkDirty();
+            UpdateStakingRewards(wtx);
             walletdb.WriteTx(wtx);
+            if (HasSaplingSPKM()) {
+                m_sspk_man->UpdateSpentNotes(*wtx.tx);
+            }
             // Iterate over all its outputs, and mark transactions in the wallet that spend them conflicted too
             TxSpends::const_iterator iter = mapTxSpends.lower_bound(COutPoint(now, 0));
             while (iter != mapTxSpends.end() && iter->first.hash == now) {
@@ -1458,13 +1612,126 @@ void CWallet::EraseFromWallet(const uint256& hash)
 {
     {
         LOCK(cs_wallet);
-        if (mapWallet.erase(hash))
-            CWalletDB(*dbw).EraseTx(hash);
+        auto it = mapWallet.find(hash);
+        if (it != mapWallet.end()) {
+            if (!CWalletDB(*dbw).EraseTx(hash)) {
+                LogPrintf("%s: Failed to erase wtx %s from the wallet db\n", __func__, hash.GetHex());
+                return;
+            }
+            UpdateStakingRewards(it->second, true);
+            CTransactionRef tx = it->second.tx;
+            if (HasSaplingSPKM()) {
+                m_sspk_man->UpdateNotesIndex(it->second, true);
+            }
+            mapWallet.erase(it);
+            // The notes spent by the erased tx may be unspent now
+            if (HasSaplingSPKM()) {
+                m_sspk_man->UpdateSpentNotes(*tx);
+            }
+        }
         LogPrintf("%s: Erased wtx %s from wallet\n", __func__, hash.GetHex());
     }
     return;
 }
 
+static const int64_t STAKING_REWARDS_PERIOD = 15 * 60;
+
+static int64_t GetRewardPeriod(int64_t nTime)
+{
+    return nTime >= 0 ? nTime / STAKING_REWARDS_PERIOD : (nTime - STAKING_REWARDS_PERIOD + 1) / STAKING_REWARDS_PERIOD;
+}
+
+bool CWallet::GetStakingReward(const CWalletTx& wtx, CStakingRewards& reward) const
+{
+    AssertLockHeld(cs_wallet);
+    if (!wtx.isConfirmed()) {
+        return false;
+    }
+
+    const CTransaction& tx = *wtx.tx;
+    if (tx.IsCoinBase()) {
+        // Mined (PoW) block reward
+        reward.nGenerated = wtx.GetCredit(ISMINE_ALL);
+    } else if (!tx.IsCoinStake() || tx.vout.size() < 2) {
+        return false;
+    } else if (tx.HasZerocoinSpendInputs()) {
+        // zPIV stake
+        reward.nZpivStake = wtx.GetCredit(ISMINE_ALL) - wtx.GetDebit(ISMINE_ALL);
+    } else if (IsMine(tx.vout[1])) {
+        if (tx.HasP2CSOutputs()) {
+            // Cold stake: reward of the owner of the delegated coins (nothing for the staker)
+            for (const CTxOut& txout : tx.vout) {
+                if (txout.scriptPubKey.IsPayToColdStaking()) {
+                    if (IsMine(txout) & ISMINE_SPENDABLE_DELEGATED) {
+                        reward.nDelegated = wtx.GetCredit(ISMINE_ALL) - wtx.GetDebit(ISMINE_ALL);
+                    }
+                    break;
+                }
+            }
+        } else {
+            reward.nStake = wtx.GetCredit(ISMINE_ALL) - wtx.GetDebit(ISMINE_ALL);
+        }
+    } else {
+        // Masternode reward, paid by the last output
+        const CTxOut& txout = tx.vout.back();
+        CTxDestination destMN;
+        if (ExtractDestination(txout.scriptPubKey, destMN) && ::IsMine(*this, destMN)) {
+            reward.nMasternode = txout.nValue;
+        }
+    }
+    if (reward.GetTotal() == 0) {
+        return false;
+    }
+    reward.nCount = 1;
+    return true;
+}
+
+void CWallet::UpdateStakingRewards(const CWalletTx& wtx, bool fErased)
+{
+    AssertLockHeld(cs_wallet);
+    const uint256& hash = wtx.GetHash();
+    auto it = mapStakingRewardTxs.find(hash);
+    if (it != mapStakingRewardTxs.end()) {
+        auto itPeriod = mapStakingRewards.find(it->second.first);
+        assert(itPeriod != mapStakingRewards.end());
+        itPeriod->second -= it->second.second;
+        if (itPeriod->second.IsNull()) mapStakingRewards.erase(itPeriod);
+        mapStakingRewardTxs.erase(it);
+    }
+
+    CStakingRewards reward;
+    if (fErased || !GetStakingReward(wtx, reward)) {
+        return;
+    }
+    const int64_t nPeriod = GetRewardPeriod(wtx.GetTxTime());
+    mapStakingRewards[nPeriod] += reward;
+    mapStakingRewardTxs.emplace(hash, std::make_pair(nPeriod, reward));
+}
+
+void CWallet::RebuildStakingRewards()
+{
+    AssertLockHeld(cs_wallet);
+    mapStakingRewards.clear();
+    mapStakingRewardTxs.clear();
+    for (const auto& it : mapWallet) {
+        UpdateStakingRewards(it.second);
+    }
+}
+
+std::map<int64_t, CStakingRewards> CWallet::GetStakingRewards(int64_t nTimeFrom, int64_t nTimeTo) const
+{
+    LOCK(cs_wallet);
+    std::map<int64_t, CStakingRewards> result;
+    if (nTimeFrom > nTimeTo) {
+        return result;
+    }
+    const auto itEnd = mapStakingRewards.upper_bound(GetRewardPeriod(nTimeTo));
+    for (auto it = mapStakingRewards.lower_bound(GetRewardPeriod(nTimeFrom)); it != itEnd; ++it) {
+        result.emplace(it->first * STAKING_REWARDS_PERIOD, it->second);
+    }
+    return result;
+}
+
 isminetype CWallet::IsMine(const CTxIn& txin) const
 {
     {
@@ -1524,7 +1791,7 @@ bool CWallet::IsChange(const CTxOut& txout) const
     // a better way of identifying which outputs are 'the send' and which are
     // 'the change' will need to be implemented (maybe extend CWalletTx to remember
     // which output, if any, was change).
-    if (::IsMine(*this, txout.scriptPubKey)) {
+    if (IsMine(txout)) {
         CTxDestination address;
         if (!ExtractDestination(txout.scriptPubKey, address))
             return true;
@@ -3479,6 +3746,11 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
     // This wallet is in its first run if all of these are empty
     fFirstRunRet = mapKeys.empty() && mapCryptedKeys.empty() && mapMasterKeys.empty() && setWatchOnly.empty() && mapScripts.empty();
 
+    // Keys and scripts were loaded in no particular order
+    RebuildIsMineIndex();
+    // Needs every tx loaded (debits of the coinstakes)
+    RebuildStakingRewards();
+
     if (nLoadWalletRet != DB_LOAD_OK)
         return nLoadWalletRet;
 
@@ -4438,9 +4710,38 @@ bool CWallet::LoadMinVersion(int nVersion)
     return true;
 }
 
+// Same template as the Solver's TX_PUBKEY
+static bool IsPayToPubKeyScript(const CScript& script)
+{
+    return (script.size() == CPubKey::PUBLIC_KEY_SIZE + 2 && script[0] == CPubKey::PUBLIC_KEY_SIZE && script.back() == OP_CHECKSIG) ||
+           (script.size() == CPubKey::COMPRESSED_PUBLIC_KEY_SIZE + 2 && script[0] == CPubKey::COMPRESSED_PUBLIC_KEY_SIZE && script.back() == OP_CHECKSIG);
+}
+
 isminetype CWallet::IsMine(const CTxOut& txout) const
 {
-    return ::IsMine(*this, txout.scriptPubKey);
+    const CScript& script = txout.scriptPubKey;
+    {
+        LOCK(cs_KeyStore);
+        const auto it = mapIsMineScripts.find(script);
+        if (it != mapIsMineScripts.end()) {
+            return it->second;
+        }
+        if (script.IsPayToColdStaking()) {
+            // Same precedence as ::IsMine: the owner key first
+            CKeyID stakerID, ownerID;
+            memcpy(stakerID.begin(), &script[6], stakerID.size());
+            memcpy(ownerID.begin(), &script[28], ownerID.size());
+            if (setIsMineKeys.count(ownerID)) return ISMINE_SPENDABLE_DELEGATED;
+            if (setIsMineKeys.count(stakerID)) return ISMINE_COLD;
+            return ISMINE_NO;
+        }
+    }
+    // The index covers every P2PKH, P2SH and P2PK script of the wallet.
+    // Anything else (e.g. bare multisig) goes through the full check.
+    if (script.IsPayToPublicKeyHash() || script.IsPayToScriptHash() || IsPayToPubKeyScript(script)) {
+        return ISMINE_NO;
+    }
+    return ::IsMine(*this, script);
 }
 
 CAmount CWallet::GetCredit(const CTxOut& txout, const isminefilter& filter) const
@@ -41,6 +41,8 @@
 #include <stdexcept>
 #include <stdint.h>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -560,8 +562,60 @@ public:
 };
 
 
+/** Staking rewards paid to the wallet (in a day, or by a single coinstake) */
+struct CStakingRewards {
+    CAmount nStake{0};          //!< Rewards of the PIV coinstakes of this wallet
+    CAmount nZpivStake{0};      //!< Rewards of the zPIV coinstakes of this wallet
+    CAmount nDelegated{0};      //!< Rewards of the coinstakes of coins delegated by this wallet (cold staking owner)
+    CAmount nMasternode{0};     //!< Masternode rewards paid to this wallet
+    CAmount nGenerated{0};      //!< Rewards of the blocks mined (PoW) by this wallet
+    int nCount{0};              //!< Number of coinstakes and coinbases paying the rewards
+
+    CAmount GetTotal() const { return nStake + nZpivStake + nDelegated + nMasternode + nGenerated; }
+    bool IsNull() const { return nCount == 0; }
+
+    CStakingRewards& operator+=(const CStakingRewards& r)
+    {
+        nStake += r.nStake;
+        nZpivStake += r.nZpivStake;
+        nDelegated += r.nDelegated;
+        nMasternode += r.nMasternode;
+        nGenerated += r.nGenerated;
+        nCount += r.nCount;
+        return *this;
+    }
+    CStakingRewards& operator-=(const CStakingRewards& r)
+    {
+        nStake -= r.nStake;
+        nZpivStake -= r.nZpivStake;
+        nDelegated -= r.nDelegated;
+        nMasternode -= r.nMasternode;
+        nGenerated -= r.nGenerated;
+        nCount -= r.nCount;
+        return *this;
+    }
+};
+
 class WalletRescanReserver; //forward declarations for ScanForWalletTransactions/RescanFromTime
 
+/** Salted hasher of the scripts and key ids of the wallet IsMine index */
+class SaltedIsMineHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedIsMineHasher();
+
+    size_t operator()(const CScript& script) const {
+        return CSipHasher(k0, k1).Write(script.data(), script.size()).Finalize();
+    }
+    size_t operator()(const CKeyID& keyID) const {
+        return CSipHasher(k0, k1).Write(keyID.begin(), keyID.size()).Finalize();
+    }
+};
+
 /**
  * A CWallet is an extension of a keystore, which also maintains a set of transactions and balances,
  * and provides the ability to create new transactions.
@@ -614,6 +668,46 @@ private:
     int64_t nNextResend;
     int64_t nLastResend;
 
+    /**
+     * IsMine index: the scripts the wallet owns or watches, with their IsMine type
+     * (P2PK and P2PKH scripts of its keys, keypool included, P2SH scripts of its redeem
+     * scripts, watch-only scripts), and the ids of its keys (for the owner and staker
+     * of P2CS scripts). It makes IsMine(CTxOut) a hash lookup, instead of Solver plus
+     * keystore lookups, for all the standard script types.
+     * Kept up to date by the key/script/watch-only Add* methods, and built once by
+     * LoadWallet after all the records are loaded.
+     */
+    std::unordered_map<CScript, isminetype, SaltedIsMineHasher> mapIsMineScripts GUARDED_BY(cs_KeyStore);
+    std::unordered_set<CKeyID, SaltedIsMineHasher> setIsMineKeys GUARDED_BY(cs_KeyStore);
+    //! P2SH and watch-only scripts of the index, by the ids of the keys they reference (whose addition may change their type)
+    std::unordered_map<CKeyID, std::vector<CScript>, SaltedIsMineHasher> mapIsMineKeyDependents GUARDED_BY(cs_KeyStore);
+    //! Update the IsMine index entry of a script
+    void UpdateIsMineScript(const CScript& script);
+    //! Add a key to the IsMine index, with its P2PK and P2PKH scripts
+    void UpdateIsMineKey(const CPubKey& pubkey);
+    //! Add a P2SH or watch-only script to the IsMine index, and record the keys it depends on
+    void AddIsMineDependentScript(const CScript& script);
+    //! Update the entries that depend on a key just added: P2SH and watch-only scripts referencing it
+    void UpdateIsMineDependentScripts(const CKeyID& keyID);
+    //! Rebuild the IsMine index from the keystore (after LoadWallet)
+    void RebuildIsMineIndex();
+
+    /**
+     * Aggregate of the staking rewards per quarter hour (keyed by quarter number since the epoch),
+     * and the contribution of each coinstake or coinbase to it. Every timezone is offset from UTC
+     * by a whole number of quarter hours, so the quarters add up to the days of any timezone.
+     * Updated when a wallet tx is added, changes confirmation status (connected, disconnected
+     * or conflicted) or is erased.
+     */
+    std::map<int64_t, CStakingRewards> mapStakingRewards GUARDED_BY(cs_wallet);
+    std::map<uint256, std::pair<int64_t, CStakingRewards>> mapStakingRewardTxs GUARDED_BY(cs_wallet);
+    //! Reward paid to this wallet by a confirmed coinstake or coinbase, false if none
+    bool GetStakingReward(const CWalletTx& wtx, CStakingRewards& reward) const;
+    //! Replace the contribution of a wallet tx to the staking rewards aggregate
+    void UpdateStakingRewards(const CWalletTx& wtx, bool fErased = false);
+    //! Rebuild the staking rewards aggregate from mapWallet (after LoadWallet)
+    void RebuildStakingRewards();
+
     /**
      * Used to keep track of spent outpoints, and
      * detect and report conflicts (double-spends or
@@ -700,6 +794,7 @@ public:
 
     bool fWalletUnlockStaking;
 
+    //! Batch of the ongoing key-writing DB transaction (wallet encryption, keypool top-up), the key writes go through it
     CWalletDB* pwalletdbEncryption;
 
     std::map<CKeyID, CKeyMetadata> mapKeyMetadata;
@@ -765,7 +860,12 @@ public:
 
     const CWalletTx* GetWalletTx(const uint256& hash) const;
 
-    std::vector<CWalletTx> getWalletTxs();
+    /**
+     * Visit, newest first and without copying them, up to nMaxTxs wallet transactions ordered
+     * below nOrderPosBelow in wtxOrdered (transactions sharing the last visited position are
+     * all visited). Returns the position of the oldest visited transaction, nOrderPosBelow if none.
+     */
+    int64_t ForEachOrderedTx(int64_t nOrderPosBelow, size_t nMaxTxs, const std::function<void(const CWalletTx&)>& func) const;
     std::string GetUniqueWalletBackupName() const;
 
     //! check whether we are allowed to upgrade (or already support) to the named feature
@@ -952,6 +1052,8 @@ public:
     bool AddCryptedKey(const CPubKey& vchPubKey, const std::vector<unsigned char>& vchCryptedSecret) override;
     //! Adds an encrypted key to the store, without saving it to disk (used by LoadWallet)
     bool LoadCryptedKey(const CPubKey& vchPubKey, const std::vector<unsigned char>& vchCryptedSecret);
+    //! Adds a key already saved to disk (by a keypool top-up) to the store: its encrypted secret if the wallet is encrypted
+    bool LoadGeneratedKey(const CKey& key, const CPubKey& pubkey, const std::vector<unsigned char>& vchCryptedSecret);
     bool AddCScript(const CScript& redeemScript) override;
     bool LoadCScript(const CScript& redeemScript);
 
@@ -1020,6 +1122,12 @@ public:
     };
     Balance GetBalance(int min_depth = 0) const;
 
+    /**
+     * Staking rewards of the confirmed coinstakes and coinbases with time between nTimeFrom and nTimeTo
+     * (inclusive), per quarter hour, keyed by its start time. Read from the aggregate.
+     */
+    std::map<int64_t, CStakingRewards> GetStakingRewards(int64_t nTimeFrom, int64_t nTimeTo) const;
+
     CAmount loopTxsBalance(const std::function<void(const uint256&, const CWalletTx&, CAmount&)>&method) const;
     CAmount GetAvailableBalance(bool fIncludeDelegated = true, bool fIncludeShielded = true) const;
     CAmount GetAvailableBalance(isminefilter& filter, bool useCache = false, int minDepth = 1) const;
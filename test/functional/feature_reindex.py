@@ -7,6 +7,7 @@
 - Start a single node and generate 3 blocks.
 - Stop the node and restart it with -reindex. Verify that the node has reindexed up to block 3.
 - Stop the node and restart it with -reindex-chainstate. Verify that the node has reindexed up to block 3.
+- Check the startup phases reported by getstartupinfo.
 """
 
 from test_framework.test_framework import PivxTestFramework
@@ -29,6 +30,13 @@ class ReindexTest(PivxTestFramework):
             "chainstate" if justchainstate else "blocks", blockcount))
         self.start_nodes(extra_args)
         assert_equal(self.nodes[0].getblockcount(), blockcount)  # start_node is blocking on reindex
+        startup = self.nodes[0].getstartupinfo()
+        assert startup['duration'] >= 0
+        phases = {p['name']: p for p in startup['phases']}
+        for name in ['sapling_params', 'load_block_index', 'replay_blocks', 'tier_two_caches', 'mncache']:
+            assert name in phases
+        assert phases['sapling_params']['concurrent']
+        assert not phases['load_block_index']['concurrent']
         self.log.info("Success")
 
     def run_test(self):
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The PIVX developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the rollback of a batch of blocks whose pipelined script checks failed.
+
+During IBD, the script checks of the blocks connected in one go run while the next
+blocks are connected. When one of them fails, the batch is disconnected and connected
+again block by block. The node must be left as if the batch had never been connected:
+no txindex entries, no spent outputs and no mempool txes from its blocks.
+
+- Build a chain of old blocks (so that the node stays in IBD), and two forks on top of it:
+  a valid one, and a longer one with a block spending an output with a failing script.
+- Send the valid fork, then the invalid one: the reorg pipelines the script checks of
+  the invalid fork, which is rolled back.
+- Reconsider the invalid block: its fork is pipelined, and rolled back, again.
+"""
+
+from test_framework.blocktools import create_block, create_coinbase, create_transaction
+from test_framework.messages import COIN
+from test_framework.script import (
+    CScript,
+    OP_FALSE,
+)
+from test_framework.test_framework import PivxTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+    bytes_to_hex_str,
+)
+
+FORK_HEIGHT = 110
+INVALID_HEIGHT = FORK_HEIGHT + 5
+
+
+class ScriptCheckPipelineTest(PivxTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [["-txindex", "-par=2"]]
+
+    def make_chain(self, prev_hash, prev_time, start_height, end_height, txs_at=None):
+        """Blocks from start_height to end_height, each one second after its parent"""
+        txs_at = txs_at or {}
+        blocks = []
+        for height in range(start_height, end_height + 1):
+            block = create_block(prev_hash, create_coinbase(height), prev_time + 1)
+            block.vtx.extend(txs_at.get(height, []))
+            block.hashMerkleRoot = block.calc_merkle_root()
+            block.rehash()
+            block.solve()
+            blocks.append(block)
+            prev_hash, prev_time = block.sha256, block.nTime
+        return blocks
+
+    def submit(self, blocks):
+        for block in blocks:
+            self.nodes[0].submitblock(bytes_to_hex_str(block.serialize()))
+
+    def check_rolled_back(self):
+        node = self.nodes[0]
+        assert_equal(node.getbestblockhash(), self.fork_valid[-1].hash)
+        tips = {tip["hash"]: tip["status"] for tip in node.getchaintips()}
+        assert_equal(tips[self.fork_invalid[-1].hash], "invalid")
+        # The txes of the invalid fork are neither indexed nor put in the mempool...
+        assert_equal(node.getrawtransaction(self.tx_ok.hash), bytes_to_hex_str(self.tx_ok.serialize()))
+        assert_raises_rpc_error(-5, None, node.getrawtransaction, self.tx_bad.hash)
+        assert_raises_rpc_error(-5, None, node.getrawtransaction, self.tx_after.hash)
+        assert_equal(node.getrawmempool(), [])
+        # ...and the outputs they spent are unspent
+        assert node.gettxout(self.tx_ok.hash, 0) is not None
+        assert node.gettxout(self.coinbase_after.hash, 0) is not None
+        assert node.gettxout(self.tx_after.hash, 0) is None
+
+    def run_test(self):
+        node = self.nodes[0]
+        # The blocks are timestamped right after the genesis block, so that the node stays in IBD
+        genesis = node.getblock(node.getbestblockhash())
+        genesis_hash, genesis_time = int(genesis["hash"], 16), genesis["time"]
+
+        self.log.info("Connect the common chain, with an output that can't be spent")
+        first_blocks = self.make_chain(genesis_hash, genesis_time, 1, 2)
+        self.tx_ok = create_transaction(first_blocks[0].vtx[0], 0, b"", 249 * COIN, CScript([OP_FALSE]))
+        common = first_blocks + self.make_chain(first_blocks[-1].sha256, first_blocks[-1].nTime, 3, FORK_HEIGHT,
+                                                {FORK_HEIGHT - 5: [self.tx_ok]})
+        self.submit(common)
+        assert_equal(node.getbestblockhash(), common[-1].hash)
+
+        self.log.info("Connect a valid fork")
+        # Timestamped later than the invalid fork, so that the blocks differ at the same heights
+        self.fork_valid = self.make_chain(common[-1].sha256, common[-1].nTime + 1000, FORK_HEIGHT + 1, FORK_HEIGHT + 30)
+        self.submit(self.fork_valid)
+        assert_equal(node.getbestblockhash(), self.fork_valid[-1].hash)
+
+        self.log.info("Send a longer fork, with a failing script in a pipelined batch")
+        self.tx_bad = create_transaction(self.tx_ok, 0, b"", 248 * COIN)
+        self.coinbase_after = first_blocks[1].vtx[0]
+        self.tx_after = create_transaction(self.coinbase_after, 0, b"", 249 * COIN)
+        self.fork_invalid = self.make_chain(common[-1].sha256, common[-1].nTime, FORK_HEIGHT + 1, FORK_HEIGHT + 31,
+                                            {INVALID_HEIGHT: [self.tx_bad], INVALID_HEIGHT + 1: [self.tx_after]})
+        self.submit(self.fork_invalid[:-1])
+        assert_equal(node.getbestblockhash(), self.fork_valid[-1].hash)
+        with node.assert_debug_log(["script checks failed in blocks %d to" % (FORK_HEIGHT + 1)]):
+            self.submit(self.fork_invalid[-1:])
+        self.check_rolled_back()
+
+        self.log.info("Reconsider the invalid block: its fork is pipelined and rolled back again")
+        with node.assert_debug_log(["script checks failed in blocks %d to" % (FORK_HEIGHT + 1)]):
+            node.reconsiderblock(self.fork_invalid[INVALID_HEIGHT - FORK_HEIGHT - 1].hash)
+        self.check_rolled_back()
+
+
+if __name__ == '__main__':
+    ScriptCheckPipelineTest().main()
@@ -6,6 +6,7 @@
 from test_framework.test_framework import PivxTestFramework
 from test_framework.util import (
     assert_equal,
+    assert_greater_than,
     assert_raises_rpc_error,
     connect_nodes,
     connect_nodes_clique,
@@ -83,6 +84,7 @@ class ReorgStakeTest(PivxTestFramework):
         # Stake one block with node-0 and save the stake input
         self.log.info("Staking 1 block with node 0...")
         initial_unspent_0 = self.nodes[0].listunspent()
+        initial_rewards_0 = self.nodes[0].getstakingrewards()["total"]
         self.mocktime = self.generate_pos(0, self.mocktime)
         last_block = self.nodes[0].getblock(self.nodes[0].getbestblockhash())
         assert(len(last_block["tx"]) > 1)   # a PoS block has at least two txes
@@ -106,6 +108,10 @@ class ReorgStakeTest(PivxTestFramework):
         expected_balance_0 = initial_balance[0] + DecimalAmt(11 * 250.0)
         assert_equal(self.get_tot_balance(0), expected_balance_0)
         self.log.info("Balance for node 0 checks out.")
+        rewards_0 = self.nodes[0].getstakingrewards()["total"]
+        assert_equal(rewards_0["count"], initial_rewards_0["count"] + 11)
+        assert_equal(rewards_0["stake"], initial_rewards_0["stake"] + DecimalAmt(11 * 250.0))
+        self.log.info("Staking rewards for node 0 check out.")
 
         # Connect with node 2 and sync
         self.log.info("Reconnecting node 0 and node 2")
@@ -144,10 +150,17 @@ class ReorgStakeTest(PivxTestFramework):
         self.sync_blocks()
         for i in [0, 2]:
             assert_equal(self.nodes[i].getbestblockhash(), new_best_hash)
+        # the reorg took the disconnected blocks (with their undo) and the side-chain blocks from memory
+        reorg_cache = self.nodes[0].getreorgcacheinfo()
+        assert_greater_than(reorg_cache["block_hits"], 0)
+        assert_greater_than(reorg_cache["undo_hits"], 0)
 
         # check balance of node-0
         assert_equal(self.get_tot_balance(0), initial_balance[0])
         self.log.info("Balance for node 0 checks out.")
+        # the coinstakes of node-0 were disconnected
+        assert_equal(self.nodes[0].getstakingrewards()["total"], initial_rewards_0)
+        self.log.info("Staking rewards for node 0 check out.")
 
         # check that NOW the original stakeinput is present and spendable
         res, utxo = findUtxoInList(stakeinput["txid"], stakeinput["vout"], self.nodes[0].listunspent())
@@ -34,6 +34,12 @@ class InvalidMessagesTest(PivxTestFramework):
         self.setup_clean_chain = True
 
     def run_test(self):
+        self.run_checks()
+        self.log.info("Frame the received messages on the recv threads")
+        self.restart_node(0, ["-netrecvthreads=2"])
+        self.run_checks()
+
+    def run_checks(self):
         self.test_magic_bytes()
         self.test_checksum()
         self.test_size()